@@ -31,114 +31,125 @@
 #include <cstdio>
 #include <cstring>
 #include <cstdint>
+#include <algorithm>
+#include <zlib.h>
 #include "Supermodel.h"
+#include "Util/DirtyPageMap.h"
 
 
 /******************************************************************************
  Output Functions
+
+ All block files are held in a memory buffer: files are read in whole when
+ loaded, and files created on disk are built in memory and written out when
+ closed.
 ******************************************************************************/
 
-void CBlockFile::ReadString(std::string *str, uint32_t length)
+size_t CBlockFile::RawRead(void *data, size_t numBytes)
 {
-  if (NULL == fp)
-    return;
-  str->clear();
-  //TODO: use fstream to get rid of this ugly hack
-  bool keep_loading = true;
-  for (uint32_t i = 0; i < length; i++)
-  {
-    char c;
-    fread(&c, sizeof(char), 1, fp);
-    if (keep_loading)
-    {
-      if (!c)
-        keep_loading = false;
-      else
-        *str += c;
-    }
-  }
+  numBytes = std::min(numBytes, Remaining());
+  if (numBytes > 0)
+    memcpy(data, &buffer[bufferPos], numBytes);
+  bufferPos += numBytes;
+  return numBytes;
 }
 
-unsigned CBlockFile::ReadBytes(void *data, uint32_t numBytes)
+void CBlockFile::RawWrite(const void *data, size_t numBytes)
 {
-  if (NULL == fp)
-    return 0;
-  return (uint32_t)fread(data, sizeof(uint8_t), numBytes, fp);
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  size_t overwrite = std::min(numBytes, Remaining());
+  if (overwrite > 0)
+    memcpy(&buffer[bufferPos], bytes, overwrite);
+  buffer.insert(buffer.end(), bytes + overwrite, bytes + numBytes);
+  bufferPos += numBytes;
 }
 
-unsigned CBlockFile::ReadDWord(uint32_t *data)
+size_t CBlockFile::Remaining(void) const
 {
-  if (NULL == fp)
-    return 0;
-  fread(data, sizeof(uint32_t), 1, fp);
-  return 4;
+  return buffer.size() - std::min(bufferPos, buffer.size());
 }
-  
+
+unsigned CBlockFile::ReadBytes(void *data, uint32_t numBytes)
+{
+  return (uint32_t)RawRead(data, numBytes);
+}
+
 void CBlockFile::UpdateBlockSize(void)
 {
-  long int  curPos;
-  unsigned  newBlockSize;
-  
-  if (NULL == fp)
-    return;
-  curPos = ftell(fp);       // save current file position
-  fseek(fp, blockStartPos, SEEK_SET);
-  newBlockSize = curPos - blockStartPos;
-  fwrite(&newBlockSize, sizeof(uint32_t), 1, fp);
-  fseek(fp, curPos, SEEK_SET);  // go back
+  uint32_t newBlockSize = uint32_t(bufferPos - blockStartPos);
+  memcpy(&buffer[blockStartPos], &newBlockSize, sizeof(uint32_t));
 }
 
 void CBlockFile::WriteByte(uint8_t data)
 {
-  if (NULL == fp)
-    return;
-  fwrite(&data, sizeof(uint8_t), 1, fp);
+  RawWrite(&data, sizeof(uint8_t));
   UpdateBlockSize();
 }
 
 void CBlockFile::WriteDWord(uint32_t data)
 {
-  if (NULL == fp)
-    return;
-  fwrite(&data, sizeof(uint32_t), 1, fp);
+  RawWrite(&data, sizeof(uint32_t));
   UpdateBlockSize();
 }
 
 void CBlockFile::WriteBytes(const void *data, uint32_t numBytes)
 {
-  if (NULL == fp)
-    return;
-  fwrite(data, sizeof(uint8_t), numBytes, fp);
+  RawWrite(data, numBytes);
   UpdateBlockSize();
 }
 
 void CBlockFile::WriteBlockHeader(const std::string &name, const std::string &comment)
 {
-  if (NULL == fp)
-    return;
-  
   // Record current block starting position
-  blockStartPos = ftell(fp);
+  blockStartPos = bufferPos;
 
   // Write the total block length field
   WriteDWord(0);  // will be automatically updated as we write the file
-  
+
   // Write name and comment lengths
   WriteDWord((uint32_t)name.size() + 1);
   WriteDWord((uint32_t)comment.size() + 1);
   Write(name);
   Write(comment);
-  
+
   // Record the start of the current data section
-  dataStartPos = ftell(fp);
-} 
+  dataStartPos = bufferPos;
+}
+
+void CBlockFile::BuildIndex(void)
+{
+  blockIndex.clear();
+  size_t pos = 0;
+  while (buffer.size() - pos >= 12)
+  {
+    uint32_t block_length;
+    uint32_t name_length;
+    uint32_t comment_length;
+    memcpy(&block_length, &buffer[pos + 0], sizeof(uint32_t));
+    memcpy(&name_length, &buffer[pos + 4], sizeof(uint32_t));
+    memcpy(&comment_length, &buffer[pos + 8], sizeof(uint32_t));
+
+    // The first block of a given name wins, as with a scan from the start
+    const char *name = reinterpret_cast<const char *>(&buffer[pos + 12]);
+    size_t name_size = std::min(size_t(name_length), buffer.size() - pos - 12);
+    BlockExtent extent = { pos, pos + 12 + size_t(name_length) + size_t(comment_length) };
+    blockIndex.emplace(std::string(name, strnlen(name, name_size)), extent);
+
+    // Move to next block
+    if (block_length == 0 || block_length > buffer.size() - pos)  // would never advance or is truncated
+      break;
+    pos += block_length;
+  }
+  indexBuilt = true;
+}
 
 
 /******************************************************************************
  Block Format Container File Implementation
- 
- Files are just a consecutive array of blocks that must be searched.
- 
+
+ Files are just a consecutive array of blocks. The first search of a file
+ indexes all of its blocks, so subsequent ones are a lookup.
+
  Block Format
  ------------
  blockLength  (uint32_t)  Total length of block in bytes.
@@ -171,12 +182,30 @@ unsigned CBlockFile::Read(bool& value)
     return Read(&value);        // turn reference into pointer for above function
 }
 
+const uint8_t *CBlockFile::ReadSpan(uint32_t numBytes)
+{
+  if (mode != 'r' || Remaining() < numBytes)
+    return nullptr;
+  const uint8_t *data = buffer.data() + bufferPos;
+  bufferPos += numBytes;
+  return data;
+}
+
 void CBlockFile::Write(const void *data, uint32_t numBytes)
 {
   if (mode == 'w')
     WriteBytes(data, numBytes);
 }
 
+void CBlockFile::Write(const void *data, uint32_t numBytes, Util::DirtyPageMap *dirty)
+{
+  if (mode != 'w')
+    return;
+  if (NULL == fp)
+    trackedRegions.push_back({ bufferPos, numBytes, dirty });
+  WriteBytes(data, numBytes);
+}
+
 void CBlockFile::Write(bool value)
 {
   uint8_t byte = value ? 1 : 0;
@@ -199,44 +228,24 @@ Result CBlockFile::FindBlock(const std::string &name)
 {
   if (mode != 'r')
     return Result::FAIL;
-    
-  fseek(fp, 0, SEEK_SET);
-  
-  long int  curPos = 0;
-  while (curPos < fileSize)
-  {
-    blockStartPos = curPos;
-    
-    // Read header
-    uint32_t block_length;
-    uint32_t name_length;
-    uint32_t comment_length;
-    curPos += ReadDWord(&block_length);
-    curPos += ReadDWord(&name_length);
-    curPos += ReadDWord(&comment_length);
-    std::string block_name;
-    ReadString(&block_name, name_length);
-    
-    // Is this the block we want?
-    if (block_name == name)
-    {
-      fseek(fp, blockStartPos + 12 + name_length + comment_length, SEEK_SET); // move to beginning of data
-      dataStartPos = ftell(fp);
-      return Result::OKAY;
-    }
-    
-    // Move to next block
-    fseek(fp, blockStartPos + block_length, SEEK_SET);
-    curPos = blockStartPos + block_length;
-    if (block_length == 0)  // this would never advance
-      break;
-  }
-  
-  return Result::FAIL;
+
+  if (!indexBuilt)
+    BuildIndex();
+
+  auto it = blockIndex.find(name);
+  if (it == blockIndex.end())
+    return Result::FAIL;
+
+  // Move to beginning of data
+  blockStartPos = it->second.blockStart;
+  dataStartPos = it->second.dataStart;
+  bufferPos = dataStartPos;
+  return Result::OKAY;
 }
 
 Result CBlockFile::Create(const std::string &file, const std::string &headerName, const std::string &comment)
 {
+  Close();
   fp = fopen(file.c_str(), "wb");
   if (NULL == fp)
     return Result::FAIL;
@@ -244,36 +253,169 @@ Result CBlockFile::Create(const std::string &file, const std::string &headerName
   WriteBlockHeader(headerName, comment);
   return Result::OKAY;
 }
-  
-Result CBlockFile::Load(const std::string &file)
+
+Result CBlockFile::CreateInMemory(const std::string &headerName, const std::string &comment, std::vector<uint8_t> storage)
 {
-  fp = fopen(file.c_str(), "rb");
+  Close();
+  buffer.swap(storage);
+  buffer.clear();
+  mode = 'w';
+  WriteBlockHeader(headerName, comment);
+  return Result::OKAY;
+}
+
+std::vector<uint8_t> CBlockFile::TakeBuffer(void)
+{
+  std::vector<uint8_t> contents;
   if (NULL == fp)
+    contents.swap(buffer);
+  Close();
+  return contents;
+}
+
+const std::vector<CBlockFile::TrackedRegion> &CBlockFile::GetTrackedRegions(void) const
+{
+  return trackedRegions;
+}
+
+Result CBlockFile::LoadFromMemory(std::vector<uint8_t> data)
+{
+  Close();
+  buffer.swap(data);
+  mode = 'r';
+  return Result::OKAY;
+}
+
+Result CBlockFile::WriteCompressed(const std::string &file, const std::vector<uint8_t> &data)
+{
+  // Fastest compression level: save states are mostly zero-filled memory and
+  // compress well regardless, and this keeps the writer from falling behind
+  std::string tempFile = file + ".tmp";
+  gzFile gz = gzopen(tempFile.c_str(), "wb1");
+  if (NULL == gz)
+    return Result::FAIL;
+  gzbuffer(gz, 256 * 1024);
+
+  bool ok = true;
+  const size_t chunkSize = 1 << 20;
+  for (size_t offset = 0; ok && offset < data.size(); offset += chunkSize)
+  {
+    unsigned len = unsigned(std::min(chunkSize, data.size() - offset));
+    ok = gzwrite(gz, &data[offset], len) == int(len);
+  }
+  ok = (gzclose(gz) == Z_OK) && ok;
+
+  if (ok)
+  {
+    remove(file.c_str()); // rename won't replace an existing file on Windows
+    ok = rename(tempFile.c_str(), file.c_str()) == 0;
+  }
+  if (!ok)
+  {
+    remove(tempFile.c_str());
+    return Result::FAIL;
+  }
+  return Result::OKAY;
+}
+
+Result CBlockFile::Inflate(const std::vector<uint8_t> &compressed)
+{
+  z_stream zs = {};
+  if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)  // gzip wrapper
     return Result::FAIL;
+  zs.next_in = const_cast<Bytef *>(compressed.data());
+  zs.avail_in = uInt(compressed.size());
+
+  // The gzip trailer ends with the uncompressed size (mod 4GB), a good first
+  // guess for the buffer size
+  size_t n = compressed.size();
+  size_t sizeHint = n >= 4 ? (size_t(compressed[n - 4]) | size_t(compressed[n - 3]) << 8 | size_t(compressed[n - 2]) << 16 | size_t(compressed[n - 1]) << 24) : 0;
+
+  // Inflate in chunks straight into the buffer
+  buffer.clear();
+  buffer.resize(std::max(sizeHint, size_t(1) << 20));
+  int status = Z_OK;
+  while (status == Z_OK)
+  {
+    if (zs.total_out == buffer.size())
+      buffer.resize(buffer.size() * 2);
+    zs.next_out = &buffer[zs.total_out];
+    zs.avail_out = uInt(std::min<size_t>(buffer.size() - zs.total_out, 1u << 30));
+    status = inflate(&zs, Z_NO_FLUSH);
+  }
+  buffer.resize(zs.total_out);
+  inflateEnd(&zs);
+  if (status != Z_STREAM_END) // also catches a truncated stream
+  {
+    buffer.clear();
+    return Result::FAIL;
+  }
+
+  mode = 'r';
+  return Result::OKAY;
+}
+
+Result CBlockFile::Load(const std::string &file)
+{
+  Close();
+  FILE *in = fopen(file.c_str(), "rb");
+  if (NULL == in)
+    return Result::FAIL;
+
+  // Read the whole file in
+  fseek(in, 0, SEEK_END);
+  long size = ftell(in);
+  fseek(in, 0, SEEK_SET);
+  buffer.resize(size_t(std::max(size, 0L)));
+  bool ok = buffer.empty() || fread(buffer.data(), buffer.size(), 1, in) == 1;
+  fclose(in);
+  if (!ok)
+  {
+    Close();
+    return Result::FAIL;
+  }
+
+  // Compressed files start with the gzip magic number, which can't be the
+  // length field of a header block
+  if (buffer.size() >= 2 && buffer[0] == 0x1f && buffer[1] == 0x8b)
+  {
+    std::vector<uint8_t> compressed;
+    compressed.swap(buffer);
+    return Inflate(compressed);
+  }
   mode = 'r';
   
   // TODO: is this a valid block file?
   
-  // Get the file size
-  fseek(fp, 0, SEEK_END);
-  fileSize = ftell(fp);
-  fseek(fp, 0, SEEK_SET);
-  
   return Result::OKAY;
 }
   
 void CBlockFile::Close(void)
 {
+  // Files created on disk are written out now
   if (fp != nullptr)
+  {
+    if (mode == 'w' && !buffer.empty())
+      fwrite(buffer.data(), buffer.size(), 1, fp);
     fclose(fp);
+  }
   fp = nullptr;
+  buffer.clear();
+  buffer.shrink_to_fit();
+  bufferPos = 0;
+  trackedRegions.clear();
+  blockIndex.clear();
+  indexBuilt = false;
   mode = 0;
+  blockStartPos = 0;
+  dataStartPos = 0;
 }
 
 CBlockFile::CBlockFile(void) :
     fp(nullptr),
+    bufferPos(0),
+    indexBuilt(false),
     mode(0),
-    fileSize(0),
     blockStartPos(0),
     dataStartPos(0)
 {
@@ -281,8 +423,5 @@ CBlockFile::CBlockFile(void) :
 
 CBlockFile::~CBlockFile(void)
 {
-  if (fp != nullptr) // in case user forgot
-    fclose(fp);
-  fp = nullptr;
-  mode = 0;
+  Close(); // in case user forgot
 }
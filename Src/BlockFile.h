@@ -29,9 +29,17 @@
 #define INCLUDED_BLOCKFILE_H
 
 #include <cstdint>
+#include <cstdio>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "Types.h"
 
+namespace Util
+{
+  class DirtyPageMap;
+}
+
 /*
  * CBlockFile:
  *
@@ -41,6 +49,15 @@
  * All strings (comments and names) will be truncated to 1024 bytes, not
  * including the null terminator.
  *
+ * Block files are always held in memory. Files are read in whole by Load()
+ * and blocks are located through an index built on the first FindBlock(), so
+ * reading the blocks of a file in any order costs one pass over it. Files
+ * opened with Create() are written out when closed.
+ *
+ * A block file can also be built in memory and written out later, optionally
+ * gzip compressed. Compressed files are recognized by Load() and inflated
+ * into memory.
+ *
  * Members do not generate any output messages.
  */
 class CBlockFile
@@ -103,6 +120,20 @@ public:
   {
       return Read(static_cast<void*>(&value), static_cast<uint32_t>(sizeof(value)));
   }
+
+  /*
+   * ReadSpan(numBytes):
+   *
+   * Reads data from the current file position without copying it.
+   *
+   * Parameters:
+   *    numBytes  Number of bytes to read.
+   *
+   * Returns:
+   *    Pointer to the data inside the file, valid until the file is closed,
+   *    or NULL (and nothing is read) if fewer than numBytes remain.
+   */
+  const uint8_t *ReadSpan(uint32_t numBytes);
   
   /*
    * FindBlock(name):
@@ -141,6 +172,21 @@ public:
    */
   void Write(const void *data, uint32_t numBytes);
 
+  /*
+   * Write(data, numBytes, dirty):
+   *
+   * Same as Write(data, numBytes) for a memory region whose writes are
+   * tracked page by page. In-memory block files also record where the region
+   * was placed (see GetTrackedRegions()), so that consecutive snapshots only
+   * need to be compared where pages were written.
+   *
+   * Parameters:
+   *    data      Memory region to write.
+   *    numBytes  Size of region. Must match the size of the dirty page map.
+   *    dirty     Dirty page map of the region.
+   */
+  void Write(const void *data, uint32_t numBytes, Util::DirtyPageMap *dirty);
+
   /*
    * Write(str):
    *
@@ -186,7 +232,7 @@ public:
    * Opens a block file for writing and creates the header block. This  
    * function must be called before attempting to write data. Otherwise, all
    * write commands will be silently ignored. Read commands will be ignored
-   * and will always return 0's.
+   * and will always return 0's. The file is written out by Close().
    * 
    * Parameters:
    *    file        File path.
@@ -198,10 +244,78 @@ public:
    */
   Result Create(const std::string &file, const std::string &headerName, const std::string &comment);
 
+  /*
+   * CreateInMemory(headerName, comment):
+   *
+   * Same as Create() but the block file is built in a memory buffer, which
+   * is retrieved with TakeBuffer() instead of being written to disk.
+   *
+   * Parameters:
+   *    headerName  Block name for header. Must be unique and not NULL.
+   *    comment     Comment string that will be embedded into file header.
+   *    storage     Optional buffer to build the file in. Its capacity is
+   *                reused, which avoids reallocation for repeated snapshots.
+   *
+   * Returns:
+   *    Always OKAY.
+   */
+  Result CreateInMemory(const std::string &headerName, const std::string &comment, std::vector<uint8_t> storage = std::vector<uint8_t>());
+
+  /*
+   * TakeBuffer(void):
+   *
+   * Closes a block file held in memory (created with CreateInMemory() or
+   * opened with LoadFromMemory()) and hands over its contents.
+   *
+   * Returns:
+   *    The complete block file. Empty if the file was not held in memory.
+   */
+  std::vector<uint8_t> TakeBuffer(void);
+
+  /*
+   * TrackedRegion:
+   *
+   * Placement of a region written with Write(data, numBytes, dirty) in an
+   * in-memory block file.
+   */
+  struct TrackedRegion
+  {
+    size_t offset;                // offset of the region in the buffer
+    size_t size;
+    Util::DirtyPageMap *dirty;
+  };
+
+  /*
+   * GetTrackedRegions(void):
+   *
+   * Returns:
+   *    The tracked regions written so far, in order. Always empty for block
+   *    files on disk.
+   */
+  const std::vector<TrackedRegion> &GetTrackedRegions(void) const;
+
+  /*
+   * WriteCompressed(file, data):
+   *
+   * Writes a block file held in memory to disk in gzip format. The data is
+   * written to a temporary file that replaces the destination only once it
+   * is complete, so an existing file is never left truncated. Safe to call
+   * from any thread.
+   *
+   * Parameters:
+   *    file  File path.
+   *    data  Block file contents, as returned by TakeBuffer().
+   *
+   * Returns:
+   *    OKAY if successfully written, otherwise FAIL.
+   */
+  static Result WriteCompressed(const std::string &file, const std::vector<uint8_t> &data);
+
   /*
    * Load(file):
    *
-   * Open a block file file for reading.
+   * Reads a block file into memory. Files written by WriteCompressed() are
+   * decompressed as they are read.
    *
    * Parameters:
    *    file  File path.
@@ -214,10 +328,24 @@ public:
    */
   Result Load(const std::string &file);
 
+  /*
+   * LoadFromMemory(data):
+   *
+   * Opens a block file held in memory for reading, taking ownership of the
+   * buffer until TakeBuffer() or Close() is called.
+   *
+   * Parameters:
+   *    data  Block file contents.
+   *
+   * Returns:
+   *    Always OKAY.
+   */
+  Result LoadFromMemory(std::vector<uint8_t> data);
+
   /*
    * Close(void):
    *
-   * Closes the file.
+   * Closes the file. Files opened with Create() are written out.
    */
   void Close(void);
 
@@ -232,21 +360,35 @@ public:
 
 private:
   // Helper functions
-  void      ReadString(std::string *str, uint32_t length);
+  size_t    RawRead(void *data, size_t numBytes);
+  void      RawWrite(const void *data, size_t numBytes);
+  size_t    Remaining(void) const;
+  Result    Inflate(const std::vector<uint8_t> &compressed);
+  void      BuildIndex(void);
   unsigned  ReadBytes(void *data, uint32_t numBytes);
-  unsigned  ReadDWord(uint32_t *data);
   void      UpdateBlockSize(void);
   void      WriteByte(uint8_t data);
   void      WriteDWord(uint32_t data);
   void      WriteBytes(const void *data, uint32_t numBytes);
   void      WriteBlockHeader(const std::string &name, const std::string &comment);
 
+  // Location of a block found by BuildIndex()
+  struct BlockExtent
+  {
+    size_t  blockStart;     // block header
+    size_t  dataStart;      // data section
+  };
+
   // File state data
-  FILE      *fp;
+  FILE      *fp;            // file being created, written out on Close()
+  std::vector<uint8_t> buffer;  // file contents
+  size_t    bufferPos;
+  std::vector<TrackedRegion> trackedRegions;
+  std::unordered_map<std::string, BlockExtent> blockIndex;
+  bool      indexBuilt;     // blockIndex is valid (built by first FindBlock())
   int       mode;           // 'r' for read, 'w' for write
-  long int  fileSize;       // size of file in bytes
-  long int  blockStartPos;  // points to beginning of current block (or file) header
-  long int  dataStartPos;   // points to beginning of current block's data section 
+  size_t    blockStartPos;  // points to beginning of current block (or file) header
+  size_t    dataStartPos;   // points to beginning of current block's data section 
 };
 
 
@@ -0,0 +1,201 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+ 
+/*
+ * PPCProfiler.cpp
+ * 
+ * PowerPC hot-spot profiler.
+ */
+
+#ifdef SUPERMODEL_PROFILER
+
+#include "PPCProfiler.h"
+#include <algorithm>
+#include <cstring>
+#ifdef SUPERMODEL_DEBUGGER
+#include "Debugger/CPUDebug.h"
+#include "Debugger/CodeAnalyser.h"
+#include "Debugger/Label.h"
+#endif // SUPERMODEL_DEBUGGER
+
+// Number of blocks listed in the report
+static const size_t NUM_REPORTED_BLOCKS = 50;
+
+void CPPCProfiler::Sample(UINT32 pc)
+{
+	Block &block = m_blocks[m_blockStart];
+	block.end = std::max(block.end, pc);
+	block.samples++;
+	m_totalSamples++;
+	m_countdown = m_interval;
+}
+
+#ifdef SUPERMODEL_DEBUGGER
+
+/*
+ * Names a code address after a custom label or an auto-label at or before it
+ * (with an offset), preferring the closest. The auto-labels come from the
+ * debugger's code analysis, which is brought up to date first.
+ */
+static void FormatLocation(char *str, size_t strSize, UINT32 addr, Debugger::CCPUDebug *cpu)
+{
+	str[0] = '\0';
+	if (cpu == NULL)
+		return;
+
+	char name[MAX_LABEL_LENGTH + 1] = "";
+	char autoName[MAX_LABEL_LENGTH + 1];
+	UINT32 nameAddr = 0;
+
+	for (Debugger::CLabel *label : cpu->labels)
+	{
+		if (label->addr <= addr && (name[0] == '\0' || label->addr > nameAddr))
+		{
+			snprintf(name, sizeof(name), "%s", label->name);
+			nameAddr = label->addr;
+		}
+	}
+
+	Debugger::CCodeAnalysis *analysis = cpu->GetCodeAnalyser()->analysis;
+	for (Debugger::CAutoLabel *autoLabel : analysis->autoLabels)
+	{
+		if (autoLabel->addr > addr)
+			break;
+		if (name[0] != '\0' && autoLabel->addr <= nameAddr)
+			continue;
+		if (autoLabel->GetLabel(autoName, (Debugger::ELabelFlags)(Debugger::LFSubroutine | Debugger::LFEntryPoint | Debugger::LFExcepHandler | Debugger::LFInterHandler)) ||
+			(autoLabel->addr == addr && autoLabel->GetLabel(autoName)))
+		{
+			strcpy(name, autoName);
+			nameAddr = autoLabel->addr;
+		}
+	}
+
+	if (name[0] == '\0')
+		return;
+	if (nameAddr == addr)
+		snprintf(str, strSize, "%s", name);
+	else
+		snprintf(str, strSize, "%s+%X", name, addr - nameAddr);
+
+	Debugger::CAutoLabel *autoLabel = analysis->GetAutoLabel(addr);
+	if (autoLabel != NULL && (autoLabel->flags & Debugger::LFLoopPoint))
+		strncat(str, " (loop)", strSize - strlen(str) - 1);
+}
+
+static const char *GetRegionName(UINT32 addr, Debugger::CCPUDebug *cpu)
+{
+	if (cpu == NULL)
+		return NULL;
+	Debugger::CRegion *region = cpu->GetRegion(addr);
+	return region != NULL ? region->name : NULL;
+}
+
+#else
+
+static void FormatLocation(char *str, size_t strSize, UINT32 addr, Debugger::CCPUDebug *cpu)
+{
+	str[0] = '\0';
+}
+
+static const char *GetRegionName(UINT32 addr, Debugger::CCPUDebug *cpu)
+{
+	return NULL;
+}
+
+#endif // SUPERMODEL_DEBUGGER
+
+void CPPCProfiler::Report(FILE *fp, Debugger::CCPUDebug *cpu)
+{
+#ifdef SUPERMODEL_DEBUGGER
+	if (cpu != NULL && cpu->GetCodeAnalyser()->NeedsAnalysis())
+		cpu->GetCodeAnalyser()->AnalyseCode();
+#endif // SUPERMODEL_DEBUGGER
+
+	fprintf(fp, "PowerPC profile: %llu samples, 1 every %u instructions\n\n", (unsigned long long) m_totalSamples, m_interval);
+	if (m_totalSamples == 0)
+		return;
+
+	// Hottest blocks
+	std::vector<std::pair<UINT32, Block>> blocks(m_blocks.begin(), m_blocks.end());
+	std::sort(blocks.begin(), blocks.end(),
+		[](const std::pair<UINT32, Block> &a, const std::pair<UINT32, Block> &b) { return a.second.samples > b.second.samples; });
+	fprintf(fp, "  Samples      %%  Cumul.%%  Start     End       Location\n");
+	UINT64 cumulative = 0;
+	char location[512];
+	for (size_t i = 0; i < std::min(blocks.size(), NUM_REPORTED_BLOCKS); i++)
+	{
+		const Block &block = blocks[i].second;
+		cumulative += block.samples;
+		FormatLocation(location, sizeof(location), blocks[i].first, cpu);
+		fprintf(fp, "%9llu %5.1f%%  %5.1f%%   %08X  %08X  %s\n", (unsigned long long) block.samples,
+			100.0 * double(block.samples) / double(m_totalSamples), 100.0 * double(cumulative) / double(m_totalSamples),
+			blocks[i].first, block.end, location);
+	}
+	if (blocks.size() > NUM_REPORTED_BLOCKS)
+		fprintf(fp, "  (%u more blocks)\n", unsigned(blocks.size() - NUM_REPORTED_BLOCKS));
+
+	// Bus accesses, with pages merged into regions (or runs of pages if no
+	// regions are known)
+	struct Range
+	{
+		UINT32 start;
+		UINT32 end;
+		const char *name;
+		UINT64 reads;
+		UINT64 writes;
+	};
+	std::vector<Range> ranges;
+	for (UINT32 page = 0; page < m_reads.size(); page++)
+	{
+		if (m_reads[page] == 0 && m_writes[page] == 0)
+			continue;
+		UINT32 start = page << 16;
+		const char *name = GetRegionName(start, cpu);
+		bool merge = !ranges.empty() &&
+			(name != NULL ? ranges.back().name == name : (ranges.back().name == NULL && ranges.back().end + 1 == start));
+		if (!merge)
+			ranges.push_back({ start, 0, name, 0, 0 });
+		ranges.back().end = start + 0xFFFF;
+		ranges.back().reads += m_reads[page];
+		ranges.back().writes += m_writes[page];
+	}
+	std::sort(ranges.begin(), ranges.end(),
+		[](const Range &a, const Range &b) { return a.reads + a.writes > b.reads + b.writes; });
+	fprintf(fp, "\n        Reads       Writes  Range              Region\n");
+	for (const Range &range : ranges)
+	{
+		fprintf(fp, "%13llu %12llu  %08X-%08X  %s\n", (unsigned long long) range.reads, (unsigned long long) range.writes,
+			range.start, range.end, range.name != NULL ? range.name : "");
+	}
+}
+
+CPPCProfiler::CPPCProfiler(unsigned interval)
+	: m_blockStart(0),
+	  m_interval(std::max(interval, 1u)),
+	  m_countdown(m_interval),
+	  m_totalSamples(0),
+	  m_reads(0x10000),
+	  m_writes(0x10000)
+{
+}
+
+#endif	// SUPERMODEL_PROFILER
@@ -0,0 +1,118 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+ 
+/*
+ * PPCProfiler.h
+ * 
+ * Header file for the PowerPC hot-spot profiler. Only built when
+ * SUPERMODEL_PROFILER is defined.
+ */
+
+#ifdef SUPERMODEL_PROFILER
+#ifndef INCLUDED_PPCPROFILER_H
+#define INCLUDED_PPCPROFILER_H
+
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include "Types.h"
+
+namespace Debugger
+{
+	class CCPUDebug;
+}
+
+/*
+ * CPPCProfiler:
+ *
+ * Samples the PowerPC program counter every so many instructions and
+ * attributes each sample to the basic block it falls in, identified by the
+ * target of the last taken branch (or exception). Bus accesses made by the
+ * PowerPC are counted per 64KB page. The interval should not be a multiple of
+ * common loop lengths (a prime works well) so that samples don't alias.
+ */
+class CPPCProfiler
+{
+public:
+	/*
+	 * Step(prevPC, pc):
+	 *
+	 * Called by the interpreter before each instruction.
+	 *
+	 * Parameters:
+	 *		prevPC	Address of the previously executed instruction.
+	 *		pc		Address of the instruction about to be executed.
+	 */
+	inline void Step(UINT32 prevPC, UINT32 pc)
+	{
+		if (pc != prevPC + 4)
+			m_blockStart = pc;
+		if (--m_countdown == 0)
+			Sample(pc);
+	}
+
+	inline void CountRead(UINT32 addr)
+	{
+		m_reads[addr >> 16]++;
+	}
+
+	inline void CountWrite(UINT32 addr)
+	{
+		m_writes[addr >> 16]++;
+	}
+
+	/*
+	 * Report(fp, cpu):
+	 *
+	 * Writes the hottest blocks and the bus accesses per region, most frequent
+	 * first.
+	 *
+	 * Parameters:
+	 *		fp		File to write to.
+	 *		cpu		Debugger view of the PowerPC used to name code locations
+	 *				and memory regions. May be NULL (and is ignored unless
+	 *				SUPERMODEL_DEBUGGER is defined), in which case plain
+	 *				addresses are printed.
+	 */
+	void Report(FILE *fp, Debugger::CCPUDebug *cpu);
+
+	CPPCProfiler(unsigned interval);
+
+private:
+	struct Block
+	{
+		UINT32 end;
+		UINT64 samples;
+	};
+
+	std::unordered_map<UINT32, Block> m_blocks;	// keyed by start address
+	UINT32 m_blockStart;
+	unsigned m_interval;
+	unsigned m_countdown;
+	UINT64 m_totalSamples;
+	std::vector<UINT64> m_reads;	// per 64KB page
+	std::vector<UINT64> m_writes;
+
+	void Sample(UINT32 pc);
+};
+
+#endif	// INCLUDED_PPCPROFILER_H
+#endif	// SUPERMODEL_PROFILER
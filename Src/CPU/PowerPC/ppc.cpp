@@ -33,6 +33,7 @@
 #include <cstring>	// memset()
 #include "Supermodel.h"
 #include "CPU/Bus.h"
+#include "CPU/PowerPC/PPCProfiler.h"
 
 // Typedefs that Supermodel no longer provides
 typedef unsigned int	UINT;
@@ -45,6 +46,11 @@ static class IBus	*Bus = NULL;	// pointer to Model 3 bus object (for access hand
 static class Debugger::CPPCDebug *PPCDebug = NULL;
 #endif
 
+#ifdef SUPERMODEL_PROFILER
+// Pointer to profiler (if profiling)
+static class CPPCProfiler *PPCProfiler = NULL;
+#endif
+
 void ppc603_exception(int exception);
 static void ppc603_check_interrupts(void);
 
@@ -319,41 +325,73 @@ static void ppc_change_pc(UINT32 newpc)
 
 static inline UINT8 READ8(UINT32 address)
 {
+#ifdef SUPERMODEL_PROFILER
+	if (PPCProfiler != NULL)
+		PPCProfiler->CountRead(address);
+#endif
 	return Bus->Read8(address);
 }
 
 static inline UINT16 READ16(UINT32 address)
 {
+#ifdef SUPERMODEL_PROFILER
+	if (PPCProfiler != NULL)
+		PPCProfiler->CountRead(address);
+#endif
 	return Bus->Read16(address);
 }
 
 static inline UINT32 READ32(UINT32 address)
 {
+#ifdef SUPERMODEL_PROFILER
+	if (PPCProfiler != NULL)
+		PPCProfiler->CountRead(address);
+#endif
 	return Bus->Read32(address);
 }
 
 static inline UINT64 READ64(UINT32 address)
 {
+#ifdef SUPERMODEL_PROFILER
+	if (PPCProfiler != NULL)
+		PPCProfiler->CountRead(address);
+#endif
 	return Bus->Read64(address);
 }
 
 static inline void WRITE8(UINT32 address, UINT8 data)
 {
+#ifdef SUPERMODEL_PROFILER
+	if (PPCProfiler != NULL)
+		PPCProfiler->CountWrite(address);
+#endif
 	Bus->Write8(address,data);
 }
 
 static inline void WRITE16(UINT32 address, UINT16 data)
 {
+#ifdef SUPERMODEL_PROFILER
+	if (PPCProfiler != NULL)
+		PPCProfiler->CountWrite(address);
+#endif
 	Bus->Write16(address,data);
 }
 
 static inline void WRITE32(UINT32 address, UINT32 data)
 {
+#ifdef SUPERMODEL_PROFILER
+	if (PPCProfiler != NULL)
+		PPCProfiler->CountWrite(address);
+#endif
 	Bus->Write32(address,data);
 }
 
 static inline void WRITE64(UINT32 address, UINT64 data)
 {
+#ifdef SUPERMODEL_PROFILER
+	if (PPCProfiler != NULL)
+		PPCProfiler->CountWrite(address);
+#endif
 	Bus->Write64(address,data);
 }
 
@@ -1120,6 +1158,17 @@ void ppc_break()
 }
 #endif // SUPERMODEL_DEBUGGER
 
+/******************************************************************************
+ Profiler Interface
+******************************************************************************/
+
+#ifdef SUPERMODEL_PROFILER
+void ppc_attach_profiler(CPPCProfiler *PPCProfilerPtr)
+{
+	PPCProfiler = PPCProfilerPtr;
+}
+#endif // SUPERMODEL_PROFILER
+
 void ppc_set_pc(UINT32 pc)
 {
 	ppc.pc = pc;
@@ -377,6 +377,10 @@ extern void ppc_attach_debugger(class Debugger::CPPCDebug *PPCDebugPtr);
 extern void ppc_detach_debugger();
 #endif  // SUPERMODEL_DEBUGGER
 extern void ppc_break();
+#ifdef SUPERMODEL_PROFILER
+// Hot-spot profiling (pass NULL to stop)
+extern void ppc_attach_profiler(class CPPCProfiler *PPCProfilerPtr);
+#endif  // SUPERMODEL_PROFILER
 extern void ppc_set_pc(UINT32 pc);
 extern UINT8 ppc_get_cr(unsigned num);
 extern void ppc_set_cr(unsigned num, UINT8 val);
@@ -284,6 +284,11 @@ int ppc_execute(int cycles)
 
 	while( ppc.icount > 0 && !ppc.fatalError)
 	{
+#ifdef SUPERMODEL_PROFILER
+		if (PPCProfiler != NULL)
+			PPCProfiler->Step(ppc.pc, ppc.npc);
+#endif // SUPERMODEL_PROFILER
+
 		ppc.pc = ppc.npc;
 		
 		// Debug breakpoints
@@ -683,7 +683,7 @@ namespace Debugger
 		}
 
 		// Load Model3 state
-		m_model3->LoadState(&state);
+		m_model3->LoadState(&state, false);
 		state.Close();
 
 		// Reset debugger
@@ -4,40 +4,153 @@
 #include "Util/ConfigBuilders.h"
 #include "Util/ByteSwap.h"
 #include "Util/Format.h"
+#include "Util/CRC32.h"
+#include <zlib.h>
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <thread>
+
+static uint16_t Read16(const uint8_t *p)
+{
+  return uint16_t(p[0] | (p[1] << 8));
+}
+
+static uint32_t Read32(const uint8_t *p)
+{
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static uint64_t Read64(const uint8_t *p)
+{
+  return uint64_t(Read32(p)) | (uint64_t(Read32(p + 4)) << 32);
+}
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Finds the central directory of a zip archive. Returns true on error.
+static bool LocateCentralDirectory(uint64_t *offset, uint64_t *num_entries, const uint8_t *data, size_t size)
+{
+  // End of central directory record is last, followed only by a comment of up to 64KB
+  const size_t eocd_size = 22;
+  if (size < eocd_size)
+    return true;
+  size_t lowest = size - std::min<size_t>(size, eocd_size + 0xffff);
+  size_t eocd = size;
+  for (size_t pos = size - eocd_size + 1; pos-- > lowest; )
+  {
+    if (Read32(&data[pos]) == 0x06054b50)
+    {
+      eocd = pos;
+      break;
+    }
+  }
+  if (eocd == size)
+    return true;
+  *num_entries = Read16(&data[eocd + 10]);
+  *offset = Read32(&data[eocd + 16]);
+
+  // Zip64 archives keep the real values in another record, pointed to by a locator just before
+  if (*offset == 0xffffffff || *num_entries == 0xffff)
+  {
+    if (eocd < 20 || Read32(&data[eocd - 20]) != 0x07064b50)
+      return true;
+    uint64_t eocd64 = Read64(&data[eocd - 20 + 8]);
+    if (size < 56 || eocd64 > size - 56 || Read32(&data[eocd64]) != 0x06064b50)
+      return true;
+    *num_entries = Read64(&data[eocd64 + 32]);
+    *offset = Read64(&data[eocd64 + 48]);
+  }
+  return *offset > size;
+}
 
 bool GameLoader::LoadZipArchive(ZipArchive *zip, const std::string &zipfilename) const
 {
-  unzFile zf = unzOpen(zipfilename.c_str());
-  if (NULL == zf)
+  auto archive = std::make_shared<Util::MappedFile>();
+  if (!archive->Open(zipfilename))
   {
     ErrorLog("Could not open '%s'.", zipfilename.c_str());
     return true;
   }
   zip->zipfilenames.push_back(zipfilename);
-  zip->zfs.push_back(zf);
 
-  // Identify all files in zip archive
-  int err;
-  for (err = unzGoToFirstFile(zf); err == UNZ_OK; err = unzGoToNextFile(zf))
+  // Identify all files in zip archive by walking the central directory in place
+  const uint8_t *data = archive->Data();
+  size_t size = archive->Size();
+  uint64_t pos = 0;
+  uint64_t num_entries = 0;
+  bool error = LocateCentralDirectory(&pos, &num_entries, data, size);
+  for (uint64_t i = 0; i < num_entries && !error; i++)
   {
-    unz_file_info file_info;
-    char filename_buffer[256];
-    if (UNZ_OK != unzGetCurrentFileInfo(zf, &file_info, filename_buffer, sizeof(filename_buffer), NULL, 0, NULL, 0))
-      continue;
-    zip->files_by_crc[file_info.crc].zf = zf;
-    zip->files_by_crc[file_info.crc].zipfilename = filename_buffer;
-    zip->files_by_crc[file_info.crc].filename = filename_buffer;
-    zip->files_by_crc[file_info.crc].uncompressed_size = file_info.uncompressed_size;
-    zip->files_by_crc[file_info.crc].crc32 = file_info.crc;
+    const size_t header_size = 46;
+    if (pos + header_size > size || Read32(&data[pos]) != 0x02014b50)
+    {
+      error = true;
+      break;
+    }
+    const uint8_t *header = &data[pos];
+    uint16_t name_length = Read16(&header[28]);
+    uint16_t extra_length = Read16(&header[30]);
+    uint16_t comment_length = Read16(&header[32]);
+    if (pos + header_size + name_length + extra_length + comment_length > size)
+    {
+      error = true;
+      break;
+    }
+
+    uint64_t uncompressed_size = Read32(&header[24]);
+    uint64_t compressed_size = Read32(&header[20]);
+    uint64_t local_header_offset = Read32(&header[42]);
+
+    // Sizes and offset that don't fit are in the zip64 extra field, in this order
+    const uint8_t *extra = &header[header_size + name_length];
+    for (size_t e = 0; e + 4 <= extra_length; )
+    {
+      uint16_t id = Read16(&extra[e]);
+      uint16_t length = Read16(&extra[e + 2]);
+      if (id == 0x0001)
+      {
+        size_t field = e + 4;
+        size_t end = std::min<size_t>(field + length, extra_length);
+        for (uint64_t *value: { &uncompressed_size, &compressed_size, &local_header_offset })
+        {
+          if (*value == 0xffffffff && field + 8 <= end)
+          {
+            *value = Read64(&extra[field]);
+            field += 8;
+          }
+        }
+      }
+      e += 4 + length;
+    }
+
+    pos += header_size + name_length + extra_length + comment_length;
+    if (uncompressed_size > 0xffffffff || compressed_size > 0xffffffff)
+      continue; // far larger than any ROM
+
+    uint32_t crc = Read32(&header[16]);
+    ZippedFile &zipped_file = zip->files_by_crc[crc];
+    zipped_file.archive = archive;
+    zipped_file.zipfilename = zipfilename;
+    zipped_file.filename.assign(reinterpret_cast<const char *>(&header[header_size]), name_length);
+    zipped_file.uncompressed_size = uint32_t(uncompressed_size);
+    zipped_file.compressed_size = uint32_t(compressed_size);
+    zipped_file.crc32 = crc;
+    zipped_file.local_header_offset = local_header_offset;
+    zipped_file.method = Read16(&header[10]);
+    zipped_file.flags = Read16(&header[8]);
   }
 
-  if (err != UNZ_END_OF_LIST_OF_FILE)
+  if (error)
   {
-    ErrorLog("Unable to read the contents of '%s' (code 0x%x).", zipfilename.c_str(), err);
+    ErrorLog("Unable to read the contents of '%s'. Is zip file corrupt?", zipfilename.c_str());
     return true;
   }
   InfoLog("Opened %s.", zipfilename.c_str());
@@ -68,7 +181,7 @@ const GameLoader::ZippedFile *GameLoader::LookupFile(const File::ptr_t &file, co
     auto it = zip.files_by_crc.find(file->crc32);
     if (it == zip.files_by_crc.end())
     {
-      if (zip.zfs.size() == 1)
+      if (zip.zipfilenames.size() == 1)
         ErrorLog("'%s' with CRC32 0x%08x not found in '%s'.", file->filename.c_str(), file->crc32, zip.zipfilenames[0].c_str());
       else
         ErrorLog("'%s' with CRC32 0x%08x not found in '%s'.", file->filename.c_str(), file->crc32, Util::Format("', '").Join(zip.zipfilenames).str().c_str());
@@ -83,44 +196,150 @@ const GameLoader::ZippedFile *GameLoader::LookupFile(const File::ptr_t &file, co
     if (Util::ToLower(v.second.filename) == file->filename)
       return &v.second;
   }
-  if (zip.zfs.size() == 1)
+  if (zip.zipfilenames.size() == 1)
     ErrorLog("'%s' not found in '%s'.", file->filename.c_str(), zip.zipfilenames[0].c_str());
   else
     ErrorLog("'%s' not found in '%s'.", file->filename.c_str(), Util::Format("', '").Join(zip.zipfilenames).str().c_str());
   return nullptr;
 }
 
-bool GameLoader::LoadZippedFile(std::shared_ptr<uint8_t> *buffer, uint32_t *file_size, const GameLoader::File::ptr_t &file, const ZipArchive &zip) const
+class GameLoader::ZippedFileReader
 {
-  // Locate file
-  const ZippedFile *zipped_file = LookupFile(file, zip);
-  if (!zipped_file)
-    return true;
-  if (UNZ_OK != unzLocateFile(zipped_file->zf, zipped_file->filename.c_str(), 2))
+public:
+  ZippedFileReader(const ZippedFile &zipped_file)
+    : m_zipped_file(zipped_file)
   {
-    ErrorLog("Unable to locate '%s' in '%s'. Is zip file corrupt?", zipped_file->filename.c_str(), zipped_file->zipfilename.c_str());
-    return true;
+    memset(&m_stream, 0, sizeof(m_stream));
   }
 
-  // Read it in
-  if (UNZ_OK != unzOpenCurrentFile(zipped_file->zf))
+  ~ZippedFileReader()
   {
-    ErrorLog("Unable to read '%s' from '%s'. Is zip file corrupt?", zipped_file->filename.c_str(), zipped_file->zipfilename.c_str());
-    return true;
+    if (m_inflating)
+      inflateEnd(&m_stream);
   }
-  *file_size = zipped_file->uncompressed_size;
-  buffer->reset(new uint8_t[*file_size], std::default_delete<uint8_t[]>());
-  auto bytes_read = unzReadCurrentFile(zipped_file->zf, buffer->get(), *file_size);
-  if (bytes_read != *file_size)
+
+  // Returns true on error
+  bool Open()
   {
-    ErrorLog("Unable to read '%s' from '%s'. Is zip file corrupt?", zipped_file->filename.c_str(), zipped_file->zipfilename.c_str());
-    unzCloseCurrentFile(zipped_file->zf);
-    return true;
+    const Util::MappedFile &archive = *m_zipped_file.archive;
+    const size_t header_size = 30;
+    uint64_t offset = m_zipped_file.local_header_offset;
+    if (offset + header_size > archive.Size() || Read32(archive.Data() + offset) != 0x04034b50)
+      return true;
+    const uint8_t *header = archive.Data() + offset;
+    offset += header_size + Read16(&header[26]) + Read16(&header[28]);
+    if (offset + m_zipped_file.compressed_size > archive.Size())
+      return true;
+    if (m_zipped_file.flags & 1)  // encrypted
+      return true;
+    m_data = archive.Data() + offset;
+
+    switch (m_zipped_file.method)
+    {
+    case 0: // stored
+      return m_zipped_file.compressed_size != m_zipped_file.uncompressed_size;
+    case Z_DEFLATED:
+      m_stream.next_in = const_cast<Bytef *>(m_data);
+      m_stream.avail_in = m_zipped_file.compressed_size;
+      m_inflating = inflateInit2(&m_stream, -MAX_WBITS) == Z_OK;
+      return !m_inflating;
+    default:
+      return true;
+    }
   }
 
-  // And close it
-  if (UNZ_CRCERROR == unzCloseCurrentFile(zipped_file->zf))
+  // Reads the next len bytes of the file. Returns true on error.
+  bool Read(uint8_t *dest, uint32_t len)
+  {
+    if (len > m_zipped_file.uncompressed_size - m_position)
+      return true;
+    if (m_inflating)
+    {
+      m_stream.next_out = dest;
+      m_stream.avail_out = len;
+      while (m_stream.avail_out > 0)
+      {
+        int ret = inflate(&m_stream, Z_NO_FLUSH);
+        if (ret != Z_OK && !(ret == Z_STREAM_END && m_stream.avail_out == 0))
+          return true;
+      }
+    }
+    else
+      memcpy(dest, m_data + m_position, len);
+    m_position += len;
+    m_crc = Util::CRC32(m_crc, dest, len);
+    return false;
+  }
+
+  // CRC of everything read so far
+  uint32_t CRC() const
+  {
+    return m_crc;
+  }
+
+private:
+  const ZippedFile &m_zipped_file;
+  const uint8_t *m_data = nullptr;
+  z_stream m_stream;
+  bool m_inflating = false;
+  uint32_t m_position = 0;
+  uint32_t m_crc = 0;
+};
+
+bool GameLoader::LoadZippedFile(const FileLoadJob &job) const
+{
+  const ZippedFile *zipped_file = job.zipped_file;
+
+  // The archive is shared read-only so files can be inflated concurrently
+  ZippedFileReader reader(*zipped_file);
+  bool error = reader.Open() || InflateIntoRegion(&reader, job);
+  if (error)
+    ErrorLog("Unable to read '%s' from '%s'. Is zip file corrupt?", zipped_file->filename.c_str(), zipped_file->zipfilename.c_str());
+  else if (reader.CRC() != zipped_file->crc32)
     ErrorLog("CRC error reading '%s' from '%s'. File may be corrupt.", zipped_file->filename.c_str(), zipped_file->zipfilename.c_str());
+  return error;
+}
+
+bool GameLoader::InflateIntoRegion(ZippedFileReader *reader, const FileLoadJob &job) const
+{
+  uint8_t *dest = job.rom->data.get();
+  uint32_t file_size = job.zipped_file->uncompressed_size;
+  uint32_t chunk_size = job.region->chunk_size;
+  uint32_t stride = job.region->stride;
+  const std::vector<uint8_t> &dest_index = *job.dest_index;
+
+  // Contiguous and no byte layout: inflate straight into the region
+  if (chunk_size == stride && dest_index.empty())
+    return reader->Read(dest + job.file->offset, file_size);
+
+  // Otherwise inflate a batch of whole chunks at a time and scatter them to their interleaved positions,
+  // applying the byte layout on the way. A trailing partial stride block is left unshuffled.
+  const uint32_t batch_size = std::max<uint32_t>(1, (256 * 1024) / chunk_size) * chunk_size;
+  const size_t layout_end = job.rom->size - job.rom->size % stride;
+  std::vector<uint8_t> buffer(std::min(batch_size, file_size));
+  uint32_t dest_offset = job.file->offset;
+  uint32_t remaining = file_size;
+  while (remaining > 0)
+  {
+    uint32_t len = std::min(batch_size, remaining);
+    if (reader->Read(buffer.data(), len))
+      return true;
+    for (uint32_t src_offset = 0; src_offset < len; src_offset += chunk_size, dest_offset += stride)
+    {
+      if (dest_index.empty())
+        memcpy(dest + dest_offset, buffer.data() + src_offset, chunk_size);
+      else
+      {
+        for (uint32_t i = 0; i < chunk_size; i++)
+        {
+          size_t addr = dest_offset + i;
+          size_t byte = addr % stride;
+          dest[addr < layout_end ? addr - byte + dest_index[byte] : addr] = buffer[src_offset + i];
+        }
+      }
+    }
+    remaining -= len;
+  }
   return false;
 }
 
@@ -546,16 +765,292 @@ bool GameLoader::ParseXML(const Util::Config::Node &xml)
   return error;
 }
 
-bool GameLoader::LoadDefinitionXML(const std::string &filename)
+bool GameLoader::LoadDefinitionXML(const std::string &filename, const std::string &cache_filename)
 {
   m_xml_filename = filename;
+
+  // Skip parsing entirely if the XML file has not changed since it was cached
+  DefinitionCacheKey key;
+  bool use_cache = !cache_filename.empty() && !GetDefinitionCacheKey(&key, filename);
+  if (use_cache && !LoadDefinitionCache(cache_filename, key))
+    return false;
+
   Util::Config::Node xml("xml");
   if (Util::Config::FromXMLFile(&xml, filename))
   {
     ErrorLog("Game and ROM set definitions could not be loaded! ROMs will not be detected.");
     return true;
   }
-  return ParseXML(xml);
+  bool error = ParseXML(xml);
+
+  // Definitions with errors are not cached so that the errors keep being reported
+  if (use_cache && !error)
+    SaveDefinitionCache(cache_filename, key);
+  return error;
+}
+
+// Bump whenever the cached data or the way the XML is interpreted changes
+static const uint32_t DEFINITION_CACHE_VERSION = 1;
+
+static const char DEFINITION_CACHE_MAGIC[8] = { 'S','M','G','A','M','E','D','B' };
+
+// Little endian serialization of the cached definitions
+class DefinitionCacheWriter
+{
+public:
+  std::vector<uint8_t> data;
+
+  void Write(uint64_t value, size_t bytes)
+  {
+    for (size_t i = 0; i < bytes; i++)
+      data.push_back(uint8_t(value >> (i * 8)));
+  }
+
+  void Write(const std::string &str)
+  {
+    Write(str.length(), 4);
+    data.insert(data.end(), str.begin(), str.end());
+  }
+};
+
+class DefinitionCacheReader
+{
+public:
+  bool error = false;
+
+  DefinitionCacheReader(const uint8_t *data, size_t size)
+    : m_ptr(data),
+      m_end(data + size)
+  {}
+
+  uint64_t Read(size_t bytes)
+  {
+    if (size_t(m_end - m_ptr) < bytes)
+    {
+      error = true;
+      return 0;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++)
+      value |= uint64_t(*m_ptr++) << (i * 8);
+    return value;
+  }
+
+  std::string ReadString()
+  {
+    size_t length = size_t(Read(4));
+    if (size_t(m_end - m_ptr) < length)
+    {
+      error = true;
+      return std::string();
+    }
+    std::string str(reinterpret_cast<const char *>(m_ptr), length);
+    m_ptr += length;
+    return str;
+  }
+
+  // Number of elements that follow, each of which takes at least a byte
+  size_t ReadCount()
+  {
+    size_t count = size_t(Read(4));
+    if (count > size_t(m_end - m_ptr))
+    {
+      error = true;
+      return 0;
+    }
+    return count;
+  }
+
+  bool AtEnd() const
+  {
+    return m_ptr == m_end;
+  }
+
+private:
+  const uint8_t *m_ptr;
+  const uint8_t *m_end;
+};
+
+bool GameLoader::GetDefinitionCacheKey(DefinitionCacheKey *key, const std::string &xml_filename)
+{
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(xml_filename, ec);
+  if (ec)
+    return true;
+  Util::MappedFile xml;
+  if (!xml.Open(xml_filename))
+    return true;
+  key->xml_size = xml.Size();
+  key->xml_mtime = int64_t(mtime.time_since_epoch().count());
+  key->xml_crc32 = Util::CRC32(0, xml.Data(), xml.Size());
+  return false;
+}
+
+bool GameLoader::LoadDefinitionCache(const std::string &cache_filename, const DefinitionCacheKey &key)
+{
+  Util::MappedFile file;
+  if (!file.Open(cache_filename))
+    return true;
+
+  DefinitionCacheReader reader(file.Data(), file.Size());
+  char magic[sizeof(DEFINITION_CACHE_MAGIC)];
+  for (auto &c: magic)
+    c = char(reader.Read(1));
+  if (memcmp(magic, DEFINITION_CACHE_MAGIC, sizeof(magic)) != 0 ||
+      reader.Read(4) != DEFINITION_CACHE_VERSION ||
+      reader.Read(8) != key.xml_size ||
+      int64_t(reader.Read(8)) != key.xml_mtime ||
+      reader.Read(4) != key.xml_crc32)
+    return true;
+
+  for (size_t num_games = reader.ReadCount(); num_games > 0 && !reader.error; num_games--)
+  {
+    std::string game_name = reader.ReadString();
+    Game &game = m_game_info_by_game[game_name];
+    game.name = game_name;
+    game.parent = reader.ReadString();
+    game.title = reader.ReadString();
+    game.version = reader.ReadString();
+    game.manufacturer = reader.ReadString();
+    game.year = unsigned(reader.Read(4));
+    game.stepping = reader.ReadString();
+    game.mpeg_board = reader.ReadString();
+    game.audio = Game::AudioTypes(reader.Read(4));
+    game.encryption_key = uint32_t(reader.Read(4));
+    game.netboard_present = reader.Read(1) != 0;
+    game.inputs = uint32_t(reader.Read(4));
+    game.driveboard_type = Game::DriveBoardType(reader.Read(4));
+
+    RegionsByName_t &regions_by_name = m_regions_by_game[game_name];
+    for (size_t num_regions = reader.ReadCount(); num_regions > 0 && !reader.error; num_regions--)
+    {
+      auto region = std::make_shared<Region>();
+      region->region_name = reader.ReadString();
+      region->stride = uint32_t(reader.Read(4));
+      region->chunk_size = uint32_t(reader.Read(4));
+      region->byte_layout = reader.ReadString();
+      region->required = reader.Read(1) != 0;
+      for (size_t num_files = reader.ReadCount(); num_files > 0 && !reader.error; num_files--)
+      {
+        auto rom_file = std::make_shared<File>();
+        rom_file->filename = reader.ReadString();
+        rom_file->offset = uint32_t(reader.Read(4));
+        rom_file->crc32 = uint32_t(reader.Read(4));
+        rom_file->has_crc32 = reader.Read(1) != 0;
+        region->files.push_back(rom_file);
+      }
+      regions_by_name[region->region_name] = region;
+    }
+
+    PatchesByRegion_t &patches_by_region = m_patches_by_game[game_name];
+    for (size_t num_patched_regions = reader.ReadCount(); num_patched_regions > 0 && !reader.error; num_patched_regions--)
+    {
+      auto &patches = patches_by_region[reader.ReadString()];
+      for (size_t num_patches = reader.ReadCount(); num_patches > 0 && !reader.error; num_patches--)
+      {
+        uint32_t offset = uint32_t(reader.Read(4));
+        uint64_t value = reader.Read(8);
+        unsigned bits = unsigned(reader.Read(1));
+        patches.push_back(ROM::BigEndianPatch(offset, value, bits));
+      }
+    }
+  }
+
+  // Child sets are cheap to merge again
+  if (reader.error || !reader.AtEnd() || MergeChildrenWithParents())
+  {
+    m_game_info_by_game.clear();
+    m_regions_by_game.clear();
+    m_regions_by_merged_game.clear();
+    m_patches_by_game.clear();
+    return true;
+  }
+  return false;
+}
+
+void GameLoader::SaveDefinitionCache(const std::string &cache_filename, const DefinitionCacheKey &key) const
+{
+  DefinitionCacheWriter writer;
+  for (char c: DEFINITION_CACHE_MAGIC)
+    writer.Write(uint8_t(c), 1);
+  writer.Write(DEFINITION_CACHE_VERSION, 4);
+  writer.Write(key.xml_size, 8);
+  writer.Write(uint64_t(key.xml_mtime), 8);
+  writer.Write(key.xml_crc32, 4);
+
+  writer.Write(m_game_info_by_game.size(), 4);
+  for (auto &v: m_game_info_by_game)
+  {
+    const Game &game = v.second;
+    writer.Write(v.first);
+    writer.Write(game.parent);
+    writer.Write(game.title);
+    writer.Write(game.version);
+    writer.Write(game.manufacturer);
+    writer.Write(game.year, 4);
+    writer.Write(game.stepping);
+    writer.Write(game.mpeg_board);
+    writer.Write(uint32_t(game.audio), 4);
+    writer.Write(game.encryption_key, 4);
+    writer.Write(game.netboard_present, 1);
+    writer.Write(game.inputs, 4);
+    writer.Write(uint32_t(game.driveboard_type), 4);
+
+    auto regions_it = m_regions_by_game.find(v.first);
+    writer.Write(regions_it == m_regions_by_game.end() ? 0 : regions_it->second.size(), 4);
+    if (regions_it != m_regions_by_game.end())
+    {
+      for (auto &v2: regions_it->second)
+      {
+        const Region &region = *v2.second;
+        writer.Write(region.region_name);
+        writer.Write(region.stride, 4);
+        writer.Write(region.chunk_size, 4);
+        writer.Write(region.byte_layout);
+        writer.Write(region.required, 1);
+        writer.Write(region.files.size(), 4);
+        for (auto &rom_file: region.files)
+        {
+          writer.Write(rom_file->filename);
+          writer.Write(rom_file->offset, 4);
+          writer.Write(rom_file->crc32, 4);
+          writer.Write(rom_file->has_crc32, 1);
+        }
+      }
+    }
+
+    auto patches_it = m_patches_by_game.find(v.first);
+    writer.Write(patches_it == m_patches_by_game.end() ? 0 : patches_it->second.size(), 4);
+    if (patches_it != m_patches_by_game.end())
+    {
+      for (auto &v2: patches_it->second)
+      {
+        writer.Write(v2.first);
+        writer.Write(v2.second.size(), 4);
+        for (auto &patch: v2.second)
+        {
+          writer.Write(patch.offset, 4);
+          writer.Write(patch.value, 8);
+          writer.Write(patch.bits, 1);
+        }
+      }
+    }
+  }
+
+  // Write to a temporary file first so a failed write never leaves a truncated cache behind
+  std::string temp_filename = cache_filename + ".tmp";
+  FILE *fp = fopen(temp_filename.c_str(), "wb");
+  if (!fp)
+    return;
+  bool ok = fwrite(writer.data.data(), writer.data.size(), 1, fp) == 1;
+  ok = (fclose(fp) == 0) && ok;
+  if (ok)
+  {
+    remove(cache_filename.c_str());
+    ok = rename(temp_filename.c_str(), cache_filename.c_str()) == 0;
+  }
+  if (!ok)
+    remove(temp_filename.c_str());
 }
 
 void GameLoader::FindEquivalentFiles(std::set<File::ptr_t> *equivalent_files, const std::set<File::ptr_t> &a, const std::set<File::ptr_t> &b)
@@ -784,8 +1279,10 @@ bool GameLoader::ComputeRegionSize(uint32_t *region_size, const GameLoader::Regi
   return error;
 }
 
-static bool ApplyLayout(ROM *rom, const std::string &byte_layout, size_t stride, const std::string &region_name)
+static bool ParseLayout(std::vector<uint8_t> *dest_index, const std::string &byte_layout, size_t stride, const std::string &region_name)
 {
+  dest_index->clear();
+
   // Empty layout means do nothing
   if (byte_layout.empty())
     return false;
@@ -833,67 +1330,17 @@ static bool ApplyLayout(ROM *rom, const std::string &byte_layout, size_t stride,
     expected_offset += 1;
   }
 
-  // Okay, all good. Now we can reshuffle the region memory according to layout.
-  uint8_t *buffer = new uint8_t[stride];
-  uint8_t *dest = rom->data.get();
-  for (size_t dest_offset = 0; (dest_offset + stride) <= rom->size; dest_offset += stride)
+  // Okay, all good. The layout says which source byte of a stride block lands at each position,
+  // files are scattered as they are inflated so we want the inverse: where each source byte goes.
+  dest_index->resize(stride);
+  for (size_t i = 0; i < stride; i++)
   {
-    // Copy current region bytes to temporary buffer. The layout offsets refer to this original layout.
-    memcpy(buffer, dest + dest_offset, stride);
-
-    // Place the bytes back into the ROM region in the layout order specified.
-    for (size_t i = 0; i < stride; i++)
-    {
-      dest[dest_offset + i] = buffer[byte_offsets[i]];
-    }
+    (*dest_index)[byte_offsets[i]] = uint8_t(i);
   }
-  delete [] buffer;
 
   return false; // no error
 }
 
-bool GameLoader::LoadRegion(ROM *rom, const GameLoader::Region::ptr_t &region, const ZipArchive &zip) const
-{
-  bool error = false;
-
-  for (auto &file: region->files)
-  {
-    std::shared_ptr<uint8_t> tmp;
-    uint32_t file_size;
-    error |= LoadZippedFile(&tmp, &file_size, file, zip);
-    if (!error)
-    {
-      uint8_t *dest = rom->data.get();
-      uint8_t *src = tmp.get();
-      if (region->chunk_size == region->stride)
-      {
-        memcpy(dest + file->offset, src, file_size);
-      }
-      else
-      {
-        uint32_t num_chunks = (uint32_t)(file_size / region->chunk_size);
-        uint32_t dest_offset = file->offset;
-        uint32_t src_offset = 0;
-        uint32_t chunk_size = (uint32_t)region->chunk_size;		// cache these as pointer dereferencing cripples performance in a tight loop
-        uint32_t stride = (uint32_t)region->stride;
-        for (uint32_t i = 0; i < num_chunks; i++)
-        {
-          memcpy(dest + dest_offset, src + src_offset, chunk_size);
-          dest_offset += stride;
-          src_offset += chunk_size;
-        }
-      }
-    }
-  }
-
-  if (!error)
-  {
-    error = ApplyLayout(rom, region->byte_layout, region->stride, region->region_name);
-  }
-
-  return error;
-}
-
 bool GameLoader::LoadROMs(ROMSet *rom_set, const std::string &game_name, const ZipArchive &zip) const
 {
   auto it = m_game_info_by_game.find(game_name);
@@ -906,24 +1353,70 @@ bool GameLoader::LoadROMs(ROMSet *rom_set, const std::string &game_name, const Z
   // Load up the ROMs
   auto &regions_by_name = IsChildSet(it->second) ? m_regions_by_merged_game.find(game_name)->second : m_regions_by_game.find(game_name)->second;
   LogROMDefinition(game_name, regions_by_name);
-  bool error = false;
+
+  // Size and allocate every region and work out which file goes where
+  struct RegionLoad
+  {
+    Region::ptr_t region;
+    std::vector<uint8_t> dest_index;  // byte layout
+    bool error = false;
+  };
+  std::vector<RegionLoad> region_loads(regions_by_name.size());
+  std::vector<FileLoadJob> jobs;
+  size_t region_idx = 0;
   for (auto &v: regions_by_name)
   {
+    auto &region_load = region_loads[region_idx++];
     auto &region = v.second;
     uint32_t region_size = 0;
-    bool error_loading_region = false;
+    region_load.region = region;
 
-    // Attempt to load the region
-    if (ComputeRegionSize(&region_size, region, zip))
-      error_loading_region = true;
-    else
+    if (ComputeRegionSize(&region_size, region, zip) ||
+        ParseLayout(&region_load.dest_index, region->byte_layout, region->stride, region->region_name))
+    {
+      region_load.error = true;
+      continue;
+    }
+
+    auto &rom = rom_set->rom_by_region[region->region_name];
+    rom.data.reset(new uint8_t[region_size], std::default_delete<uint8_t[]>());
+    rom.size = region_size;
+
+    for (auto &file: region->files)
     {
-      // Load up the ROM region
-      auto &rom = rom_set->rom_by_region[region->region_name];
-      rom.data.reset(new uint8_t[region_size], std::default_delete<uint8_t[]>());
-      rom.size = region_size;
-      error_loading_region = LoadRegion(&rom, region, zip);
+      FileLoadJob job;
+      job.zipped_file = LookupFile(file, zip);
+      job.file = file;
+      job.region = region;
+      job.rom = &rom;
+      job.dest_index = &region_load.dest_index;
+      job.region_load_idx = region_idx - 1;
+      jobs.push_back(job);
     }
+  }
+
+  // Inflate all files concurrently. Files of a region only ever write their own bytes, so no locking is needed.
+  std::atomic<size_t> next_job(0);
+  auto worker = [&]()
+  {
+    for (size_t i = next_job++; i < jobs.size(); i = next_job++)
+      jobs[i].error = LoadZippedFile(jobs[i]);
+  };
+  size_t num_threads = std::min<size_t>(jobs.size(), std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &thread: threads)
+    thread.join();
+  for (auto &job: jobs)
+    region_loads[job.region_load_idx].error |= job.error;
+
+  bool error = false;
+  for (auto &region_load: region_loads)
+  {
+    auto &region = region_load.region;
+    bool error_loading_region = region_load.error;
 
     if (error_loading_region && !region->required)
     {
@@ -953,6 +1446,74 @@ bool GameLoader::LoadROMs(ROMSet *rom_set, const std::string &game_name, const Z
   return error;
 }
 
+uint64_t GameLoader::ComputeFingerprint(const std::string &game_name, const ZipArchive &zip) const
+{
+  // FNV-1a over everything that goes into the loaded regions. Files are taken
+  // from the zip directory, so nothing needs to be inflated.
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  auto hash_bytes = [&hash](const void *data, size_t size)
+  {
+    for (size_t i = 0; i < size; i++)
+    {
+      hash ^= reinterpret_cast<const uint8_t *>(data)[i];
+      hash *= 0x100000001b3ULL;
+    }
+  };
+  auto hash_string = [&hash_bytes](const std::string &str)
+  {
+    hash_bytes(str.c_str(), str.length() + 1);
+  };
+  auto hash_value = [&hash_bytes](uint64_t value)
+  {
+    hash_bytes(&value, sizeof(value));
+  };
+
+  auto it = m_game_info_by_game.find(game_name);
+  if (it == m_game_info_by_game.end())
+    return 0;
+  hash_string(game_name);
+  auto &regions_by_name = IsChildSet(it->second) ? m_regions_by_merged_game.find(game_name)->second : m_regions_by_game.find(game_name)->second;
+  for (auto &v: regions_by_name)
+  {
+    auto &region = v.second;
+    hash_string(region->region_name);
+    hash_value(region->stride);
+    hash_value(region->chunk_size);
+    hash_string(region->byte_layout);
+    for (auto &file: region->files)
+    {
+      // Same lookup as LookupFile() but quiet, missing files are reported when loading
+      const ZippedFile *zipped_file = nullptr;
+      for (auto &z: zip.files_by_crc)
+      {
+        if (file->has_crc32 ? z.first == file->crc32 : Util::ToLower(z.second.filename) == file->filename)
+        {
+          zipped_file = &z.second;
+          break;
+        }
+      }
+      hash_value(file->offset);
+      hash_value(zipped_file ? zipped_file->crc32 : 0);
+      hash_value(zipped_file ? zipped_file->uncompressed_size : 0);
+    }
+  }
+  auto patches_it = m_patches_by_game.find(game_name);
+  if (patches_it != m_patches_by_game.end())
+  {
+    for (auto &v: patches_it->second)
+    {
+      hash_string(v.first);
+      for (auto &patch: v.second)
+      {
+        hash_value(patch.offset);
+        hash_value(patch.value);
+        hash_value(patch.bits);
+      }
+    }
+  }
+  return hash;
+}
+
 std::string StripFilename(const std::string &filepath)
 {
   // Search for last '/' or '\', if any
@@ -974,9 +1535,10 @@ std::string StripFilename(const std::string &filepath)
   return std::string(filepath, 0, last_slash + 1);
 }
 
-bool GameLoader::Load(Game *game, ROMSet *rom_set, const std::string &zipfilename) const
+bool GameLoader::Load(Game *game, ROMSet *rom_set, const std::string &zipfilename, const SkipROMs_t &skip_roms) const
 {
   *game = Game();
+  auto start_time = std::chrono::steady_clock::now();
 
   // Read the zip contents
   ZipArchive zip;
@@ -1004,14 +1566,28 @@ bool GameLoader::Load(Game *game, ROMSet *rom_set, const std::string &zipfilenam
     }
   }
 
-  // Load
+  // Load, unless the caller already has the contents of this exact set
+  rom_set->fingerprint = ComputeFingerprint(game->name, zip);
+  InfoLog("Startup: scanned zip directories in %1.1f ms.", MillisecondsSince(start_time));
+  if (skip_roms && skip_roms(*game, rom_set))
+    return false;
+  start_time = std::chrono::steady_clock::now();
   bool error = LoadROMs(rom_set, game->name, zip);
   if (error)
     *game = Game();
+  else
+  {
+    size_t total_size = 0;
+    for (auto &v: rom_set->rom_by_region)
+      total_size += v.second.size;
+    InfoLog("Startup: inflated and verified %1.1f MB of ROMs in %1.1f ms.", double(total_size) / 0x100000, MillisecondsSince(start_time));
+  }
   return error;
 }
 
-GameLoader::GameLoader(const std::string &xml_file)
+GameLoader::GameLoader(const std::string &xml_file, const std::string &cache_file)
 {
-  LoadDefinitionXML(xml_file);
+  auto start_time = std::chrono::steady_clock::now();
+  LoadDefinitionXML(xml_file, cache_file);
+  InfoLog("Startup: loaded game definitions from '%s' in %1.1f ms.", xml_file.c_str(), MillisecondsSince(start_time));
 }
@@ -2,11 +2,12 @@
 #define INCLUDED_GAMELOADER_H
 
 #include "Util/NewConfig.h"
-#include "Pkgs/unzip.h"
+#include "Util/MappedFile.h"
 #include "Game.h"
 #include "ROMSet.h"
 #include <map>
 #include <set>
+#include <functional>
 
 class GameLoader
 {
@@ -56,39 +57,61 @@ private:
   // Single compressed file inside of a zip archive
   struct ZippedFile
   {
-    unzFile zf = nullptr;
+    std::shared_ptr<const Util::MappedFile> archive;
     std::string zipfilename;  // zip archive
     std::string filename;     // file inside the zip archive
     uint32_t uncompressed_size = 0;
+    uint32_t compressed_size = 0;
     uint32_t crc32 = 0;
+    uint64_t local_header_offset = 0;
+    uint16_t method = 0;
+    uint16_t flags = 0;
   };
 
   // Multiple zip archives
   struct ZipArchive
   {
     std::vector<std::string> zipfilenames;
-    std::vector<unzFile> zfs;
     std::map<uint32_t, ZippedFile> files_by_crc;
+  };
+
+  // Inflates a zipped file straight out of its mapped archive
+  class ZippedFileReader;
 
-    ~ZipArchive()
-    {
-      for (auto &zf: zfs)
-      {
-        unzClose(zf);
-      }
-    }
+  // One ROM file to be inflated straight into its final position in a region
+  struct FileLoadJob
+  {
+    const ZippedFile *zipped_file = nullptr;
+    File::ptr_t file;
+    Region::ptr_t region;
+    ROM *rom = nullptr;
+    const std::vector<uint8_t> *dest_index = nullptr;  // destination of each byte in a stride block, empty if no byte layout
+    size_t region_load_idx = 0;
+    bool error = false;
   };
 
   bool LoadZipArchive(ZipArchive *zip, const std::string &zipfilename) const;
   const ZippedFile *LookupFile(const File::ptr_t &file, const ZipArchive &zip) const;
   bool FileExistsInZipArchive(const File::ptr_t &file, const ZipArchive &zip) const;
-  bool LoadZippedFile(std::shared_ptr<uint8_t> *buffer, uint32_t *file_size, const GameLoader::File::ptr_t &file, const ZipArchive &zip) const;
+  bool LoadZippedFile(const FileLoadJob &job) const;
+  bool InflateIntoRegion(ZippedFileReader *reader, const FileLoadJob &job) const;
   static bool MissingAttrib(const GameLoader &loader, const Util::Config::Node &node, const std::string &attribute);
   bool LoadGamesFromXML(const Util::Config::Node &xml);
   bool MergeChildrenWithParents();
   void LogROMDefinition(const std::string &game_name, const RegionsByName_t &regions_by_name) const;
   bool ParseXML(const Util::Config::Node &xml);
-  bool LoadDefinitionXML(const std::string &filename);
+  bool LoadDefinitionXML(const std::string &filename, const std::string &cache_filename);
+
+  // Binary cache of the parsed definitions, valid while the XML file is unchanged
+  struct DefinitionCacheKey
+  {
+    uint64_t xml_size = 0;
+    int64_t xml_mtime = 0;
+    uint32_t xml_crc32 = 0;
+  };
+  static bool GetDefinitionCacheKey(DefinitionCacheKey *key, const std::string &xml_filename);
+  bool LoadDefinitionCache(const std::string &cache_filename, const DefinitionCacheKey &key);
+  void SaveDefinitionCache(const std::string &cache_filename, const DefinitionCacheKey &key) const;
   static void FindEquivalentFiles(std::set<File::ptr_t> *equivalent_files, const std::set<File::ptr_t> &a, const std::set<File::ptr_t> &b);
   void IdentifyGamesInZipArchive(
     std::set<std::string> *complete_games,
@@ -97,12 +120,16 @@ private:
     const std::map<std::string, RegionsByName_t> &regions_by_game) const;
   bool ComputeRegionSize(uint32_t *region_size, const Region::ptr_t &region, const ZipArchive &zip) const;
   void ChooseGameInZipArchive(std::string *chosen_game, bool *missing_parent_roms, const ZipArchive &zip, const std::string &zipfilename) const;
-  bool LoadRegion(ROM *buffer, const GameLoader::Region::ptr_t &region, const ZipArchive &zip) const;
+  uint64_t ComputeFingerprint(const std::string &game_name, const ZipArchive &zip) const;
   bool LoadROMs(ROMSet *rom_set, const std::string &game_name, const ZipArchive &zip) const;
 
 public:
-  GameLoader(const std::string &xml_file);
-  bool Load(Game *game, ROMSet *rom_set, const std::string &zipfilename) const;
+  // Called once the game is identified and the ROM set fingerprinted, before any
+  // ROM data is inflated. Returning true skips loading the regions.
+  typedef std::function<bool(const Game &game, ROMSet *rom_set)> SkipROMs_t;
+
+  GameLoader(const std::string &xml_file, const std::string &cache_file = std::string());
+  bool Load(Game *game, ROMSet *rom_set, const std::string &zipfilename, const SkipROMs_t &skip_roms = nullptr) const;
   const std::map<std::string, Game> &GetGames() const
   {
     return m_game_info_by_game;
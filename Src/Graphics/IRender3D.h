@@ -22,6 +22,7 @@ public:
   virtual void SetSunClamp(bool enable) = 0;
   virtual void SetBlockCulling(bool enable) = 0;
   virtual float GetLosValue(int layer) = 0;
+  virtual UINT32 GetUploadTime(void) = 0;
 
   virtual ~IRender3D()
   {
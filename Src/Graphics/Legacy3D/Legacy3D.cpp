@@ -959,7 +959,7 @@ void CLegacy3D::RenderViewport(UINT32 addr, int pri, bool wideScreen)
 
 void CLegacy3D::RenderFrame(void)
 {
-  bool wideScreen = m_config["WideScreen"].ValueAs<bool>();
+  bool wideScreen = m_wideScreen.Value();
 
   // Begin frame
   ClearErrors();  // must be cleared each frame
@@ -968,7 +968,7 @@ void CLegacy3D::RenderFrame(void)
       glBindFramebuffer(GL_FRAMEBUFFER, m_aaTarget);			// if we have an AA target draw to it instead of the default back buffer
   }
 
-  if (blockCulling && !m_config["NoWhiteFlash"].ValueAs<bool>())    // block culling disables 3D rendering
+  if (blockCulling && !m_noWhiteFlash.Value())    // block culling disables 3D rendering
   {
       // clear screen to white
       glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -1019,11 +1019,11 @@ void CLegacy3D::RenderFrame(void)
   
   // Draw
 #ifdef DEBUG
-  m_debugHighlightPolyHeaderIdx = m_config["Debug/HighlightPolyHeaderIdx"].ValueAsDefault<int>(-1);
-  m_debugHighlightPolyHeaderMask = m_config["Debug/HighlightPolyHeaderMask"].ValueAsDefault<uint32_t>(0);
-  m_debugHighlightCullingNodeIdx = m_config["Debug/HighlightCullingNodeIdx"].ValueAsDefault<int>(-1);
-  m_debugHighlightCullingNodeMask = m_config["Debug/HighlightCullingNodeMask"].ValueAsDefault<uint32_t>(0);
-  if (m_config["Debug/ForceFlushModels"].ValueAsDefault<bool>(false))
+  m_debugHighlightPolyHeaderIdx = m_debugHighlightPolyHeaderIdxConfig.Value();
+  m_debugHighlightPolyHeaderMask = m_debugHighlightPolyHeaderMaskConfig.Value();
+  m_debugHighlightCullingNodeIdx = m_debugHighlightCullingNodeIdxConfig.Value();
+  m_debugHighlightCullingNodeMask = m_debugHighlightCullingNodeMaskConfig.Value();
+  if (m_debugForceFlushModels.Value())
     ClearModelCache(&VROMCache);
 #endif
   ClearModelCache(&PolyCache);
@@ -1338,8 +1338,22 @@ float CLegacy3D::GetLosValue(int layer)
 	return 0.0f;
 }
 
+UINT32 CLegacy3D::GetUploadTime(void)
+{
+	return 0;
+}
+
 CLegacy3D::CLegacy3D(const Util::Config::Node &config)
   : m_config(config),
+    m_wideScreen(config, "WideScreen"),
+    m_noWhiteFlash(config, "NoWhiteFlash"),
+#ifdef DEBUG
+    m_debugHighlightPolyHeaderIdxConfig(config, "Debug/HighlightPolyHeaderIdx", -1),
+    m_debugHighlightPolyHeaderMaskConfig(config, "Debug/HighlightPolyHeaderMask", 0),
+    m_debugHighlightCullingNodeIdxConfig(config, "Debug/HighlightCullingNodeIdx", -1),
+    m_debugHighlightCullingNodeMaskConfig(config, "Debug/HighlightCullingNodeMask", 0),
+    m_debugForceFlushModels(config, "Debug/ForceFlushModels", false),
+#endif
     m_aaTarget(0)
 { 
   cullingRAMLo = NULL;
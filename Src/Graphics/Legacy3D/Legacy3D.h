@@ -360,6 +360,14 @@ public:
 	*/
 	float GetLosValue(int layer);
 
+	/*
+	* GetUploadTime(void);
+	*
+	* Returns GPU time spent uploading vertex data, in microseconds. Not
+	* measured by this renderer, always returns zero.
+	*/
+	UINT32 GetUploadTime(void);
+
 	/*
 	 * CLegacy3D(void):
 	 * ~CLegacy3D(void):
@@ -424,9 +432,16 @@ private:
 	 */
   
   const Util::Config::Node &m_config;
+  Util::Config::Handle<bool> m_wideScreen;
+  Util::Config::Handle<bool> m_noWhiteFlash;
 	
 #ifdef DEBUG
 	// Debug
+  Util::Config::Handle<int> m_debugHighlightPolyHeaderIdxConfig;
+  Util::Config::Handle<uint32_t> m_debugHighlightPolyHeaderMaskConfig;
+  Util::Config::Handle<int> m_debugHighlightCullingNodeIdxConfig;
+  Util::Config::Handle<uint32_t> m_debugHighlightCullingNodeMaskConfig;
+  Util::Config::Handle<bool> m_debugForceFlushModels;
 	int m_debugHighlightPolyHeaderIdx = -1;
 	uint32_t m_debugHighlightPolyHeaderMask = 0;
 	int m_debugHighlightCullingNodeIdx = -1;
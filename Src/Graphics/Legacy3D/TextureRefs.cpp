@@ -27,7 +27,8 @@
  * Texture references are stored internally as a 27-bit field (3 bits for format, 6 bits each for x, y, width & height) to save space.
  * 
  * A pre-allocated array is used for storing up to TEXREFS_ARRAY_SIZE texture references.  When that limit is exceeded, it switches
- * to using a hashset to store the texture references, but this requires extra memory allocation.
+ * to using a flat open-addressing hash table (linear probing, backward-shift deletion) to store the texture references.  The table is
+ * allocated once and kept across calls to Clear(), so steady-state use does not touch the allocator and lookups do not chase pointers.
  */
 
 #include "TextureRefs.h"
@@ -37,14 +38,32 @@
 
 namespace Legacy3D {
 
-CTextureRefs::CTextureRefs() : m_size(0), m_hashCapacity(0), m_hashEntries(NULL)
+// Texture references only occupy 27 bits, so an all-ones value can never be a valid reference
+static const unsigned EMPTY_SLOT = 0xFFFFFFFF;
+
+// Initial capacity of hash table when switching from array (must be a power of 2)
+static const unsigned INITIAL_HASH_CAPACITY = 64;
+
+static inline unsigned PackTexRef(unsigned fmt, unsigned x, unsigned y, unsigned width, unsigned height)
+{
+	return (fmt&7)<<24|(x&0x7E0)<<13|(y&0x7E0)<<7|(width&0x7E0)<<1|(height&0x7E0)>>5;
+}
+
+static inline unsigned HashTexRef(unsigned texRef, unsigned mask)
+{
+	// Multiplicative hash, folding high bits down so that low bits (height, width) do not dominate
+	unsigned hash = texRef * 0x9E3779B1u;
+	return (hash ^ (hash >> 15)) & mask;
+}
+
+CTextureRefs::CTextureRefs() : m_size(0), m_hashCapacity(0), m_hashSlots(NULL), m_usingHash(false)
 {
 	memset(m_array, 0, sizeof(m_array));
 }
 
 CTextureRefs::~CTextureRefs()
 {
-	DeleteAllHashEntries();
+	delete[] m_hashSlots;
 }
 
 unsigned CTextureRefs::GetSize() const
@@ -54,20 +73,17 @@ unsigned CTextureRefs::GetSize() const
 
 void CTextureRefs::Clear()
 {
-	// Delete all hash entries
-	DeleteAllHashEntries();
+	// Hash table storage is retained and will be reset when next needed
 	m_size = 0;
-	m_hashCapacity = 0;
-	m_hashEntries = NULL;
+	m_usingHash = false;
 }
 
 bool CTextureRefs::ContainsRef(unsigned fmt, unsigned x, unsigned y, unsigned width, unsigned height)
 {
-	// Pack texture reference into bitfield
-	unsigned texRef = (fmt&7)<<24|(x&0x7E0)<<13|(y&0x7E0)<<7|(width&0x7E0)<<1|(height&0x7E0)>>5;
-	
-	// Check if using array or hashset
-	if (m_size <= TEXREFS_ARRAY_SIZE)
+	unsigned texRef = PackTexRef(fmt, x, y, width, height);
+
+	// Check if using array or hash table
+	if (!m_usingHash)
 	{
 		// See if texture reference held in array
 		for (unsigned i = 0; i < m_size; i++)
@@ -78,17 +94,16 @@ bool CTextureRefs::ContainsRef(unsigned fmt, unsigned x, unsigned y, unsigned wi
 		return false;
 	}
 	else
-		// See if texture reference held in hashset
+		// See if texture reference held in hash table
 		return HashContains(texRef);
 }
 
 bool CTextureRefs::AddRef(unsigned fmt, unsigned x, unsigned y, unsigned width, unsigned height)
 {
-	// Pack texture reference into bitfield
-	unsigned texRef = (fmt&7)<<24|(x&0x7E0)<<13|(y&0x7E0)<<7|(width&0x7E0)<<1|(height&0x7E0)>>5;
+	unsigned texRef = PackTexRef(fmt, x, y, width, height);
 
-	// Check if using array or hashset
-	if (m_size <= TEXREFS_ARRAY_SIZE)
+	// Check if using array or hash table
+	if (!m_usingHash)
 	{
 		// See if already held in array, if so nothing to do
 		for (unsigned i = 0; i < m_size; i++)
@@ -99,13 +114,21 @@ bool CTextureRefs::AddRef(unsigned fmt, unsigned x, unsigned y, unsigned width,
 		// If not, check if array is full
 		if (m_size == TEXREFS_ARRAY_SIZE)
 		{
-			// If so, set initial hashset capacity to 47 to initialize it
-			UpdateHashCapacity(47);
-			// Copy array into hashset
+			// If so, initialize hash table, reusing existing storage where possible
+			if (m_hashCapacity < INITIAL_HASH_CAPACITY)
+			{
+				if (!UpdateHashCapacity(INITIAL_HASH_CAPACITY))
+					return false;
+			}
+			else
+				ClearHash();
+			// Copy array into hash table
+			m_usingHash = true;
+			m_size = 0;
 			for (unsigned i = 0; i < TEXREFS_ARRAY_SIZE; i++)
 				AddToHash(m_array[i]);
-			// Add texture reference to hashset
-			AddToHash(texRef);
+			// Add texture reference to hash table
+			return AddToHash(texRef);
 		}
 		else
 		{
@@ -116,17 +139,16 @@ bool CTextureRefs::AddRef(unsigned fmt, unsigned x, unsigned y, unsigned width,
 		return true;
 	}
 	else
-		// Add texture reference to hashset
+		// Add texture reference to hash table
 		return AddToHash(texRef);
 }
 
 bool CTextureRefs::RemoveRef(unsigned fmt, unsigned x, unsigned y, unsigned width, unsigned height)
 {
-	// Pack texture reference into bitfield
-	unsigned texRef = (fmt&7)<<24|(x&0x7E0)<<13|(y&0x7E0)<<7|(width&0x7E0)<<1|(height&0x7E0)>>5;
+	unsigned texRef = PackTexRef(fmt, x, y, width, height);
 
-	// Check if using array or hashset
-	if (m_size <= TEXREFS_ARRAY_SIZE)
+	// Check if using array or hash table
+	if (!m_usingHash)
 	{
 		for (unsigned i = 0; i < m_size; i++)
 		{
@@ -142,21 +164,20 @@ bool CTextureRefs::RemoveRef(unsigned fmt, unsigned x, unsigned y, unsigned widt
 	}
 	else 
 	{
-		// Remove texture reference from hashset
+		// Remove texture reference from hash table
 		bool removed = RemoveFromHash(texRef);
 
 		// See if should switch back to array
 		if (m_size == TEXREFS_ARRAY_SIZE)
 		{
-			// Loop through all hash entries and copy texture references into array
+			// Loop through all slots and copy texture references into array
 			unsigned j = 0;
 			for (unsigned i = 0; i < m_hashCapacity; i++)
 			{
-				for (HashEntry *entry = m_hashEntries[i]; entry; entry = entry->nextEntry)
-					m_array[j++] = entry->texRef;
+				if (m_hashSlots[i] != EMPTY_SLOT)
+					m_array[j++] = m_hashSlots[i];
 			}
-			// Delete all hash entries
-			DeleteAllHashEntries();
+			m_usingHash = false;
 		}
 		return removed;
 	}
@@ -164,38 +185,31 @@ bool CTextureRefs::RemoveRef(unsigned fmt, unsigned x, unsigned y, unsigned widt
 
 void CTextureRefs::DecodeAllTextures(CLegacy3D *Render3D)
 {
-	// Check if using array or hashset
-	if (m_size <= TEXREFS_ARRAY_SIZE)
+	auto DecodeTexRef = [Render3D](unsigned texRef)
+	{
+		// Unpack texture reference from bitfield
+		unsigned fmt = texRef>>24;
+		unsigned x = (texRef>>13)&0x7E0;
+		unsigned y = (texRef>>7)&0x7E0;
+		unsigned width = (texRef>>1)&0x7E0;
+		unsigned height = (texRef<<5)&0x7E0;
+		Render3D->DecodeTexture(fmt, x, y, width, height);
+	};
+
+	// Check if using array or hash table
+	if (!m_usingHash)
 	{
 		// Loop through elements in array and call CLegacy3D::DecodeTexture
 		for (unsigned i = 0; i < m_size; i++)
-		{
-			// Unpack texture reference from bitfield 
-			unsigned texRef = m_array[i];
-			unsigned fmt = texRef>>24;
-			unsigned x = (texRef>>13)&0x7E0;
-			unsigned y = (texRef>>7)&0x7E0;
-			unsigned width = (texRef>>1)&0x7E0;
-			unsigned height = (texRef<<5)&0x7E0;
-			Render3D->DecodeTexture(fmt, x, y, width, height);
-		}
+			DecodeTexRef(m_array[i]);
 	}
 	else
 	{
-		// Loop through all hash entriesa and call CLegacy3D::DecodeTexture
+		// Loop through all occupied slots and call CLegacy3D::DecodeTexture
 		for (unsigned i = 0; i < m_hashCapacity; i++)
 		{
-			for (HashEntry *entry = m_hashEntries[i]; entry; entry = entry->nextEntry)
-			{
-				// Unpack texture reference from bitfield 
-				unsigned texRef = entry->texRef;
-				unsigned fmt = texRef>>24;
-				unsigned x = (texRef>>13)&0x7E0;
-				unsigned y = (texRef>>7)&0x7E0;
-				unsigned width = (texRef>>1)&0x7E0;
-				unsigned height = (texRef<<5)&0x7E0;
-				Render3D->DecodeTexture(fmt, x, y, width, height);
-			}
+			if (m_hashSlots[i] != EMPTY_SLOT)
+				DecodeTexRef(m_hashSlots[i]);
 		}
 	}
 }
@@ -203,133 +217,93 @@ void CTextureRefs::DecodeAllTextures(CLegacy3D *Render3D)
 bool CTextureRefs::UpdateHashCapacity(unsigned capacity)
 {
 	unsigned oldCapacity = m_hashCapacity;
-	HashEntry **oldEntries = m_hashEntries;
-	// Update capacity and create new empty entries array
-	m_hashCapacity = capacity;
-	m_hashEntries = new(std::nothrow) HashEntry*[capacity];
-	if (!m_hashEntries)
+	unsigned *oldSlots = m_hashSlots;
+	// Create new empty slot array
+	unsigned *newSlots = new(std::nothrow) unsigned[capacity];
+	if (!newSlots)
 		return false;
-	memset(m_hashEntries, 0, capacity * sizeof(HashEntry*));
-	if (oldEntries)
+	m_hashCapacity = capacity;
+	m_hashSlots = newSlots;
+	ClearHash();
+	if (oldSlots)
 	{
-		// Redistribute entries into new entries array
-		for (unsigned i = 0; i < oldCapacity; i++)
+		// Redistribute entries into new slot array if they are live
+		if (m_usingHash)
 		{
-			HashEntry *entry = oldEntries[i];
-			while (entry)
+			for (unsigned i = 0; i < oldCapacity; i++)
 			{
-				HashEntry *nextEntry = entry->nextEntry;
-				unsigned hash = entry->texRef % capacity;
-				entry->nextEntry = m_hashEntries[hash];
-				m_hashEntries[hash] = entry;
-				entry = nextEntry;
+				if (oldSlots[i] != EMPTY_SLOT)
+					m_hashSlots[FindSlot(oldSlots[i])] = oldSlots[i];
 			}
 		}
-		// Delete old entries array
-		delete[] oldEntries;
+		delete[] oldSlots;
 	}
 	return true;
 }
 
-HashEntry *CTextureRefs::CreateHashEntry(unsigned texRef, bool &hashCapacityUpdated)
+void CTextureRefs::ClearHash()
 {
-	// Update size and increase hash capacity if required
-	m_size++;
-	hashCapacityUpdated = m_size >= m_hashCapacity;
-	if (hashCapacityUpdated)
-	{
-		if (m_hashCapacity < 89)
-			UpdateHashCapacity(89); // Capacity of 89 gives good sequence of mostly prime capacities (89, 179, 359, 719, 1439, 2879 etc)
-		else
-			UpdateHashCapacity(2 * m_hashCapacity + 1);
-	}
-	return new(std::nothrow) HashEntry(texRef);
-}
-
-void CTextureRefs::DeleteHashEntry(HashEntry *entry)
-{
-	// Update size and delete hash entry
-	m_size--;
-	delete entry;
+	memset(m_hashSlots, 0xFF, m_hashCapacity * sizeof(unsigned));
 }
 
-void CTextureRefs::DeleteAllHashEntries()
+unsigned CTextureRefs::FindSlot(unsigned texRef) const
 {
-	if (!m_hashEntries)
-		return;
-	// Delete all hash entries and their storage
-	for (unsigned i = 0; i < m_hashCapacity; i++)
-	{
-		HashEntry *entry = m_hashEntries[i];
-		delete entry;
-	}
-	delete[] m_hashEntries;
+	// Linear probe from home slot until texture reference or an empty slot is found (table is never full)
+	unsigned mask = m_hashCapacity - 1;
+	unsigned i = HashTexRef(texRef, mask);
+	while (m_hashSlots[i] != EMPTY_SLOT && m_hashSlots[i] != texRef)
+		i = (i + 1) & mask;
+	return i;
 }
 
 bool CTextureRefs::AddToHash(unsigned texRef)
 {
-	// Convert texture reference to hash value
-	unsigned hash = texRef % m_hashCapacity;
-	// Loop through linked list for hash value and see if have texture reference already
-	HashEntry *headEntry = m_hashEntries[hash];
-	HashEntry *entry = headEntry;
-	while (entry && texRef != entry->texRef)
-		entry = entry->nextEntry;
+	unsigned slot = FindSlot(texRef);
 	// If found, nothing to do
-	if (entry)
+	if (m_hashSlots[slot] == texRef)
 		return true;
-	// Otherwise, create new hash entry for texture reference
-	bool hashCapacityUpdated;
-	entry = CreateHashEntry(texRef, hashCapacityUpdated);
-	// If couldn't create entry (ie out of memory), let caller know
-	if (!entry)
-		return false;
-	if (hashCapacityUpdated)
+	// Grow table to keep load factor at or below 1/2 so that probe sequences stay short
+	if (2 * (m_size + 1) > m_hashCapacity)
 	{
-		// If hash capacity was increased recalculate hash value
-		hash = texRef % m_hashCapacity;
-		headEntry = m_hashEntries[hash];
+		if (!UpdateHashCapacity(2 * m_hashCapacity))
+			return false;
+		slot = FindSlot(texRef);
 	}
-	// Store hash entry in linked list for hash value
-	entry->nextEntry = headEntry;
-	m_hashEntries[hash] = entry;
+	m_hashSlots[slot] = texRef;
+	m_size++;
 	return true;
 }
 
 bool CTextureRefs::RemoveFromHash(unsigned texRef)
 {
-	// Convert texture reference to hash value
-	unsigned hash = texRef % m_hashCapacity;
-	// Loop through linked list for hash value and see if have texture reference
-	HashEntry *entry = m_hashEntries[hash];
-	HashEntry *prevEntry = NULL;
-	while (entry && texRef != entry->texRef)
-	{
-		prevEntry = entry;
-		entry = entry->nextEntry;
-    }
+	unsigned mask = m_hashCapacity - 1;
+	unsigned i = FindSlot(texRef);
 	// If not found, nothing to do
-	if (!entry)
+	if (m_hashSlots[i] == EMPTY_SLOT)
 		return false;
-	// Otherwise, remove entry from linked list for hash value
-	if (prevEntry)	
-		prevEntry->nextEntry = entry->nextEntry;
-	else
-		m_hashEntries[hash] = entry->nextEntry;
-	// Delete hash entry storage
-	DeleteHashEntry(entry);
+	// Shift back any following entries in the same cluster whose home slot would otherwise become unreachable
+	unsigned j = i;
+	while (true)
+	{
+		j = (j + 1) & mask;
+		if (m_hashSlots[j] == EMPTY_SLOT)
+			break;
+		unsigned home = HashTexRef(m_hashSlots[j], mask);
+		bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+		if (movable)
+		{
+			m_hashSlots[i] = m_hashSlots[j];
+			i = j;
+		}
+	}
+	m_hashSlots[i] = EMPTY_SLOT;
+	m_size--;
 	return true;
 }
 
 bool CTextureRefs::HashContains(unsigned texRef) const
 {
-	// Convert texture reference to hash value
-	unsigned hash = texRef % m_hashCapacity;
-	// Loop through linked list for hash value and see if have texture reference
-	HashEntry *entry = m_hashEntries[hash];
-	while (entry && texRef != entry->texRef)
-		entry = entry->nextEntry;
-	return !!entry;
+	return m_hashSlots[FindSlot(texRef)] == texRef;
 }
 
 } // Legacy3D
@@ -34,15 +34,6 @@ namespace Legacy3D {
 
 #define TEXREFS_ARRAY_SIZE 12
 
-// Hash entry that holds a texture reference in the hashset
-struct HashEntry
-{
-	const unsigned texRef;	// Texture reference as a bitfield
-	HashEntry *nextEntry;   // Next entry with the same hash
-  
-	HashEntry(unsigned theTexRef) : texRef(theTexRef), nextEntry(nullptr) { }
-};
-
 class CLegacy3D;
 
 class CTextureRefs
@@ -111,58 +102,55 @@ private:
 	// Pre-allocated array used to hold first TEXREFS_ARRAY_SIZE texture references.
 	unsigned m_array[TEXREFS_ARRAY_SIZE];
 
-	// Dynamically allocated hashset used to hold texture references when there are more than TEXREFS_ARRAY_SIZE.
+	// Open-addressing hash table (linear probing) used to hold texture references when there are more than
+	// TEXREFS_ARRAY_SIZE. Capacity is always a power of 2 and storage is retained across Clear() so that a
+	// model cache being rebuilt does not need to reallocate.
 	unsigned m_hashCapacity;
-	HashEntry **m_hashEntries;
-    
+	unsigned *m_hashSlots;
+	bool m_usingHash;
+
 	/*
 	 * UpdateHashCapacity(hashCapacity)
 	 *
-	 * Increases capacity of the hashset to given size.
+	 * Resizes the hash table to given size (a power of 2), reinserting any texture references held.
 	 */
 	bool UpdateHashCapacity(unsigned hashCapacity);
 
 	/*
-	 * CreateHashEntry(texRef, hashCapacityUpdated)
+	 * ClearHash()
 	 *
-	 * Creates and returns a new hash entry, updating the capacity if required (hashCapacityUpdated is set to true).
+	 * Marks all hash table slots as empty without freeing storage.
 	 */
-	HashEntry *CreateHashEntry(unsigned texRef, bool &hashCapacityUpdated);
+	void ClearHash();
 
 	/*
-	 * DeleteHashEntry(entry)
+	 * FindSlot(texRef)
 	 *
-	 * Deletes the given hash entry and its storage.
+	 * Returns the slot holding the given texture reference (as a bitfield) or the empty slot where it would be
+	 * inserted.
 	 */
-	void DeleteHashEntry(HashEntry *entry);
-	
-	/*
-	 * DeleteAllHashEntries()
-	 *
-	 * Deletes all hash entries and their storage.
-	 */
-    void DeleteAllHashEntries();
-	
+	unsigned FindSlot(unsigned texRef) const;
+
 	/*
 	 * AddToHash(texRef)
 	 *
-	 * Adds the given texture reference (as a bitfield) to the hashset.
+	 * Adds the given texture reference (as a bitfield) to the hash table.
 	 */
 	bool AddToHash(unsigned texRef);
 
 	/*
 	 * RemoveFromHash(texRef)
 	 *
-	 * Removes the given texture reference (as a bitfield) from the hashset.
+	 * Removes the given texture reference (as a bitfield) from the hash table.
 	 */
 	bool RemoveFromHash(unsigned texRef);
 
 	/*
 	 * HashContains(texRef)
 	 *
-	 * Returns true if given texture reference (as a bitfield) is held in the hashset.
+	 * Returns true if given texture reference (as a bitfield) is held in the hash table.
 	 */
-    bool HashContains(unsigned texRef) const;
+	bool HashContains(unsigned texRef) const;
 };
 
 } // Legacy3D
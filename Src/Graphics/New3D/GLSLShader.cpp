@@ -1,4 +1,5 @@
 #include "GLSLShader.h"
+#include "Graphics/Shader.h"
 #include <cstdio>
 
 GLSLShader::GLSLShader() 
@@ -36,6 +37,14 @@ GLSLShader& GLSLShader::operator=(GLSLShader&& other) noexcept
 
 bool GLSLShader::LoadShaders(const char* vertexShader, const char* fragmentShader) 
 {
+	UINT64 cacheKey = GetShaderCacheKey({ vertexShader, fragmentShader });
+
+	m_program = LoadCachedShaderProgram(cacheKey);
+
+	if (m_program) {
+		return true;			// no shader objects to keep around
+	}
+
 	m_program = glCreateProgram();
 	m_vShader = glCreateShader(GL_VERTEX_SHADER);
 	m_fShader = glCreateShader(GL_FRAGMENT_SHADER);
@@ -49,12 +58,15 @@ bool GLSLShader::LoadShaders(const char* vertexShader, const char* fragmentShade
 	glAttachShader(m_program, m_vShader);
 	glAttachShader(m_program, m_fShader);
 
+	PrepareShaderProgramForCache(m_program);
 	glLinkProgram(m_program);
 
 	PrintShaderInfoLog(m_vShader);
 	PrintShaderInfoLog(m_fShader);
 	PrintProgramInfoLog(m_program);
 
+	SaveCachedShaderProgram(m_program, cacheKey);
+
 	return true;
 }
 
@@ -0,0 +1,239 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "ModelCache.h"
+#include "PolyHeader.h"
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <zlib.h>
+
+namespace New3D {
+
+// bump this whenever CacheModel starts producing different output for the same data
+static const UINT32 MODEL_CACHE_VERSION = 2;
+
+static const char MODEL_CACHE_MAGIC[8] = { 'S','M','M','O','D','E','L','S' };
+
+struct FileHeader
+{
+	char	magic[8];
+	UINT32	version;
+	UINT32	parseKey;
+	UINT32	meshSize;
+	UINT32	vertexSize;
+	UINT32	numEntries;
+	UINT32	numMeshes;
+	UINT32	numVerts;
+	UINT32	reserved;
+};
+
+struct FileEntry
+{
+	UINT32	modelAddr;
+	UINT32	crc;
+	UINT32	firstMesh;
+	UINT32	numMeshes;
+	UINT32	firstVert;
+	UINT32	numVerts;
+	ModelCache::TrailingVerts trailing;
+};
+
+// the file is just a memory dump of these
+static_assert(std::is_trivially_copyable<Mesh>::value, "Mesh must be trivially copyable");
+static_assert(std::is_trivially_copyable<FVertex>::value, "FVertex must be trivially copyable");
+static_assert(std::is_trivially_copyable<ModelCache::TrailingVerts>::value, "TrailingVerts must be trivially copyable");
+static_assert(sizeof(FileHeader) % 4 == 0 && sizeof(FileEntry) % 4 == 0 && sizeof(Mesh) % 4 == 0, "file sections must stay 4 byte aligned");
+
+bool ModelCache::Load(const std::string& path, UINT32 parseKey)
+{
+	Clear();
+
+	FILE* fp = fopen(path.c_str(), "rb");
+
+	if (!fp) {
+		return false;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if (size < (long)sizeof(FileHeader)) {
+		fclose(fp);
+		return false;
+	}
+
+	m_file.resize(size);
+	bool ok = fread(m_file.data(), size, 1, fp) == 1;
+	fclose(fp);
+
+	FileHeader header;
+	std::memcpy(&header, m_file.data(), sizeof(header));
+
+	ok = ok &&
+		std::memcmp(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+		header.version == MODEL_CACHE_VERSION &&
+		header.parseKey == parseKey &&
+		header.meshSize == sizeof(Mesh) &&
+		header.vertexSize == sizeof(FVertex) &&
+		(size_t)size == sizeof(FileHeader) + (size_t)header.numEntries * sizeof(FileEntry) + (size_t)header.numMeshes * sizeof(Mesh) + (size_t)header.numVerts * sizeof(FVertex);
+
+	if (!ok) {
+		Clear();
+		return false;
+	}
+
+	const FileEntry*	entries	= (const FileEntry*)(m_file.data() + sizeof(FileHeader));
+	const Mesh*			meshes	= (const Mesh*)(entries + header.numEntries);
+	const FVertex*		verts	= (const FVertex*)(meshes + header.numMeshes);
+
+	m_entries.reserve(header.numEntries);
+
+	for (UINT32 i = 0; i < header.numEntries; i++) {
+
+		const FileEntry& e = entries[i];
+
+		if ((UINT64)e.firstMesh + e.numMeshes > header.numMeshes || (UINT64)e.firstVert + e.numVerts > header.numVerts) {
+			continue;		// corrupt, skip it
+		}
+
+		m_entries[e.modelAddr] = { e.crc, meshes + e.firstMesh, e.numMeshes, verts + e.firstVert, e.numVerts, e.trailing };
+	}
+
+	return true;
+}
+
+bool ModelCache::Save(const std::string& path, UINT32 parseKey) const
+{
+	FileHeader header = {};
+
+	std::memcpy(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic));
+	header.version		= MODEL_CACHE_VERSION;
+	header.parseKey		= parseKey;
+	header.meshSize		= sizeof(Mesh);
+	header.vertexSize	= sizeof(FVertex);
+	header.numEntries	= (UINT32)m_entries.size();
+
+	std::vector<FileEntry> entries;
+	entries.reserve(m_entries.size());
+
+	for (const auto& it : m_entries) {
+		entries.push_back({ it.first, it.second.crc, header.numMeshes, it.second.numMeshes, header.numVerts, it.second.numVerts, it.second.trailing });
+		header.numMeshes	+= it.second.numMeshes;
+		header.numVerts		+= it.second.numVerts;
+	}
+
+	// write to a temporary file first so a failed write never leaves a truncated cache behind
+	std::string tempPath = path + ".tmp";
+
+	FILE* fp = fopen(tempPath.c_str(), "wb");
+
+	if (!fp) {
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+	if (ok && !entries.empty()) {
+		ok = fwrite(entries.data(), sizeof(FileEntry), entries.size(), fp) == entries.size();
+	}
+
+	for (const auto& it : m_entries) {
+		if (ok && it.second.numMeshes) {
+			ok = fwrite(it.second.meshes, sizeof(Mesh), it.second.numMeshes, fp) == it.second.numMeshes;
+		}
+	}
+
+	for (const auto& it : m_entries) {
+		if (ok && it.second.numVerts) {
+			ok = fwrite(it.second.verts, sizeof(FVertex), it.second.numVerts, fp) == it.second.numVerts;
+		}
+	}
+
+	ok = (fclose(fp) == 0) && ok;
+
+	if (ok) {
+		remove(path.c_str());		// rename won't replace an existing file on windows
+		ok = rename(tempPath.c_str(), path.c_str()) == 0;
+	}
+
+	if (!ok) {
+		remove(tempPath.c_str());
+	}
+
+	return ok;
+}
+
+void ModelCache::Clear()
+{
+	m_entries.clear();
+	m_added.clear();
+	m_file.clear();
+	m_file.shrink_to_fit();
+	m_dirty = false;
+}
+
+const ModelCache::Entry* ModelCache::Find(UINT32 modelAddr, UINT32 crc) const
+{
+	auto it = m_entries.find(modelAddr);
+
+	if (it == m_entries.end() || it->second.crc != crc) {
+		return nullptr;
+	}
+
+	return &it->second;
+}
+
+void ModelCache::Add(UINT32 modelAddr, UINT32 crc, const std::vector<Mesh>& meshes, const FVertex* verts, UINT32 firstVert, UINT32 numVerts, const TrailingVerts& trailing)
+{
+	auto owned = std::make_unique<OwnedEntry>();
+
+	owned->meshes = meshes;
+	owned->verts.assign(verts, verts + numVerts);
+
+	// store vbo offsets relative to the entry so they can be rebased on load
+	for (auto& mesh : owned->meshes) {
+		mesh.vboOffset -= firstVert;
+	}
+
+	m_entries[modelAddr] = { crc, owned->meshes.data(), (UINT32)owned->meshes.size(), owned->verts.data(), numVerts, trailing };
+	m_added.push_back(std::move(owned));
+	m_dirty = true;
+}
+
+bool ModelCache::IsDirty() const
+{
+	return m_dirty;
+}
+
+UINT32 ModelCache::ModelCRC(const UINT32* data)
+{
+	PolyHeader ph((UINT32*)data);
+
+	while (ph.NextPoly()) {}
+
+	size_t words = (ph.header - data) + 7 + (ph.NumVerts() - ph.NumSharedVerts()) * 4;
+
+	return (UINT32)crc32(0L, (const Bytef*)data, (uInt)(words * sizeof(UINT32)));
+}
+
+} // New3D
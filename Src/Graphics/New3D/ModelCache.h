@@ -0,0 +1,85 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef _MODELCACHE_H_
+#define _MODELCACHE_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "Types.h"
+#include "Model.h"
+
+namespace New3D {
+
+	// On disk cache of parsed VROM models, one file per game. Entries are keyed by VROM address
+	// and only used if the crc of the model data still matches, so a changed rom set just misses.
+	// The file is read in a single block and the meshes and vertices are used in place.
+
+	class ModelCache
+	{
+	public:
+
+		struct TrailingVerts					// last polygon of a model, which the next model can start from
+		{
+			Vertex			verts[4];
+			UINT16			texCoords[4][2];
+		};
+
+		struct Entry
+		{
+			UINT32			crc;
+			const Mesh*		meshes;			// vboOffset is relative to the first vertex of the entry
+			UINT32			numMeshes;
+			const FVertex*	verts;
+			UINT32			numVerts;
+			TrailingVerts	trailing;
+		};
+
+		bool Load(const std::string& path, UINT32 parseKey);	// parseKey is anything that changes how models are parsed
+		bool Save(const std::string& path, UINT32 parseKey) const;
+		void Clear();
+
+		const Entry* Find(UINT32 modelAddr, UINT32 crc) const;
+		void Add(UINT32 modelAddr, UINT32 crc, const std::vector<Mesh>& meshes, const FVertex* verts, UINT32 firstVert, UINT32 numVerts, const TrailingVerts& trailing);	// firstVert is the vbo offset of verts[0]
+
+		bool IsDirty() const;
+
+		static UINT32 ModelCRC(const UINT32* data);				// crc of the poly data of one model
+
+	private:
+
+		struct OwnedEntry
+		{
+			std::vector<Mesh>		meshes;
+			std::vector<FVertex>	verts;
+		};
+
+		std::vector<UINT8>								m_file;			// loaded entries point in here
+		std::vector<std::unique_ptr<OwnedEntry>>		m_added;		// entries added since load
+		std::unordered_map<UINT32, Entry>				m_entries;
+		bool											m_dirty = false;
+	};
+
+}
+
+#endif
@@ -28,6 +28,9 @@
 #include <unordered_map>
 #include "R3DFloat.h"
 #include "Util/BitCast.h"
+#include "Util/Format.h"
+#include "OSD/FileSystemPath.h"
+#include "OSD/Logger.h"
 
 #define MAX_RAM_VERTS 300000
 #define MAX_ROM_VERTS 1500000
@@ -59,10 +62,22 @@ CNew3D::CNew3D(const Util::Config::Node &config, const std::string& gameName) :
 	m_LODBlendTable(nullptr),
 	m_prev{{}},
 	m_prevTexCoords{{}},
+	m_dynamicVerts(nullptr),
+	m_dynamicVertCount(0),
+	m_dynamicSegment(0),
+	m_dynamicFences{},
+	m_persistentMapped(false),
 	m_vao(0),
 	m_r3dShader(config),
 	m_r3dScrollFog(),
-	m_aaTarget(0)
+	m_aaTarget(0),
+	m_modelCacheLoaded(false),
+	m_indirectDraw(false),
+	m_drawIDCount(0),
+	m_uploadQueries{},
+	m_uploadQueryIdx(0),
+	m_uploadQueryPending{},
+	m_uploadTime(0)
 {
 	m_sunClamp		= true;
 	m_numPolyVerts	= 3;
@@ -76,6 +91,12 @@ CNew3D::CNew3D(const Util::Config::Node &config, const std::string& gameName) :
 	m_wideScreen = config["WideScreen"].ValueAs<bool>();
 	m_noWhiteFlash = config["NoWhiteFlash"].ValueAs<bool>();
 
+	if (config["ModelCache"].ValueAs<bool>() && !m_gameName.empty()) {
+		m_modelCachePath = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Cache) << m_gameName << ".models";
+	}
+	m_indirectDraw = config["IndirectDraw"].ValueAs<bool>() && GLEW_VERSION_4_3;	// needs multi draw indirect and storage buffers
+
+	m_r3dShader.SetIndirectDraw(m_indirectDraw);
 	m_r3dShader.LoadShader();
 	glUseProgram(0);
 
@@ -83,7 +104,17 @@ CNew3D::CNew3D(const Util::Config::Node &config, const std::string& gameName) :
 
 	glGenVertexArrays(1, &m_vao);
 	glBindVertexArray(m_vao);
-	m_vbo.Create(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW, sizeof(FVertex) * (MAX_RAM_VERTS + MAX_ROM_VERTS));
+
+	const GLsizeiptr romBytes		= sizeof(FVertex) * MAX_ROM_VERTS;
+	const GLsizeiptr dynamicBytes	= sizeof(FVertex) * MAX_RAM_VERTS * NUM_DYNAMIC_SEGMENTS;
+
+	m_persistentMapped = m_vbo.CreatePersistent(GL_ARRAY_BUFFER, romBytes + dynamicBytes, romBytes, dynamicBytes);
+
+	if (!m_persistentMapped) {
+		m_vbo.Create(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW, romBytes + dynamicBytes);
+		m_polyBufferRam.resize(MAX_RAM_VERTS);		// staging memory for dynamic polys, uploaded once per frame
+	}
+
 	m_vbo.Bind(true);
 
 	glEnableVertexAttribArray(m_r3dShader.GetVertexAttribPos("inVertex"));
@@ -103,13 +134,51 @@ CNew3D::CNew3D(const Util::Config::Node &config, const std::string& gameName) :
 	glVertexAttribPointer(m_r3dShader.GetVertexAttribPos("inFixedShade"), 1, GL_FLOAT, GL_FALSE, sizeof(FVertex), (void*)offsetof(FVertex, base.fixedShade));
 	glVertexAttribPointer(m_r3dShader.GetVertexAttribPos("inTextureNP"), 1, GL_FLOAT, GL_FALSE, sizeof(FVertex), (void*)offsetof(FVertex, textureNP));
 
-	glBindVertexArray(0);
 	m_vbo.Bind(false);
+
+	if (m_indirectDraw) {
+		m_drawDataBuffer.Create(GL_SHADER_STORAGE_BUFFER, GL_STREAM_DRAW, 0);
+		m_indirectBuffer.Create(GL_DRAW_INDIRECT_BUFFER, GL_STREAM_DRAW, 0);
+		m_drawIDBuffer.Create(GL_ARRAY_BUFFER, GL_STATIC_DRAW, 0);
+
+		// one id per instance, the draw command's base instance selects which one
+		m_drawIDBuffer.Bind(true);
+		glEnableVertexAttribArray(m_r3dShader.GetVertexAttribPos("inDrawID"));
+		glVertexAttribIPointer(m_r3dShader.GetVertexAttribPos("inDrawID"), 1, GL_INT, sizeof(GLint), 0);
+		glVertexAttribDivisor(m_r3dShader.GetVertexAttribPos("inDrawID"), 1);
+		m_drawIDBuffer.Bind(false);
+	}
+
+	glBindVertexArray(0);
+
+	if (GLEW_ARB_timer_query) {
+		glGenQueries(2, m_uploadQueries);
+	}
 }
 
 CNew3D::~CNew3D()
 {
+	if (m_modelCacheLoaded && m_modelCache.IsDirty()) {
+		if (!m_modelCache.Save(m_modelCachePath, ModelCacheKey())) {
+			ErrorLog("Unable to save model cache to '%s'.", m_modelCachePath.c_str());
+		}
+	}
+
+	for (auto& fence : m_dynamicFences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (m_uploadQueries[0]) {
+		glDeleteQueries(2, m_uploadQueries);
+	}
+
 	m_vbo.Destroy();
+	m_drawDataBuffer.Destroy();
+	m_indirectBuffer.Destroy();
+	m_drawIDBuffer.Destroy();
 	if (m_vao) {
 		glDeleteVertexArrays(1, &m_vao);
 		m_vao = 0;
@@ -352,6 +421,10 @@ bool CNew3D::RenderScene(int priority, bool renderOverlay, Layer layer)
 	m_textureBank[1].Bind();
 	glActiveTexture(GL_TEXTURE0);
 
+	if (m_indirectDraw) {
+		return RenderSceneIndirect(priority, renderOverlay, layer);
+	}
+
 	bool hasOverlay = false;		// (high priority polys)
 
 	for (auto &n : m_nodes) {
@@ -396,6 +469,91 @@ bool CNew3D::RenderScene(int priority, bool renderOverlay, Layer layer)
 	return hasOverlay;
 }
 
+bool CNew3D::RenderSceneIndirect(int priority, bool renderOverlay, Layer layer)
+{
+	bool hasOverlay = false;		// (high priority polys)
+
+	m_drawData.clear();
+	m_drawCommands.clear();
+	m_drawBatches.clear();
+
+	// gather everything we are going to draw, with the same filtering as the immediate path
+	for (auto &n : m_nodes) {
+
+		if (n.viewport.priority != priority || n.models.empty()) {
+			continue;
+		}
+
+		CalcViewport(&n.viewport);
+
+		for (auto &m : n.models) {
+
+			for (auto &mesh : *m.meshes) {
+
+				if (mesh.highPriority) {
+					hasOverlay = true;
+				}
+
+				if (!mesh.Render(layer, m.alpha)) continue;
+				if (mesh.highPriority != renderOverlay) continue;
+
+				// stencil state is fixed function so a new batch is needed whenever it changes
+				if (m_drawBatches.empty() || m_drawBatches.back().node != &n || m_drawBatches.back().mesh->layered != mesh.layered || m_drawBatches.back().mesh->noLosReturn != mesh.noLosReturn) {
+					m_drawBatches.push_back({ &n, &mesh, (int)m_drawCommands.size(), 0 });
+				}
+
+				GLuint drawID = (GLuint)m_drawData.size();
+
+				m_drawData.emplace_back();
+				m_r3dShader.GetDrawData(&m, &mesh, m_drawData.back());
+				m_drawCommands.push_back({ (GLuint)mesh.vertexCount, 1, (GLuint)mesh.vboOffset, drawID });
+				m_drawBatches.back().count++;
+			}
+		}
+	}
+
+	if (m_drawCommands.empty()) {
+		return hasOverlay;
+	}
+
+	// grow the draw id attribute buffer if needed, it only ever holds 0..n-1
+	if ((int)m_drawCommands.size() > m_drawIDCount) {
+		std::vector<GLint> ids(std::max<size_t>(m_drawCommands.size(), (size_t)m_drawIDCount * 2));
+		for (size_t i = 0; i < ids.size(); i++) {
+			ids[i] = (GLint)i;
+		}
+		m_drawIDBuffer.Bind(true);
+		m_drawIDBuffer.BufferData(ids.size() * sizeof(GLint), ids.data());
+		m_vbo.Bind(true);				// restore the binding from SetRenderStates
+		m_drawIDCount = (int)ids.size();
+	}
+
+	m_drawDataBuffer.Bind(true);
+	m_drawDataBuffer.BufferData(m_drawData.size() * sizeof(DrawData), m_drawData.data());
+	m_drawDataBuffer.BindBase(0);
+
+	m_indirectBuffer.Bind(true);
+	m_indirectBuffer.BufferData(m_drawCommands.size() * sizeof(DrawArraysIndirectCommand), m_drawCommands.data());
+
+	const Node* currentNode = nullptr;
+
+	for (const auto& batch : m_drawBatches) {
+
+		if (batch.node != currentNode) {
+			currentNode = batch.node;
+			glViewport(currentNode->viewport.x, currentNode->viewport.y, currentNode->viewport.width, currentNode->viewport.height);
+			m_r3dShader.SetViewportUniforms(&currentNode->viewport);
+		}
+
+		m_r3dShader.SetMeshStencil(batch.mesh);
+		glMultiDrawArraysIndirect(m_primType, (const void*)(batch.first * sizeof(DrawArraysIndirectCommand)), batch.count, 0);
+	}
+
+	m_indirectBuffer.Bind(false);
+
+	return hasOverlay;
+}
+
 bool CNew3D::SkipLayer(int layer)
 {
 	for (const auto &n : m_nodes) {
@@ -450,7 +608,7 @@ void CNew3D::RenderFrame(void)
 	}
 
 	// release any resources from last frame
-	m_polyBufferRam.clear();		// clear dynamic model memory buffer
+	BeginDynamicVertices();			// move to next dynamic vertex segment
 	m_nodes.clear();				// memory will grow during the object life time, that's fine, no need to shrink to fit
 	m_modelMat.Release();			// would hope we wouldn't need this but no harm in checking
 	m_nodeAttribs.Reset();
@@ -475,7 +633,11 @@ void CNew3D::RenderFrame(void)
 	RenderViewport(0x800000);						// build model structure
 	
 	m_vbo.Bind(true);
-	m_vbo.BufferSubData(MAX_ROM_VERTS*sizeof(FVertex), m_polyBufferRam.size()*sizeof(FVertex), m_polyBufferRam.data());	// upload all the dynamic data to GPU in one go
+	BeginUploadTimer();
+
+	if (!m_persistentMapped) {
+		m_vbo.BufferSubData(DynamicSegmentBase() * sizeof(FVertex), m_dynamicVertCount * sizeof(FVertex), m_polyBufferRam.data());	// upload all the dynamic data to GPU in one go
+	}
 
 	if (!m_polyBufferRom.empty()) {
 
@@ -498,6 +660,8 @@ void CNew3D::RenderFrame(void)
 		}
 	}
 
+	EndUploadTimer();
+
 	m_r3dFrameBuffers.SetFBO(Layer::colour);		// colour will draw to all 3 buffers. For regular opaque pixels the transparent layers will be essentially masked
 	glClear(GL_COLOR_BUFFER_BIT);
 
@@ -547,6 +711,8 @@ void CNew3D::RenderFrame(void)
 		}
 	}
 
+	EndDynamicVertices();
+
 	m_r3dFrameBuffers.SetFBO(Layer::none);
 
 	if (m_aaTarget) {
@@ -568,6 +734,80 @@ void CNew3D::EndFrame(void)
 {
 }
 
+UINT32 CNew3D::GetUploadTime(void)
+{
+	return m_uploadTime;
+}
+
+int CNew3D::DynamicSegmentBase() const
+{
+	return MAX_ROM_VERTS + (m_dynamicSegment * MAX_RAM_VERTS);
+}
+
+void CNew3D::BeginDynamicVertices()
+{
+	m_dynamicSegment	= (m_dynamicSegment + 1) % NUM_DYNAMIC_SEGMENTS;
+	m_dynamicVertCount	= 0;
+
+	if (!m_persistentMapped) {
+		m_dynamicVerts = m_polyBufferRam.data();
+		return;
+	}
+
+	// the gpu may still be reading this segment from a previous frame, with 3 segments we should almost never actually wait here
+	GLsync& fence = m_dynamicFences[m_dynamicSegment];
+
+	if (fence) {
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);	// 1 second timeout
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	m_dynamicVerts = (FVertex*)m_vbo.GetMappedPtr() + (m_dynamicSegment * MAX_RAM_VERTS);
+}
+
+void CNew3D::EndDynamicVertices()
+{
+	if (m_persistentMapped && m_dynamicVertCount) {
+		m_dynamicFences[m_dynamicSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+void CNew3D::BeginUploadTimer()
+{
+	if (!m_uploadQueries[0]) {
+		return;
+	}
+
+	// read back the previous frame's query if the result is ready, never stall waiting on it
+	int prev = m_uploadQueryIdx ^ 1;
+
+	if (m_uploadQueryPending[prev]) {
+		GLint available = 0;
+		glGetQueryObjectiv(m_uploadQueries[prev], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available) {
+			GLuint64 ns = 0;
+			glGetQueryObjectui64v(m_uploadQueries[prev], GL_QUERY_RESULT, &ns);
+			m_uploadTime = (UINT32)(ns / 1000);
+			m_uploadQueryPending[prev] = false;
+		}
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, m_uploadQueries[m_uploadQueryIdx]);
+}
+
+void CNew3D::EndUploadTimer()
+{
+	if (!m_uploadQueries[0]) {
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_uploadQueryPending[m_uploadQueryIdx] = true;
+	m_uploadQueryIdx ^= 1;
+}
+
 /******************************************************************************
 Real3D Address Translation
 
@@ -605,6 +845,8 @@ const UINT32* CNew3D::TranslateModelAddress(UINT32 modelAddr)
 bool CNew3D::DrawModel(UINT32 modelAddr)
 {
 	bool cached = false;
+	bool storeModel = false;
+	UINT32 crc = 0;
 
 	const UINT32* const modelAddress = TranslateModelAddress(modelAddr);
 
@@ -626,6 +868,13 @@ bool CNew3D::DrawModel(UINT32 modelAddr)
 		else {
 			m->meshes = std::make_shared<std::vector<Mesh>>();
 			m_romMap[modelAddr] = m->meshes;		// store meshes in our rom map here
+
+			// models that start with vertices shared from the previous model depend on whatever was drawn before them, so can't be stored
+			if (!m_modelCachePath.empty() && (modelAddress[0] & 0xF) == 0) {
+				crc			= ModelCache::ModelCRC(modelAddress);
+				cached		= LoadCachedModel(modelAddr, crc, *m->meshes);
+				storeModel	= !cached;
+			}
 		}
 
 		m->dynamic = false;
@@ -647,12 +896,58 @@ bool CNew3D::DrawModel(UINT32 modelAddr)
 	m->alpha			= m_nodeAttribs.currentModelAlpha;
 
 	if (!cached) {
+		size_t firstVert = m_polyBufferRom.size();
+
 		CacheModel(m, modelAddress);
+
+		if (storeModel) {
+			ModelCache::TrailingVerts trailing;
+			std::copy(std::begin(m_prev), std::end(m_prev), trailing.verts);
+			std::memcpy(trailing.texCoords, m_prevTexCoords, sizeof(trailing.texCoords));
+			m_modelCache.Add(modelAddr, crc, *m->meshes, m_polyBufferRom.data() + firstVert, (UINT32)firstVert, (UINT32)(m_polyBufferRom.size() - firstVert), trailing);
+		}
 	}
 
 	return true;
 }
 
+UINT32 CNew3D::ModelCacheKey() const
+{
+	return (UINT32)m_step | ((UINT32)m_numPolyVerts << 8);		// vertex format and poly type both change the parsed data
+}
+
+bool CNew3D::LoadCachedModel(UINT32 modelAddr, UINT32 crc, std::vector<Mesh>& meshes)
+{
+	if (!m_modelCacheLoaded) {
+		m_modelCacheLoaded = true;
+		if (m_modelCache.Load(m_modelCachePath, ModelCacheKey())) {
+			InfoLog("Loaded model cache from '%s'.", m_modelCachePath.c_str());
+		}
+	}
+
+	const ModelCache::Entry* entry = m_modelCache.Find(modelAddr, crc);
+
+	if (!entry) {
+		return false;
+	}
+
+	int base = (int)m_polyBufferRom.size();
+
+	meshes.assign(entry->meshes, entry->meshes + entry->numMeshes);
+
+	for (auto& mesh : meshes) {
+		mesh.vboOffset += base;
+	}
+
+	m_polyBufferRom.insert(m_polyBufferRom.end(), entry->verts, entry->verts + entry->numVerts);
+
+	// leave the previous vertices as parsing the model would have, for a following model that starts with shared ones
+	std::copy(std::begin(entry->trailing.verts), std::end(entry->trailing.verts), m_prev);
+	std::memcpy(m_prevTexCoords, entry->trailing.texCoords, sizeof(m_prevTexCoords));
+
+	return true;
+}
+
 /*
 	0x00:   x------- -------- -------- --------	Is UF ref
 			-x------ -------- -------- --------	Is 3D model
@@ -1569,12 +1864,20 @@ void CNew3D::CacheModel(Model *m, const UINT32 *data)
 
 		if (m->dynamic) {
 
+			int vertexCount = (int)it.second.verts.size();
+
+			// drop the mesh if the dynamic segment is full, rather than writing past it
+			if (m_dynamicVertCount + vertexCount > MAX_RAM_VERTS) {
+				vertexCount = 0;
+			}
+
 			// calculate VBO values for current mesh
-			it.second.vboOffset		= (int)m_polyBufferRam.size() + MAX_ROM_VERTS;
-			it.second.vertexCount	= (int)it.second.verts.size();
+			it.second.vboOffset		= DynamicSegmentBase() + m_dynamicVertCount;
+			it.second.vertexCount	= vertexCount;
 
-			// copy poly data to main buffer
-			m_polyBufferRam.insert(m_polyBufferRam.end(), it.second.verts.begin(), it.second.verts.end());
+			// copy poly data straight into the current segment (mapped gpu memory if available)
+			std::copy(it.second.verts.begin(), it.second.verts.begin() + vertexCount, m_dynamicVerts + m_dynamicVertCount);
+			m_dynamicVertCount += vertexCount;
 		}
 		else {
 			// calculate VBO values for current mesh
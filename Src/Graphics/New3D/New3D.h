@@ -45,6 +45,7 @@
 #include "R3DFrameBuffers.h"
 #include <mutex>
 #include "TextureBank.h"
+#include "ModelCache.h"
 
 namespace New3D {
 
@@ -175,6 +176,15 @@ public:
 	*/
 	float GetLosValue(int layer);
 
+	/*
+	* GetUploadTime(void);
+	*
+	* Returns the GPU time spent uploading vertex data, in microseconds, as
+	* measured by timer queries. Lags a frame behind and is zero if timer
+	* queries are not supported.
+	*/
+	UINT32 GetUploadTime(void);
+
 	/*
 	* CRender3D(config):
 	* ~CRender3D(void):
@@ -216,6 +226,7 @@ private:
 	void GetCoordinates(int width, int height, UINT16 uIn, UINT16 vIn, float uvScale, float& uOut, float& vOut) const;
 
 	bool RenderScene(int priority, bool renderOverlay, Layer layer);		// returns if has overlay plane
+	bool RenderSceneIndirect(int priority, bool renderOverlay, Layer layer);	// same as above but with one multi draw per batch of meshes
 	bool IsDynamicModel(UINT32 *data) const;				// check if the model has a colour palette
 	bool IsVROMModel(UINT32 modelAddr) const;
 	void DrawScrollFog();
@@ -226,7 +237,14 @@ private:
 	void TranslateLosPosition(int inX, int inY, int& outX, int& outY) const;
 	bool ProcessLos(int priority);
 	void CalcViewport(Viewport* vp);
+	int  DynamicSegmentBase() const;		// first vertex of the current dynamic segment
+	void BeginDynamicVertices();
+	void EndDynamicVertices();
+	void BeginUploadTimer();
+	void EndUploadTimer();
 	void TranslateTexture(unsigned& x, unsigned& y, int width, int height, int& page) const;
+	UINT32 ModelCacheKey() const;
+	bool LoadCachedModel(UINT32 modelAddr, UINT32 crc, std::vector<Mesh>& meshes);	// copies a model from the disk cache into the rom buffer
 
 	/*
 	* Data
@@ -283,18 +301,64 @@ private:
 	UINT16			m_prevTexCoords[4][2];	// basically relying on undefined behavour
 
 	std::vector<Node>	 m_nodes;				// this represents the entire render frame
-	std::vector<FVertex> m_polyBufferRam;		// dynamic polys
+	std::vector<FVertex> m_polyBufferRam;		// dynamic polys, staging memory only used if the vbo can't be persistently mapped
 	std::vector<FVertex> m_polyBufferRom;		// rom polys
 	std::unordered_map<UINT32, std::shared_ptr<std::vector<Mesh>>> m_romMap;	// a hash table for all the ROM models. The meshes don't have model matrices or tex offsets yet
 	TextureBank			m_textureBank[2];
 
+	// Dynamic polys are written to one of several segments following the ROM data, rotated each frame. If the vbo can be
+	// persistently mapped the vertices are written straight into gpu memory, guarded by a fence per segment.
+	static constexpr int NUM_DYNAMIC_SEGMENTS = 3;
+	FVertex*	m_dynamicVerts;				// write pointer for the current segment
+	int			m_dynamicVertCount;
+	int			m_dynamicSegment;
+	GLsync		m_dynamicFences[NUM_DYNAMIC_SEGMENTS];
+	bool		m_persistentMapped;
+
 	GLuint m_vao;
-	VBO m_vbo;								// large VBO to hold our poly data, start of VBO is ROM data, ram polys follow
+	VBO m_vbo;								// large VBO to hold our poly data, start of VBO is ROM data, ram poly segments follow
 	R3DShader m_r3dShader;
 	R3DScrollFog m_r3dScrollFog;
 	R3DFrameBuffers m_r3dFrameBuffers;
 	GLuint m_aaTarget;						// optional, maybe zero
 
+	// Persistent model cache, loaded on the first VROM model miss once the stepping is known
+	ModelCache	m_modelCache;
+	std::string	m_modelCachePath;			// empty if disabled
+	bool		m_modelCacheLoaded;
+
+	// Multi draw indirect. Per draw state goes in a storage buffer indexed by the instance id of each draw command,
+	// so runs of meshes that only differ in uniforms can be drawn with a single call.
+	struct DrawArraysIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
+	struct DrawBatch
+	{
+		const Node*	node;
+		const Mesh*	mesh;					// first mesh in the batch, all share its stencil state
+		int			first;					// first draw command
+		int			count;
+	};
+
+	bool m_indirectDraw;
+	VBO m_drawDataBuffer;					// shader storage buffer of DrawData
+	VBO m_indirectBuffer;					// draw commands
+	VBO m_drawIDBuffer;						// 0,1,2 .. fed to the shader as an instanced attribute to find its DrawData
+	int m_drawIDCount;
+	std::vector<DrawData>					m_drawData;
+	std::vector<DrawArraysIndirectCommand>	m_drawCommands;
+	std::vector<DrawBatch>					m_drawBatches;
+
+	GLuint	m_uploadQueries[2];				// GL_TIME_ELAPSED queries, double buffered so we never wait on the result
+	int		m_uploadQueryIdx;
+	bool	m_uploadQueryPending[2];
+	UINT32	m_uploadTime;					// microseconds
+
 	struct
 	{
 		float bnlu;
@@ -2,14 +2,34 @@
 #include "R3DShaderQuads.h"
 #include "R3DShaderTriangles.h"
 #include "R3DShaderCommon.h"
+#include "Graphics/Shader.h"
+#include <cstdlib>
+#include <cstring>
 
 // having 2 sets of shaders to maintain is really less than ideal
 // but hopefully not too many breaking changes at this point
 
 namespace New3D {
 
+// Replaces the #version line of a shader (bumping it to at least 4.3) and inserts the draw buffer declarations after it
+static std::string InsertDrawData(const char* source)
+{
+	std::string s(source);
+
+	size_t start	= s.find("#version");
+	size_t end		= s.find('\n', start);
+	int version		= std::atoi(s.c_str() + start + 8);
+
+	if (version < 430) {
+		version = 430;
+	}
+
+	return s.substr(0, start) + "#version " + std::to_string(version) + " core\n" + drawDataR3D + s.substr(end + 1);
+}
+
 R3DShader::R3DShader(const Util::Config::Node &config)
-	: m_config(config)
+	: m_config(config),
+	m_indirectDraw(false)
 {
 	m_shaderProgram		= 0;
 	m_vertexShader		= 0;
@@ -74,34 +94,61 @@ bool R3DShader::LoadShader(const char* vertexShader, const char* fragmentShader)
 		fShader = fragmentShaderR3DQuads;
 	}
 
-	m_shaderProgram		= glCreateProgram();
-	m_vertexShader		= glCreateShader(GL_VERTEX_SHADER);
-	m_fragmentShader	= glCreateShader(GL_FRAGMENT_SHADER);
+	// for indirect drawing the per draw state moves from uniforms to a storage buffer, which needs glsl 4.3
+	std::string vShaderIndirect;
+	std::string gShaderIndirect;
+	std::string fShaderIndirect;
 
-	const char* shaderArray[] = { fShader, fragmentShaderR3DCommon };
+	if (m_indirectDraw) {
+		vShaderIndirect = InsertDrawData(vShader);
+		fShaderIndirect = InsertDrawData(fShader);
+		vShader = vShaderIndirect.c_str();
+		fShader = fShaderIndirect.c_str();
 
-	glShaderSource(m_vertexShader, 1, (const GLchar **)&vShader, nullptr);
-	glShaderSource(m_fragmentShader, (GLsizei)std::size(shaderArray), shaderArray, nullptr);
+		if (quads) {
+			gShaderIndirect = InsertDrawData(gShader);		// only passes the draw id through
+			gShader = gShaderIndirect.c_str();
+		}
+	}
 
-	glCompileShader(m_vertexShader);
-	glCompileShader(m_fragmentShader);
+	UINT64 cacheKey = GetShaderCacheKey({ vShader, gShader, fShader, fragmentShaderR3DCommon });
 
-	if (quads) {
-		m_geoShader = glCreateShader(GL_GEOMETRY_SHADER);
-		glShaderSource(m_geoShader, 1, (const GLchar **)&gShader, nullptr);
-		glCompileShader(m_geoShader);
-		glAttachShader(m_shaderProgram, m_geoShader);
-		PrintShaderResult(m_geoShader);
-	}
+	m_shaderProgram = LoadCachedShaderProgram(cacheKey);
+
+	if (!m_shaderProgram) {
+
+		m_shaderProgram		= glCreateProgram();
+		m_vertexShader		= glCreateShader(GL_VERTEX_SHADER);
+		m_fragmentShader	= glCreateShader(GL_FRAGMENT_SHADER);
+
+		const char* shaderArray[] = { fShader, fragmentShaderR3DCommon };
+
+		glShaderSource(m_vertexShader, 1, (const GLchar **)&vShader, nullptr);
+		glShaderSource(m_fragmentShader, (GLsizei)std::size(shaderArray), shaderArray, nullptr);
+
+		glCompileShader(m_vertexShader);
+		glCompileShader(m_fragmentShader);
+
+		if (quads) {
+			m_geoShader = glCreateShader(GL_GEOMETRY_SHADER);
+			glShaderSource(m_geoShader, 1, (const GLchar **)&gShader, nullptr);
+			glCompileShader(m_geoShader);
+			glAttachShader(m_shaderProgram, m_geoShader);
+			PrintShaderResult(m_geoShader);
+		}
+
+		PrintShaderResult(m_vertexShader);
+		PrintShaderResult(m_fragmentShader);
 
-	PrintShaderResult(m_vertexShader);
-	PrintShaderResult(m_fragmentShader);
+		glAttachShader(m_shaderProgram, m_vertexShader);
+		glAttachShader(m_shaderProgram, m_fragmentShader);
+		PrepareShaderProgramForCache(m_shaderProgram);
+		glLinkProgram(m_shaderProgram);
 
-	glAttachShader(m_shaderProgram, m_vertexShader);
-	glAttachShader(m_shaderProgram, m_fragmentShader);
-	glLinkProgram(m_shaderProgram);
+		PrintProgramResult(m_shaderProgram);
 
-	PrintProgramResult(m_shaderProgram);
+		SaveCachedShaderProgram(m_shaderProgram, cacheKey);
+	}
 
 	m_locTextureBank[0]		= glGetUniformLocation(m_shaderProgram, "textureBank[0]");
 	m_locTextureBank[1]		= glGetUniformLocation(m_shaderProgram, "textureBank[1]");
@@ -320,15 +367,29 @@ void R3DShader::SetMeshUniforms(const Mesh* m)
 		glUniform2iv(m_locTexWrapMode, 1, m_texWrapMode);
 	}
 
-	if (m_dirtyMesh || m->noLosReturn != m_noLosReturn) {
-		m_noLosReturn = m->noLosReturn;
+	SetMeshStencil(m);
+
+	m_dirtyMesh = false;
+}
+
+void R3DShader::SetMeshStencil(const Mesh* m)
+{
+	if (m_dirtyMesh || m->noLosReturn != m_noLosReturn || m->layered != m_layered) {
+		SetStencil(m->layered, m->noLosReturn);
+	}
+}
+
+void R3DShader::SetStencil(bool layered, bool noLosReturn)
+{
+	if (m_dirtyMesh || noLosReturn != m_noLosReturn) {
+		m_noLosReturn = noLosReturn;
 		glStencilFunc(GL_ALWAYS, m_noLosReturn << 7, 0b10000000);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 		glStencilMask(0b10000000);
 	}
 
-	if (m_dirtyMesh || m->layered != m_layered) {
-		m_layered = m->layered;
+	if (m_dirtyMesh || layered != m_layered) {
+		m_layered = layered;
 		// i think it should just disable z write, but the polys I think must be written first
 		if (m_layered) {
 			glStencilFunc(GL_EQUAL, 0, 0b01111111);			// basically stencil test passes if the value is zero
@@ -341,8 +402,41 @@ void R3DShader::SetMeshUniforms(const Mesh* m)
 			glStencilMask(0b10000000);
 		}
 	}
+}
 
-	m_dirtyMesh = false;
+void R3DShader::GetDrawData(const Model* model, const Mesh* m, DrawData& data) const
+{
+	// same values SetModelStates and SetMeshUniforms would write to uniforms
+	std::memcpy(data.modelMat, model->modelMat, sizeof(data.modelMat));
+
+	data.baseTexInfo[0]		= m->x + model->textureOffsetX;
+	data.baseTexInfo[1]		= m->y + model->textureOffsetY;
+	data.baseTexInfo[2]		= m->width;
+	data.baseTexInfo[3]		= m->height;
+	data.textureWrapMode[0]	= (GLint)m->wrapModeU;
+	data.textureWrapMode[1]	= (GLint)m->wrapModeV;
+	data.texturePage		= m->page ^ model->page;
+	data.microTextureID		= m->microTextureID;
+	data.baseTexType		= m->format;
+	data.modelScale			= model->scale;
+	data.nodeAlpha			= model->alpha;
+	data.microTextureMinLOD	= m->microTextureMinLOD;
+	data.fogIntensity		= m->fogIntensity;
+	data.shininess			= m->shininess;
+	data.specularValue		= m->specularValue;
+
+	// bit order must match the macros in drawDataR3D
+	data.flags =	(GLuint)(m->textured		<< 0) |
+					(m->microTexture	<< 1) |
+					(m->inverted		<< 2) |
+					(m->textureAlpha	<< 3) |
+					(m->alphaTest		<< 4) |
+					(m->lighting		<< 5) |
+					(m->specular		<< 6) |
+					(m->fixedShading	<< 7) |
+					(m->smoothShading	<< 8) |
+					(m->translatorMap	<< 9) |
+					(m->polyAlpha		<< 10);
 }
 
 void R3DShader::SetViewportUniforms(const Viewport *vp)
@@ -393,6 +487,16 @@ void R3DShader::SetModelStates(const Model* model)
 	m_dirtyModel = false;
 }
 
+void R3DShader::SetIndirectDraw(bool enable)
+{
+	m_indirectDraw = enable;
+}
+
+bool R3DShader::GetIndirectDraw() const
+{
+	return m_indirectDraw;
+}
+
 void R3DShader::DiscardAlpha(bool discard)
 {
 	glUniform1i(m_locDiscardAlpha, discard);
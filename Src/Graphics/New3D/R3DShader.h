@@ -9,12 +9,35 @@
 
 namespace New3D {
 
+// Per draw state read by the shaders from a storage buffer when multi draw indirect is used.
+// Must match the std430 layout of DrawData in R3DShaderCommon.h
+struct DrawData
+{
+	float	modelMat[16];
+	GLint	baseTexInfo[4];
+	GLint	textureWrapMode[2];
+	GLint	texturePage;
+	GLint	microTextureID;
+	GLint	baseTexType;
+	GLuint	flags;
+	float	modelScale;
+	float	nodeAlpha;
+	float	microTextureMinLOD;
+	float	fogIntensity;
+	float	shininess;
+	float	specularValue;
+};
+
+static_assert(sizeof(DrawData) == 128, "DrawData must match std430 layout");
+
 class R3DShader
 {
 public:
 	R3DShader(const Util::Config::Node &config);
 
 	bool	LoadShader			(const char* vertexShader = nullptr, const char* fragmentShader = nullptr);
+	void	SetIndirectDraw		(bool enable);				// must be set before LoadShader
+	bool	GetIndirectDraw		() const;
 	void	UnloadShader		();
 	void	SetMeshUniforms		(const Mesh* m);
 	void	SetModelStates		(const Model* model);
@@ -24,14 +47,19 @@ public:
 	GLint	GetVertexAttribPos	(const std::string& attrib);
 	void	DiscardAlpha		(bool discard);				// use to remove alpha from texture alpha only polys for 1st pass
 	void	SetLayer			(Layer layer);
+	void	SetMeshStencil		(const Mesh* m);			// the only mesh state that can't go in the draw buffer
+	void	GetDrawData			(const Model* model, const Mesh* m, DrawData& data) const;
 
 private:
 
+	void SetStencil(bool layered, bool noLosReturn);
+
 	void PrintShaderResult(GLuint shader);
 	void PrintProgramResult(GLuint program);
 
 	// run-time config
 	const Util::Config::Node &m_config;
+	bool m_indirectDraw;
 
 	// shader IDs
 	GLuint m_shaderProgram;
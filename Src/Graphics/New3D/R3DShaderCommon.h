@@ -197,6 +197,19 @@ vec4 texBiLinear(usampler2D texSampler, ivec2 wrapMode, vec2 texSize, ivec2 texP
 	return mix( pInterp_q0, pInterp_q1, b ); // Interpolate in Y direction.
 }
 
+// sampler arrays can only be indexed with dynamically uniform values, which the page isn't when it comes from the draw buffer
+vec4 texBiLinearPage(int page, ivec2 wrapMode, vec2 texSize, ivec2 texPos, vec2 texCoord, int level)
+{
+#ifdef INDIRECT_DRAW
+	if (page == 0) {
+		return texBiLinear(textureBank[0], wrapMode, texSize, texPos, texCoord, level);
+	}
+	return texBiLinear(textureBank[1], wrapMode, texSize, texPos, texCoord, level);
+#else
+	return texBiLinear(textureBank[page], wrapMode, texSize, texPos, texCoord, level);
+#endif
+}
+
 vec4 GetTextureValue()
 {
 	float lod = -log2(gl_FragCoord.w * gl_FragCoord.w * fsLODBase);
@@ -207,7 +220,7 @@ vec4 GetTextureValue()
 
 	ivec2 tex1Pos = GetTexturePosition(iLevel, baseTexInfo.xy);
 	ivec2 tex1Size = GetTextureSize(iLevel, baseTexInfo.zw);
-	vec4 tex1Data = texBiLinear(textureBank[texturePage], textureWrapMode, vec2(tex1Size), tex1Pos, fsTexCoord, iLevel);
+	vec4 tex1Data = texBiLinearPage(texturePage, textureWrapMode, vec2(tex1Size), tex1Pos, fsTexCoord, iLevel);
 
 	// init second texel with blank data to avoid any potentially undefined behavior
 	vec4 tex2Data = vec4(0.0);
@@ -221,7 +234,7 @@ vec4 GetTextureValue()
 	{
 		ivec2 tex2Pos = GetTexturePosition(iLevel+1, baseTexInfo.xy);
 		ivec2 tex2Size = GetTextureSize(iLevel+1, baseTexInfo.zw);
-		tex2Data = texBiLinear(textureBank[texturePage], textureWrapMode, vec2(tex2Size), tex2Pos, fsTexCoord, iLevel+1);
+		tex2Data = texBiLinearPage(texturePage, textureWrapMode, vec2(tex2Size), tex2Pos, fsTexCoord, iLevel+1);
 
 		blendFactor = ffL;
 	}
@@ -232,7 +245,7 @@ vec4 GetTextureValue()
 
 		// microtextures are always 128x128 and only use LOD 0 mipmap
 		ivec2 tex2Pos = GetMicroTexturePos(microTextureID);
-		tex2Data = texBiLinear(textureBank[(texturePage+1)&1], ivec2(0), ivec2(128), tex2Pos, fsTexCoord * scale, 0);
+		tex2Data = texBiLinearPage((texturePage+1)&1, ivec2(0), vec2(128), tex2Pos, fsTexCoord * scale, 0);
 
 		blendFactor = -lod * exp2(-microTextureMinLOD) * 0.5;
 		blendFactor = min(blendFactor, 0.5);
@@ -372,3 +385,59 @@ void WriteOutputs(vec4 colour, int layer)
 }
 
 )glsl";
+
+// Per draw state for multi draw indirect rendering. This is inserted straight after the #version line of the vertex and fragment
+// shaders when indirect drawing is enabled. Each stage defines DRAW to index the buffer with its own copy of the draw id.
+// Layout must match the DrawData struct in R3DShader.h
+
+static const char* drawDataR3D = R"glsl(
+#define INDIRECT_DRAW
+
+struct DrawData
+{
+	mat4	modelMat;
+	ivec4	baseTexInfo;
+	ivec2	textureWrapMode;
+	int		texturePage;
+	int		microTextureID;
+	int		baseTexType;
+	uint	flags;
+	float	modelScale;
+	float	nodeAlpha;
+	float	microTextureMinLOD;
+	float	fogIntensity;
+	float	shininess;
+	float	specularValue;
+};
+
+layout(std430, binding = 0) readonly buffer DrawBuffer
+{
+	DrawData draws[];
+};
+
+#define modelMat			DRAW.modelMat
+#define baseTexInfo			DRAW.baseTexInfo
+#define textureWrapMode		DRAW.textureWrapMode
+#define texturePage			DRAW.texturePage
+#define microTextureID		DRAW.microTextureID
+#define baseTexType			DRAW.baseTexType
+#define modelScale			DRAW.modelScale
+#define nodeAlpha			DRAW.nodeAlpha
+#define microTextureMinLOD	DRAW.microTextureMinLOD
+#define fogIntensity		DRAW.fogIntensity
+#define shininess			DRAW.shininess
+#define specularValue		DRAW.specularValue
+
+#define textureEnabled		((DRAW.flags & 0x001u) != 0u)
+#define microTexture		((DRAW.flags & 0x002u) != 0u)
+#define textureInverted		((DRAW.flags & 0x004u) != 0u)
+#define textureAlpha		((DRAW.flags & 0x008u) != 0u)
+#define alphaTest			((DRAW.flags & 0x010u) != 0u)
+#define lightEnabled		((DRAW.flags & 0x020u) != 0u)
+#define specularEnabled		((DRAW.flags & 0x040u) != 0u)
+#define fixedShading		((DRAW.flags & 0x080u) != 0u)
+#define smoothShading		((DRAW.flags & 0x100u) != 0u)
+#define translatorMap		((DRAW.flags & 0x200u) != 0u)
+#define polyAlpha			((DRAW.flags & 0x400u) != 0u)
+
+)glsl";
@@ -6,12 +6,18 @@ static const char* vertexShaderR3DQuads = R"glsl(
 #version 450 core
 
 // uniforms
+uniform float	cota;
+uniform mat4	projMat;
+
+#ifdef INDIRECT_DRAW
+in int		inDrawID;			// index into draw buffer, instanced attribute offset by base instance
+#define DRAW draws[inDrawID]
+#else
 uniform float	modelScale;
 uniform float	nodeAlpha;
-uniform float	cota;
 uniform mat4	modelMat;
-uniform mat4	projMat;
 uniform bool	translatorMap;
+#endif
 
 // attributes
 in vec4		inVertex;
@@ -33,6 +39,9 @@ out VS_OUT
 	float	fixedShade;
 	float	discardPoly;	// can't have varying bool (glsl spec)
 	float	LODBase;
+#ifdef INDIRECT_DRAW
+	flat int drawID;
+#endif
 } vs_out;
 
 vec4 GetColour(vec4 colour)
@@ -67,6 +76,9 @@ void main(void)
 	vs_out.fixedShade	= inFixedShade;
 	vs_out.LODBase		= vs_out.discardPoly * -cota * inTextureNP;
 	gl_Position			= (projMat * modelMat) * inVertex;
+#ifdef INDIRECT_DRAW
+	vs_out.drawID		= inDrawID;
+#endif
 }
 )glsl";
 
@@ -86,6 +98,9 @@ in VS_OUT
 	float	fixedShade;
 	float	discardPoly;	// can't have varying bool (glsl spec)
 	float	LODBase;
+#ifdef INDIRECT_DRAW
+	flat int drawID;
+#endif
 } gs_in[4];
 
 out GS_OUT
@@ -101,6 +116,9 @@ out GS_OUT
 	flat vec4	color;
 	flat float	fixedShade[4];
 	flat float	LODBase;
+#ifdef INDIRECT_DRAW
+	flat int	drawID;
+#endif
 	vec3 barycentricCoords;
 } gs_out;
 
@@ -136,6 +154,9 @@ void main(void)
 	// flat attributes
 	gs_out.color = gs_in[0].color;
 	gs_out.LODBase = gs_in[0].LODBase;
+#ifdef INDIRECT_DRAW
+	gs_out.drawID = gs_in[0].drawID;
+#endif
 
 	// precompute crossproducts for all vertex combinations to be looked up in loop below for area computation
 	precise float cross[4][4];
@@ -195,6 +216,9 @@ static const char* fragmentShaderR3DQuads = R"glsl(
 uniform usampler2D textureBank[2];			// entire texture sheet
 
 // texturing
+uniform bool	discardAlpha;
+
+#ifndef INDIRECT_DRAW
 uniform bool	textureEnabled;
 uniform bool	microTexture;
 uniform float	microTextureMinLOD;
@@ -204,9 +228,9 @@ uniform int		baseTexType;
 uniform bool	textureInverted;
 uniform bool	textureAlpha;
 uniform bool	alphaTest;
-uniform bool	discardAlpha;
 uniform ivec2	textureWrapMode;
 uniform int		texturePage;
+#endif
 
 // general
 uniform vec3	fogColour;
@@ -215,22 +239,25 @@ uniform vec2	spotRange;			// spotlight Z range: .x=start (viewspace coordinates)
 uniform vec3	spotColor;			// spotlight RGB color
 uniform vec3	spotFogColor;		// spotlight RGB color on fog
 uniform vec3	lighting[2];		// lighting state (lighting[0] = sun direction, lighting[1].x,y = diffuse, ambient intensities from 0-1.0)
-uniform bool	lightEnabled;		// lighting enabled (1.0) or luminous (0.0), drawn at full intensity
 uniform bool	sunClamp;			// not used by daytona and la machine guns
 uniform bool	intensityClamp;		// some games such as daytona and 
-uniform bool	specularEnabled;	// specular enabled
-uniform float	specularValue;		// specular coefficient
-uniform float	shininess;			// specular shininess
-uniform float	fogIntensity;
 uniform float	fogDensity;
 uniform float	fogStart;
 uniform float	fogAttenuation;
 uniform float	fogAmbient;
-uniform bool	fixedShading;
-uniform bool	smoothShading;
 uniform int		hardwareStep;
 uniform int		colourLayer;
+
+#ifndef INDIRECT_DRAW
+uniform bool	lightEnabled;		// lighting enabled (1.0) or luminous (0.0), drawn at full intensity
+uniform bool	specularEnabled;	// specular enabled
+uniform float	specularValue;		// specular coefficient
+uniform float	shininess;			// specular shininess
+uniform float	fogIntensity;
+uniform bool	fixedShading;
+uniform bool	smoothShading;
 uniform bool	polyAlpha;
+#endif
 
 // matrices (shared with vertex shader)
 uniform mat4	projMat;
@@ -250,8 +277,14 @@ in GS_OUT
 	flat vec4	color;
 	flat float	fixedShade[4];
 	flat float	LODBase;
+#ifdef INDIRECT_DRAW
+	flat int	drawID;
+#endif
 	vec3 barycentricCoords;
 } fs_in;
+#ifdef INDIRECT_DRAW
+#define DRAW draws[fs_in.drawID]
+#endif
 
 //our calculated vertex attributes from the above
 vec3	fsViewVertex;
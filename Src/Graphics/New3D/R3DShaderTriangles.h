@@ -6,12 +6,18 @@ static const char *vertexShaderR3D = R"glsl(
 #version 410 core
 
 // uniforms
+uniform float	cota;
+uniform mat4	projMat;
+
+#ifdef INDIRECT_DRAW
+in int		inDrawID;			// index into draw buffer, instanced attribute offset by base instance
+#define DRAW draws[inDrawID]
+#else
 uniform float	modelScale;
 uniform float	nodeAlpha;
-uniform float	cota;
 uniform mat4	modelMat;
-uniform mat4	projMat;
 uniform bool	translatorMap;
+#endif
 
 // attributes
 in vec4		inVertex;
@@ -30,6 +36,9 @@ out vec4	fsColor;
 out float	fsFixedShade;
 out float	fsDiscardPoly;		// can't have varying bool (glsl spec)
 out float	fsLODBase;
+#ifdef INDIRECT_DRAW
+flat out int fsDrawID;
+#endif
 
 vec4 GetColour(vec4 colour)
 {
@@ -63,6 +72,9 @@ void main(void)
 	fsFixedShade	= inFixedShade;
 	fsLODBase		= fsDiscardPoly * -cota * inTextureNP;
 	gl_Position		= (projMat * modelMat) * inVertex;
+#ifdef INDIRECT_DRAW
+	fsDrawID		= inDrawID;
+#endif
 }
 )glsl";
 
@@ -73,6 +85,9 @@ static const char *fragmentShaderR3D = R"glsl(
 uniform usampler2D textureBank[2];			// entire texture sheet
 
 // texturing
+uniform bool	discardAlpha;
+
+#ifndef INDIRECT_DRAW
 uniform bool	textureEnabled;
 uniform bool	microTexture;
 uniform float	microTextureMinLOD;
@@ -82,9 +97,9 @@ uniform int		baseTexType;
 uniform bool	textureInverted;
 uniform bool	textureAlpha;
 uniform bool	alphaTest;
-uniform bool	discardAlpha;
 uniform ivec2	textureWrapMode;
 uniform int		texturePage;
+#endif
 
 // general
 uniform vec3	fogColour;
@@ -93,22 +108,25 @@ uniform vec2	spotRange;			// spotlight Z range: .x=start (viewspace coordinates)
 uniform vec3	spotColor;			// spotlight RGB color
 uniform vec3	spotFogColor;		// spotlight RGB color on fog
 uniform vec3	lighting[2];		// lighting state (lighting[0] = sun direction, lighting[1].x,y = diffuse, ambient intensities from 0-1.0)
-uniform bool	lightEnabled;		// lighting enabled (1.0) or luminous (0.0), drawn at full intensity
 uniform bool	sunClamp;			// not used by daytona and la machine guns
 uniform bool	intensityClamp;		// some games such as daytona and 
-uniform bool	specularEnabled;	// specular enabled
-uniform float	specularValue;		// specular coefficient
-uniform float	shininess;			// specular shininess
-uniform float	fogIntensity;
 uniform float	fogDensity;
 uniform float	fogStart;
 uniform float	fogAttenuation;
 uniform float	fogAmbient;
-uniform bool	fixedShading;
-uniform bool	smoothShading;
 uniform int		hardwareStep;
 uniform int		colourLayer;
+
+#ifndef INDIRECT_DRAW
+uniform bool	lightEnabled;		// lighting enabled (1.0) or luminous (0.0), drawn at full intensity
+uniform bool	specularEnabled;	// specular enabled
+uniform float	specularValue;		// specular coefficient
+uniform float	shininess;			// specular shininess
+uniform float	fogIntensity;
+uniform bool	fixedShading;
+uniform bool	smoothShading;
 uniform bool	polyAlpha;
+#endif
 
 // matrices (shared with vertex shader)
 uniform mat4	projMat;
@@ -121,6 +139,10 @@ in vec4		fsColor;
 in float	fsFixedShade;
 in float	fsDiscardPoly;
 in float	fsLODBase;
+#ifdef INDIRECT_DRAW
+flat in int	fsDrawID;
+#define DRAW draws[fsDrawID]
+#endif
 
 //outputs
 layout(location = 0) out vec4 out0;		// opaque
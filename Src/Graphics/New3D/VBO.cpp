@@ -4,8 +4,10 @@ VBO::VBO()
 {
 	m_id		= 0;
 	m_target	= 0;
+	m_usage		= 0;
 	m_capacity	= 0;
 	m_size		= 0;
+	m_mapped	= nullptr;
 }
 
 void VBO::Create(GLenum target, GLenum usage, GLsizeiptr size, const void* data)
@@ -15,12 +17,48 @@ void VBO::Create(GLenum target, GLenum usage, GLsizeiptr size, const void* data)
 	glBufferData(target, size, data, usage);		// upload data to video card
 
 	m_target	= target;
+	m_usage		= usage;
 	m_capacity	= (int)size;
 	m_size		= 0;
 
 	Bind(false);		// unbind
 }
 
+bool VBO::CreatePersistent(GLenum target, GLsizeiptr size, GLintptr mapOffset, GLsizeiptr mapSize)
+{
+	if (!GLEW_ARB_buffer_storage) {
+		return false;
+	}
+
+	const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &m_id);
+	glBindBuffer(target, m_id);
+	glBufferStorage(target, size, nullptr, mapFlags | GL_DYNAMIC_STORAGE_BIT);		// dynamic storage so the rest of the buffer can still be filled with BufferSubData
+
+	m_target	= target;
+	m_capacity	= (int)size;
+	m_size		= 0;
+	m_mapped	= glMapBufferRange(target, mapOffset, mapSize, mapFlags);
+
+	Bind(false);
+
+	if (!m_mapped) {
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void VBO::BufferData(GLsizeiptr size, const GLvoid* data)
+{
+	glBufferData(m_target, size, data, m_usage);
+
+	m_capacity	= (int)size;
+	m_size		= 0;
+}
+
 void VBO::BufferSubData(GLintptr offset, GLsizeiptr size, const GLvoid* data)
 {
 	glBufferSubData(m_target, offset, size, data);
@@ -51,6 +89,12 @@ void VBO::Reset()
 void VBO::Destroy()
 {
 	if (m_id) {
+		if (m_mapped) {
+			glBindBuffer(m_target, m_id);
+			glUnmapBuffer(m_target);
+			glBindBuffer(m_target, 0);
+			m_mapped = nullptr;
+		}
 		glDeleteBuffers(1, &m_id);
 		m_id		= 0;
 		m_target	= 0;
@@ -69,6 +113,11 @@ void VBO::Bind(bool enable)
 	}
 }
 
+void VBO::BindBase(GLuint index)
+{
+	glBindBufferBase(m_target, index, m_id);
+}
+
 int VBO::GetSize() const
 {
 	return m_size;
@@ -78,3 +127,8 @@ int VBO::GetCapacity() const
 {
 	return m_capacity;
 }
+
+void* VBO::GetMappedPtr() const
+{
+	return m_mapped;
+}
@@ -9,19 +9,25 @@ public:
 	VBO();
 
 	void Create			(GLenum target, GLenum usage, GLsizeiptr size, const void* data=nullptr);
+	bool CreatePersistent(GLenum target, GLsizeiptr size, GLintptr mapOffset, GLsizeiptr mapSize);	// immutable storage with a persistently mapped write range. Returns false if not supported
+	void BufferData		(GLsizeiptr size, const GLvoid* data);		// orphans the old storage, buffer must be bound
 	void BufferSubData	(GLintptr offset, GLsizeiptr size, const GLvoid* data);
 	bool AppendData		(GLsizeiptr size, const GLvoid* data);
 	void Reset			();		// don't delete data, just go back to start
 	void Destroy		();
 	void Bind			(bool enable);
+	void BindBase		(GLuint index);		// for indexed targets such as shader storage buffers
 	int  GetSize		() const;
 	int  GetCapacity	() const;
+	void* GetMappedPtr	() const;	// start of persistently mapped range, or null
 
 private:
 	GLuint		m_id;
 	GLenum		m_target;
+	GLenum		m_usage;
 	int			m_capacity;
 	int			m_size;
+	void*		m_mapped;
 };
 
 #endif
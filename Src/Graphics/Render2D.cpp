@@ -322,7 +322,7 @@ void CRender2D::Setup2D(bool isBottom)
 	}
 
 	// Set up the viewport and orthogonal projection
-	bool stretchBottom = m_config["WideBackground"].ValueAs<bool>() && isBottom;
+	bool stretchBottom = m_wideBackground.Value() && isBottom;
 	if (!stretchBottom)
 	{
 		glViewport(m_xOffset - m_correction, m_yOffset + m_correction, m_xPixels, m_yPixels); //Preserve aspect ratio of tile layer by constraining and centering viewport
@@ -455,6 +455,7 @@ Result CRender2D::Init(unsigned xOffset, unsigned yOffset, unsigned xRes, unsign
 
 CRender2D::CRender2D(const Util::Config::Node& config)
 	: m_config(config),
+	m_wideBackground(config, "WideBackground"),
 	m_vao(0)
 {
 	glGenVertexArrays(1, &m_vao);
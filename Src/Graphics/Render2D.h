@@ -193,6 +193,7 @@ private:
 
 	// Run-time configuration
 	const Util::Config::Node& m_config;
+	Util::Config::Handle<bool> m_wideBackground;
 
 	// OpenGL data
 	unsigned  m_xPixels = 496;  // display surface resolution
@@ -44,8 +44,11 @@
 
 #include <new>
 #include <cstdio>
+#include <cstring>
+#include <vector>
 #include <GL/glew.h>
 #include "Supermodel.h"
+#include "Util/Format.h"
 
 
 // Load a source file. Pointer returned must be freed by caller. Returns NULL if failed.
@@ -89,12 +92,175 @@ static char *LoadShaderSource(const char *file)
 	return buf;
 }
 
+/******************************************************************************
+ Program Binary Cache
+******************************************************************************/
+
+static const char	SHADER_CACHE_MAGIC[8]	= { 'S','M','S','H','A','D','E','R' };
+static const UINT32	SHADER_CACHE_VERSION	= 1;
+
+struct ShaderCacheHeader
+{
+	char	magic[8];
+	UINT32	version;
+	UINT32	format;		// driver specific binary format
+	UINT64	key;
+	UINT32	length;
+	UINT32	reserved;
+};
+
+static std::string	s_shaderCacheDir;
+static bool			s_shaderCacheEnabled = false;
+
+static UINT64 HashString(UINT64 hash, const char *str)
+{
+	// FNV-1a
+	for (const unsigned char *p = (const unsigned char *) str; *p; p++)
+	{
+		hash ^= *p;
+		hash *= 0x100000001B3ULL;
+	}
+
+	hash ^= 0xFF;	// separator so "ab","c" and "a","bc" don't collide
+	hash *= 0x100000001B3ULL;
+	return hash;
+}
+
+static std::string ShaderCacheFile(UINT64 key)
+{
+	char name[32];
+	sprintf(name, "Shader_%016llx.bin", (unsigned long long) key);
+	return s_shaderCacheDir + name;
+}
+
+void SetShaderCacheDirectory(const std::string &dir)
+{
+	s_shaderCacheDir = dir;
+	s_shaderCacheEnabled = false;
+
+	if (dir.empty() || !GLEW_ARB_get_program_binary)
+		return;
+
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	s_shaderCacheEnabled = numFormats > 0;	// some drivers expose the extension but can't actually save anything
+}
+
+UINT64 GetShaderCacheKey(std::initializer_list<const char *> sources)
+{
+	UINT64 hash = 0xCBF29CE484222325ULL;
+
+	// binaries are only valid for the exact driver that produced them
+	const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (GLenum name: strings)
+	{
+		const char *str = (const char *) glGetString(name);
+		hash = HashString(hash, str ? str : "");
+	}
+
+	for (const char *source: sources)
+		hash = HashString(hash, source ? source : "");
+
+	return hash;
+}
+
+GLuint LoadCachedShaderProgram(UINT64 key)
+{
+	if (!s_shaderCacheEnabled)
+		return 0;
+
+	std::string file = ShaderCacheFile(key);
+	FILE *fp = fopen(file.c_str(), "rb");
+	if (nullptr == fp)
+		return 0;
+
+	ShaderCacheHeader header;
+	std::vector<char> binary;
+	bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+			  memcmp(header.magic, SHADER_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+			  header.version == SHADER_CACHE_VERSION &&
+			  header.key == key &&
+			  header.length > 0;
+	if (ok)
+	{
+		binary.resize(header.length);
+		ok = fread(binary.data(), header.length, 1, fp) == 1;
+	}
+	fclose(fp);
+
+	GLuint program = 0;
+	if (ok)
+	{
+		GLint result = GL_FALSE;
+		program = glCreateProgram();
+		glProgramBinary(program, header.format, binary.data(), header.length);
+		glGetProgramiv(program, GL_LINK_STATUS, &result);
+		ok = result == GL_TRUE;		// fails if the driver has changed in a way the key didn't catch
+	}
+
+	if (!ok)
+	{
+		if (program)
+			glDeleteProgram(program);
+		remove(file.c_str());		// stale, will be rebuilt from source
+		return 0;
+	}
+
+	return program;
+}
+
+void PrepareShaderProgramForCache(GLuint shaderProgram)
+{
+	if (s_shaderCacheEnabled)
+		glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void SaveCachedShaderProgram(GLuint shaderProgram, UINT64 key)
+{
+	if (!s_shaderCacheEnabled)
+		return;
+
+	GLint result = GL_FALSE, length = 0;
+	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &result);
+	glGetProgramiv(shaderProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (result != GL_TRUE || length <= 0)
+		return;
+
+	ShaderCacheHeader header = {};
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(shaderProgram, length, &length, &format, binary.data());
+
+	memcpy(header.magic, SHADER_CACHE_MAGIC, sizeof(header.magic));
+	header.version = SHADER_CACHE_VERSION;
+	header.format = format;
+	header.key = key;
+	header.length = length;
+
+	std::string file = ShaderCacheFile(key);
+	FILE *fp = fopen(file.c_str(), "wb");
+	if (nullptr == fp)
+		return;
+
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+			  fwrite(binary.data(), length, 1, fp) == 1;
+	ok = (fclose(fp) == 0) && ok;
+	if (!ok)
+		remove(file.c_str());	// don't leave a truncated binary behind
+}
+
+
+/******************************************************************************
+ Shader Programs
+******************************************************************************/
+
 Result LoadShaderProgram(GLuint *shaderProgramPtr, GLuint *vertexShaderPtr, GLuint *fragmentShaderPtr, const std::string& vsFile, const std::string& fsFile, const char *vsString, const char *fsString)
 {
 	char		infoLog[2048];
 	const char	*vsSource, *fsSource;	// source code
 	GLuint		shaderProgram, vertexShader, fragmentShader;
 	GLint		result, len;
+	UINT64		cacheKey;
 	Result		ret = Result::OKAY;
 	
 	// Load shaders from files if specified
@@ -120,6 +286,18 @@ Result LoadShaderProgram(GLuint *shaderProgramPtr, GLuint *vertexShaderPtr, GLui
 		goto Quit;
 	}
 	
+	// Use a cached binary if we have one for exactly this source and driver
+	cacheKey = GetShaderCacheKey({ vsSource, fsSource });
+	shaderProgram = LoadCachedShaderProgram(cacheKey);
+	if (shaderProgram)
+	{
+		*shaderProgramPtr	= shaderProgram;
+		*vertexShaderPtr	= 0;
+		*fragmentShaderPtr	= 0;
+		glUseProgram(shaderProgram);
+		goto Quit;
+	}
+
 	// Create the shaders and shader program
 	shaderProgram	= glCreateProgram();
 	vertexShader	= glCreateShader(GL_VERTEX_SHADER);
@@ -153,6 +331,7 @@ Result LoadShaderProgram(GLuint *shaderProgramPtr, GLuint *vertexShaderPtr, GLui
 	// Link
 	glAttachShader(shaderProgram, vertexShader);
 	glAttachShader(shaderProgram, fragmentShader);
+	PrepareShaderProgramForCache(shaderProgram);
 	glLinkProgram(shaderProgram);
 	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &result);
 	if (result == GL_FALSE)
@@ -161,6 +340,8 @@ Result LoadShaderProgram(GLuint *shaderProgramPtr, GLuint *vertexShaderPtr, GLui
 		ErrorLog("Failed to link shader objects. Your OpenGL driver said:\n%s\n", infoLog);
 		ret = Result::FAIL;	// error
 	}
+	else if (ret == Result::OKAY)
+		SaveCachedShaderProgram(shaderProgram, cacheKey);
 
 	// Enable the shader (if no errors)
 	if (ret == Result::OKAY)
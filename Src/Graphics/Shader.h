@@ -30,6 +30,7 @@
 
 #include <GL/glew.h>
 #include <string>
+#include <initializer_list>
 #include "Types.h"
 
 /*
@@ -58,6 +59,65 @@ extern Result LoadShaderProgram(GLuint *shaderProgramPtr, GLuint *vertexShaderPt
 							  const std::string& fsFile, const char *vsString,
 							  const char *fsString);
 
+/*
+ * SetShaderCacheDirectory(dir):
+ *
+ * Enables caching of linked shader program binaries. Must be called with a
+ * current OpenGL context. Does nothing if the driver can't save program
+ * binaries.
+ *
+ * Parameters:
+ *		dir		Directory (with trailing separator) to store binaries in. An
+ *				empty string disables the cache.
+ */
+extern void SetShaderCacheDirectory(const std::string &dir);
+
+/*
+ * GetShaderCacheKey(sources):
+ *
+ * Computes the cache key for a shader program. Includes the OpenGL vendor,
+ * renderer and version strings, so binaries from another driver never match.
+ *
+ * Parameters:
+ *		sources		Every source string that goes into the program, in order.
+ *					Configuration defines must be part of these.
+ *
+ * Returns:
+ *		64-bit key.
+ */
+extern UINT64 GetShaderCacheKey(std::initializer_list<const char *> sources);
+
+/*
+ * LoadCachedShaderProgram(key):
+ *
+ * Creates a shader program from a cached binary. A binary the driver rejects
+ * is deleted so it gets rebuilt from source.
+ *
+ * Parameters:
+ *		key		Key from GetShaderCacheKey().
+ *
+ * Returns:
+ *		Linked program handle, or 0 if there is no usable binary and the
+ *		program must be compiled normally.
+ */
+extern GLuint LoadCachedShaderProgram(UINT64 key);
+
+/*
+ * PrepareShaderProgramForCache(shaderProgram):
+ *
+ * Must be called before glLinkProgram() for programs that will be saved with
+ * SaveCachedShaderProgram().
+ */
+extern void PrepareShaderProgramForCache(GLuint shaderProgram);
+
+/*
+ * SaveCachedShaderProgram(shaderProgram, key):
+ *
+ * Writes the binary of a successfully linked program to the cache. Programs
+ * that failed to link are not saved.
+ */
+extern void SaveCachedShaderProgram(GLuint shaderProgram, UINT64 key);
+
 /*
  * DestroyShaderProgram(shaderProgram, vertexShader, fragmentShader):
  *
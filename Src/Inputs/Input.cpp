@@ -31,6 +31,8 @@
 #include "Supermodel.h"
 #include "InputSystem.h"
 
+unsigned CInput::s_sourceGeneration = 0;
+
 CInput::CInput(const char *inputId, const char *inputLabel, unsigned inputFlags, unsigned inputGameFlags, const char *defaultMapping, UINT16 initValue) : 
 	m_defaultMapping(defaultMapping), m_system(NULL), m_source(NULL),
 	id(inputId), label(inputLabel), flags(inputFlags), gameFlags(inputGameFlags), value(initValue), prevValue(initValue)
@@ -50,6 +52,7 @@ void CInput::CreateSource()
 	// If already have a source, then release it now
 	if (m_source != NULL)
 		m_source->Release();
+	s_sourceGeneration++;
 
 	// If no system set yet or mapping is empty or NONE, then set source to NULL
 	if (m_system == NULL || m_mapping[0] == '\0' || stricmp(m_mapping, "NONE") == 0)
@@ -209,6 +212,17 @@ bool CInput::Changed() const
 	return value != prevValue;
 }
 
+void CInput::RecordValues(std::vector<UINT16> *values) const
+{
+	values->push_back(value);
+}
+
+const UINT16 *CInput::ReplayValues(const UINT16 *values)
+{
+	value = *values++;
+	return values;
+}
+
 bool CInput::SendForceFeedbackCmd(ForceFeedbackCmd ffCmd)
 {
 	if (m_source == NULL)
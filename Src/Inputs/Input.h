@@ -34,6 +34,7 @@
 #include "Game.h"
 #include "Util/NewConfig.h"
 #include <memory>
+#include <vector>
 
 class CInputSystem;
 
@@ -77,6 +78,9 @@ private:
 	// Assigned input system
 	std::shared_ptr<CInputSystem> m_system;
 
+	// Bumped whenever any input gets a new source
+	static unsigned s_sourceGeneration;
+
 	/*
 	 * Creates an input source using the current input system and assigns it to this input.
 	 */
@@ -133,6 +137,16 @@ public:
 	 */
 	const char* GetMapping();
 
+	/*
+	 * Returns the input source parsed from the current mapping(s), or NULL if there is none.
+	 */
+	CInputSource *GetSource() const;
+
+	/*
+	 * Returns a number that changes whenever the source of any input is created or cleared.
+	 */
+	static unsigned GetSourceGeneration();
+
 	/*
 	 * Clears the current mapping(s) assigned to this input.
 	 */
@@ -199,6 +213,17 @@ public:
 	 */
 	bool Changed() const;
 
+	/*
+	 * Appends the value(s) read by the emulator from this input to a recording of inputs.
+	 */
+	virtual void RecordValues(std::vector<UINT16> *values) const;
+
+	/*
+	 * Sets the value(s) of this input from a recording made by RecordValues(), overriding the polled value(s).
+	 * Returns a pointer past the values used.
+	 */
+	virtual const UINT16 *ReplayValues(const UINT16 *values);
+
 	/*
 	 * Sends a force feedback command to the input source of this input.
 	 */
@@ -209,6 +234,16 @@ public:
 // Inlined methods
 //
 
+inline CInputSource *CInput::GetSource() const
+{
+	return m_source;
+}
+
+inline unsigned CInput::GetSourceGeneration()
+{
+	return s_sourceGeneration;
+}
+
 inline bool CInput::IsUIInput() const
 {
 	return gameFlags == Game::INPUT_UI;
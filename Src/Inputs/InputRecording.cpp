@@ -0,0 +1,238 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free 
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+/*
+ * InputRecording.cpp
+ *
+ * Implementation of CInputRecording. Recordings are block files with the
+ * following blocks:
+ *
+ *  "Supermodel Input Recording"  File version and game name.
+ *  "Inputs"                      Number of inputs, their identifiers and the
+ *                                number of values recorded for each frame.
+ *  "Start State"                 Size and contents of the save state image.
+ *  "Frames"                      Number of frames and, for each, the input
+ *                                values followed by the RAM hash.
+ */
+
+#include "InputRecording.h"
+#include "BlockFile.h"
+#include "Supermodel.h"
+#include <cstring>
+
+static const int32_t INPUT_RECORDING_VERSION = 1;
+
+static size_t CountValues(const std::vector<std::shared_ptr<CInput>> &inputs)
+{
+	std::vector<UINT16> values;
+	for (auto &input : inputs)
+		input->RecordValues(&values);
+	return values.size();
+}
+
+void CInputRecording::Start(const std::string &gameName, std::vector<std::shared_ptr<CInput>> inputs, std::vector<uint8_t> startState)
+{
+	m_gameName = gameName;
+	m_inputs = std::move(inputs);
+	m_valuesPerFrame = CountValues(m_inputs);
+	m_startState = std::move(startState);
+	m_values.clear();
+	m_hashes.clear();
+	m_frame = 0;
+	m_firstMismatch = -1;
+}
+
+Result CInputRecording::Load(const std::string &file, const std::string &gameName, std::vector<std::shared_ptr<CInput>> inputs)
+{
+	CBlockFile recording;
+	if (Result::OKAY != recording.Load(file))
+	{
+		ErrorLog("Unable to load input recording from '%s'.", file.c_str());
+		return Result::FAIL;
+	}
+
+	int32_t fileVersion = 0;
+	char name[64] = { 0 };
+	if (Result::OKAY != recording.FindBlock("Supermodel Input Recording"))
+	{
+		ErrorLog("'%s' does not appear to be a valid input recording.", file.c_str());
+		return Result::FAIL;
+	}
+	recording.Read(&fileVersion, sizeof(fileVersion));
+	recording.Read(name, sizeof(name) - 1);
+	if (fileVersion != INPUT_RECORDING_VERSION)
+	{
+		ErrorLog("'%s' is incompatible with this version of Supermodel.", file.c_str());
+		return Result::FAIL;
+	}
+	if (gameName != name)
+	{
+		ErrorLog("'%s' is a recording of '%s', not '%s'.", file.c_str(), name, gameName.c_str());
+		return Result::FAIL;
+	}
+
+	// The same inputs must be read in the same order
+	uint32_t numInputs = 0;
+	uint32_t valuesPerFrame = 0;
+	bool inputsMatch = Result::OKAY == recording.FindBlock("Inputs") &&
+		recording.Read(&numInputs, sizeof(numInputs)) == sizeof(numInputs) &&
+		numInputs == inputs.size();
+	for (size_t i = 0; inputsMatch && i < inputs.size(); i++)
+	{
+		std::string id = inputs[i]->id;
+		const uint8_t *recordedId = recording.ReadSpan(uint32_t(id.size() + 1));
+		inputsMatch = recordedId && memcmp(recordedId, id.c_str(), id.size() + 1) == 0;
+	}
+	inputsMatch = inputsMatch &&
+		recording.Read(&valuesPerFrame, sizeof(valuesPerFrame)) == sizeof(valuesPerFrame) &&
+		valuesPerFrame == CountValues(inputs);
+	if (!inputsMatch)
+	{
+		ErrorLog("'%s' was recorded with a different set of inputs.", file.c_str());
+		return Result::FAIL;
+	}
+
+	uint32_t stateSize = 0;
+	uint32_t numFrames = 0;
+	std::vector<uint8_t> startState;
+	std::vector<UINT16> values;
+	std::vector<uint32_t> hashes;
+	bool ok = Result::OKAY == recording.FindBlock("Start State") &&
+		recording.Read(&stateSize, sizeof(stateSize)) == sizeof(stateSize);
+	if (ok)
+	{
+		startState.resize(stateSize);
+		ok = recording.Read(startState.data(), stateSize) == stateSize;
+	}
+	ok = ok && Result::OKAY == recording.FindBlock("Frames") &&
+		recording.Read(&numFrames, sizeof(numFrames)) == sizeof(numFrames);
+	for (uint32_t i = 0; ok && i < numFrames; i++)
+	{
+		const uint8_t *frame = recording.ReadSpan(uint32_t(valuesPerFrame * sizeof(UINT16) + sizeof(uint32_t)));
+		ok = frame != nullptr;
+		if (ok)
+		{
+			size_t pos = values.size();
+			values.resize(pos + valuesPerFrame);
+			memcpy(&values[pos], frame, valuesPerFrame * sizeof(UINT16));
+			uint32_t hash;
+			memcpy(&hash, frame + valuesPerFrame * sizeof(UINT16), sizeof(hash));
+			hashes.push_back(hash);
+		}
+	}
+	if (!ok)
+	{
+		ErrorLog("Input recording '%s' is corrupt.", file.c_str());
+		return Result::FAIL;
+	}
+
+	m_gameName = gameName;
+	m_inputs = std::move(inputs);
+	m_valuesPerFrame = valuesPerFrame;
+	m_startState = std::move(startState);
+	m_values = std::move(values);
+	m_hashes = std::move(hashes);
+	m_frame = 0;
+	m_firstMismatch = -1;
+	return Result::OKAY;
+}
+
+Result CInputRecording::Save(const std::string &file) const
+{
+	CBlockFile recording;
+	if (Result::OKAY != recording.Create(file, "Supermodel Input Recording", "Supermodel Version " SUPERMODEL_VERSION))
+	{
+		ErrorLog("Unable to save input recording to '%s'.", file.c_str());
+		return Result::FAIL;
+	}
+
+	recording.Write(&INPUT_RECORDING_VERSION, sizeof(INPUT_RECORDING_VERSION));
+	recording.Write(m_gameName);
+
+	recording.NewBlock("Inputs", "");
+	recording.Write(uint32_t(m_inputs.size()));
+	for (auto &input : m_inputs)
+		recording.Write(std::string(input->id));
+	recording.Write(uint32_t(m_valuesPerFrame));
+
+	recording.NewBlock("Start State", "");
+	recording.Write(uint32_t(m_startState.size()));
+	recording.Write(m_startState.data(), uint32_t(m_startState.size()));
+
+	recording.NewBlock("Frames", "");
+	recording.Write(uint32_t(m_hashes.size()));
+	for (size_t i = 0; i < m_hashes.size(); i++)
+	{
+		recording.Write(&m_values[i * m_valuesPerFrame], uint32_t(m_valuesPerFrame * sizeof(UINT16)));
+		recording.Write(m_hashes[i]);
+	}
+
+	recording.Close();
+	InfoLog("Saved %u frames of inputs to '%s'.", unsigned(m_hashes.size()), file.c_str());
+	return Result::OKAY;
+}
+
+const std::vector<uint8_t> &CInputRecording::GetStartState() const
+{
+	return m_startState;
+}
+
+void CInputRecording::RecordFrame(uint32_t ramHash)
+{
+	for (auto &input : m_inputs)
+		input->RecordValues(&m_values);
+	m_hashes.push_back(ramHash);
+	m_frame++;
+}
+
+bool CInputRecording::ReplayFrame()
+{
+	if (m_frame >= m_hashes.size())
+		return false;
+	const UINT16 *values = m_values.data() + m_frame * m_valuesPerFrame;
+	for (auto &input : m_inputs)
+		values = input->ReplayValues(values);
+	return true;
+}
+
+bool CInputRecording::CheckFrame(uint32_t ramHash)
+{
+	bool match = m_hashes[m_frame] == ramHash;
+	if (!match && m_firstMismatch < 0)
+		m_firstMismatch = int(m_frame);
+	m_frame++;
+	return match;
+}
+
+unsigned CInputRecording::GetFrameNumber() const
+{
+	return m_frame;
+}
+
+unsigned CInputRecording::GetNumFrames() const
+{
+	return unsigned(m_hashes.size());
+}
+
+int CInputRecording::GetFirstMismatch() const
+{
+	return m_firstMismatch;
+}
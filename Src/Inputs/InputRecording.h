@@ -0,0 +1,112 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free 
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+/*
+ * InputRecording.h
+ *
+ * Header file for CInputRecording, a frame by frame recording of the inputs
+ * read by the emulator.
+ */
+
+#ifndef INCLUDED_INPUTRECORDING_H
+#define INCLUDED_INPUTRECORDING_H
+
+#include "Input.h"
+#include "Types.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * A recording holds the save state it starts from and, for every emulated
+ * frame, the values of all inputs read by the emulator together with a hash
+ * of emulated RAM at the end of the frame. Replaying it from the start state
+ * feeds the same values back, and comparing hashes shows the first frame at
+ * which the replay went its own way.
+ */
+class CInputRecording
+{
+public:
+	/*
+	 * Starts a new recording of the given inputs from a save state image.
+	 */
+	void Start(const std::string &gameName, std::vector<std::shared_ptr<CInput>> inputs, std::vector<uint8_t> startState);
+
+	/*
+	 * Loads a recording for replay through the given inputs. Returns FAIL and prints an error if it can't be
+	 * opened or was made for a different game or set of inputs.
+	 */
+	Result Load(const std::string &file, const std::string &gameName, std::vector<std::shared_ptr<CInput>> inputs);
+
+	/*
+	 * Writes the recording to disk. Returns FAIL and prints an error if unsuccessful.
+	 */
+	Result Save(const std::string &file) const;
+
+	/*
+	 * Returns the save state image the recording starts from.
+	 */
+	const std::vector<uint8_t> &GetStartState() const;
+
+	/*
+	 * Appends a frame holding the current input values and the hash of emulated RAM after the frame has run.
+	 */
+	void RecordFrame(uint32_t ramHash);
+
+	/*
+	 * Sets the inputs to the values of the next frame, to be called after polling them. Returns false once all
+	 * frames have been replayed.
+	 */
+	bool ReplayFrame();
+
+	/*
+	 * Compares the hash of emulated RAM after a replayed frame to the recorded one. Returns false on a mismatch.
+	 */
+	bool CheckFrame(uint32_t ramHash);
+
+	/*
+	 * Returns the number of frames recorded or replayed so far.
+	 */
+	unsigned GetFrameNumber() const;
+
+	/*
+	 * Returns the number of frames in the recording.
+	 */
+	unsigned GetNumFrames() const;
+
+	/*
+	 * Returns the first replayed frame whose hash didn't match, or -1 if all have matched so far.
+	 */
+	int GetFirstMismatch() const;
+
+private:
+	std::string m_gameName;
+	std::vector<std::shared_ptr<CInput>> m_inputs;
+	size_t m_valuesPerFrame = 0;
+	std::vector<uint8_t> m_startState;
+	std::vector<UINT16> m_values;		// m_valuesPerFrame values for each frame
+	std::vector<uint32_t> m_hashes;		// one for each frame
+	unsigned m_frame = 0;				// next frame to replay, or number of frames recorded
+	int m_firstMismatch = -1;
+};
+
+#endif	// INCLUDED_INPUTRECORDING_H
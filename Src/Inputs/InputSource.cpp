@@ -32,6 +32,7 @@
 #include "Supermodel.h"
 #include "Input.h"
 #include "InputSystem.h"
+#include "SwitchProgram.h"
 
 using namespace std;
 
@@ -59,6 +60,11 @@ void CInputSource::Release()
 #endif
 }
 
+void CInputSource::CompileSwitch(CSwitchProgram &program)
+{
+	program.AddLeaf(this);
+}
+
 int CInputSource::Clamp(int val, int minVal, int maxVal)
 {
 	if      (val > maxVal) return maxVal;
@@ -31,6 +31,7 @@
 #include <string>
 
 struct ForceFeedbackCmd;
+class CSwitchProgram;
 
 /*
  * Enumeration to represent different types of sources.
@@ -102,6 +103,12 @@ public:
 	 */
 	virtual bool GetValueAsAnalog(int &val, int minVal, int offVal, int maxVal) = 0;
 
+	/*
+	 * Appends the operations that give the switch value of this source to a compiled program.
+	 * By default the source is a leaf whose value is read directly with GetValueAsSwitch.
+	 */
+	virtual void CompileSwitch(CSwitchProgram &program);
+
 	/*
 	 * Sends a force feedback command to the input source.
 	 */
@@ -36,6 +36,7 @@
 
 #include "Supermodel.h"
 #include "Input.h"
+#include "SwitchProgram.h"
 #include "OSD/Thread.h"
 #include <cmath>
 #include <string>
@@ -1868,6 +1869,34 @@ Finish:
     return !cancelled;
 }
 
+bool CInputSystem::PollDevices()
+{
+  return false;
+}
+
+void CInputSystem::ReadSwitchParts(const SwitchPart *parts, size_t count, UINT8 *states) const
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    const SwitchPart &part = parts[i];
+    switch (part.kind)
+    {
+    case SwitchPart::Key:         states[i] = IsKeyPressed(part.devNum, part.partNum); break;
+    case SwitchPart::MouseButton: states[i] = IsMouseButPressed(part.devNum, part.partNum); break;
+    case SwitchPart::JoyButton:   states[i] = IsJoyButPressed(part.devNum, part.partNum); break;
+    case SwitchPart::JoyPOV:      states[i] = IsJoyPOVInDir(part.devNum, part.partNum, part.povDir); break;
+    }
+  }
+}
+
+void CInputSystem::LockDevices()
+{
+}
+
+void CInputSystem::UnlockDevices()
+{
+}
+
 void CInputSystem::GrabMouse()
 {
   m_grabMouse = true;
@@ -2342,6 +2371,11 @@ bool CInputSystem::CKeyInputSource::GetValueAsAnalog(int &val, int minVal, int o
   return true;
 }
 
+void CInputSystem::CKeyInputSource::CompileSwitch(CSwitchProgram &program)
+{
+  program.AddPart(m_system, { SwitchPart::Key, m_kbdNum, m_keyIndex, 0 }, this);
+}
+
 /*
  * CInputSystem::CMseAxisInputSource
  */
@@ -2462,6 +2496,11 @@ bool CInputSystem::CMseButInputSource::GetValueAsAnalog(int &val, int minVal, in
   return true;
 }
 
+void CInputSystem::CMseButInputSource::CompileSwitch(CSwitchProgram &program)
+{
+  program.AddPart(m_system, { SwitchPart::MouseButton, m_mseNum, m_butNum, 0 }, this);
+}
+
 /*
  * CInputSystem::CJoyAxisInputSource
  */
@@ -2565,6 +2604,11 @@ bool CInputSystem::CJoyPOVInputSource::GetValueAsAnalog(int &val, int minVal, in
   return true;
 }
 
+void CInputSystem::CJoyPOVInputSource::CompileSwitch(CSwitchProgram &program)
+{
+  program.AddPart(m_system, { SwitchPart::JoyPOV, m_joyNum, m_povNum, m_povDir }, this);
+}
+
 /*
  * CInputSystem::CJoyButInputSource
  */
@@ -2598,3 +2642,8 @@ bool CInputSystem::CJoyButInputSource::GetValueAsAnalog(int &val, int minVal, in
   val = Scale(m_val, 0, 0, m_maxVal, minVal, offVal, maxVal);
   return true;
 }
+
+void CInputSystem::CJoyButInputSource::CompileSwitch(CSwitchProgram &program)
+{
+  program.AddPart(m_system, { SwitchPart::JoyButton, m_joyNum, m_butNum, 0 }, this);
+}
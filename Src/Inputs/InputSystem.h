@@ -33,6 +33,7 @@
 #include <string>
 #include <vector>
 #include "MultiInputSource.h"
+#include "Types.h"
 #include "Util/NewConfig.h"
 
 class CInput;
@@ -860,6 +861,38 @@ public:
    */
   virtual bool Poll() = 0;
 
+  /*
+   * Updates the state of devices, such as joysticks, between calls to Poll() so that inputs read later in the frame see
+   * fresh values. Called at a high rate from the same thread as Poll() when CInputs defers polling, while the emulator
+   * runs on another. Returns false if there is nothing the input system can update outside of Poll().
+   */
+  virtual bool PollDevices();
+
+  /*
+   * A key, mouse button, joystick button or joystick POV hat direction, read as a switch by ReadSwitchParts().
+   */
+  struct SwitchPart
+  {
+    enum EKind { Key, MouseButton, JoyButton, JoyPOV } kind;
+    int devNum;   // Keyboard, mouse or joystick number
+    int partNum;  // Key index, button number or POV hat number
+    int povDir;   // POV hat direction (JoyPOV only)
+  };
+
+  /*
+   * Reads the state of the given device parts into states (1 if active, 0 if not) in one call, so that compiled switch
+   * mappings don't need to go through an input source for each part.
+   */
+  virtual void ReadSwitchParts(const SwitchPart *parts, size_t count, UINT8 *states) const;
+
+  /*
+   * Hold off device updates between the two calls, so that everything read in between comes from the same device
+   * state. Do nothing by default.
+   */
+  virtual void LockDevices();
+
+  virtual void UnlockDevices();
+
   virtual void GrabMouse();
 
   virtual void UngrabMouse();
@@ -901,6 +934,8 @@ public:
     bool GetValueAsSwitch(bool &val) const;
 
     bool GetValueAsAnalog(int &val, int minVal, int offVal, int maxVal);
+
+    void CompileSwitch(CSwitchProgram &program);
   };
 
   /*
@@ -948,6 +983,8 @@ public:
     bool GetValueAsSwitch(bool &val) const;
 
     bool GetValueAsAnalog(int &val, int minVal, int offVal, int maxVal);
+
+    void CompileSwitch(CSwitchProgram &program);
   };
 
   /*
@@ -1006,6 +1043,8 @@ public:
     bool GetValueAsSwitch(bool &val) const;
 
     bool GetValueAsAnalog(int &val, int minVal, int offVal, int maxVal);
+
+    void CompileSwitch(CSwitchProgram &program);
   };
 
   /*
@@ -1028,6 +1067,8 @@ public:
     bool GetValueAsSwitch(bool &val) const;
 
     bool GetValueAsAnalog(int &val, int minVal, int offVal, int maxVal);
+
+    void CompileSwitch(CSwitchProgram &program);
   };
 };
 
@@ -233,3 +233,16 @@ void CTriggerInput::Poll()
 		offscreenValue = m_offscreenInput->value;
 	}
 }
+
+void CTriggerInput::RecordValues(std::vector<UINT16> *values) const
+{
+	values->push_back(value);
+	values->push_back(offscreenValue);
+}
+
+const UINT16 *CTriggerInput::ReplayValues(const UINT16 *values)
+{
+	value = *values++;
+	offscreenValue = *values++;
+	return values;
+}
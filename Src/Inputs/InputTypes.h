@@ -26,6 +26,11 @@ public:
 	 */
 	void Poll();
 
+	/*
+	 * Updates the input from a switch state evaluated elsewhere, as Poll() would (see CSwitchProgram)
+	 */
+	void Update(bool active);
+
 	/*
 	 * Returns true if the input was pressed during last update (ie currently on but previously off)
 	 */
@@ -168,6 +173,20 @@ public:
 	 * Polls (updates) the input, updating its trigger value and offscreen value from the switch inputs
 	 */
 	void Poll();
+
+	void RecordValues(std::vector<UINT16> *values) const;
+
+	const UINT16 *ReplayValues(const UINT16 *values);
 };
 
+//
+// Inlined methods
+//
+
+inline void CSwitchInput::Update(bool active)
+{
+	prevValue = value;
+	value = (active ? m_onVal : m_offVal);
+}
+
 #endif	// INCLUDED_INPUTTYPES_H
\ No newline at end of file
@@ -33,14 +33,17 @@
 #include "InputSystem.h"
 #include "InputTypes.h"
 #include "Game.h"
+#include <algorithm>
 #include <cstdarg>
+#include <chrono>
 #include <vector>
 #include <string>
 #include <iostream>
 using namespace std;
 
 CInputs::CInputs(std::shared_ptr<CInputSystem> system)
-  : m_system(system)
+  : m_system(system),
+    m_gameInputsPending(false)
 {
 	// UI controls are hard coded here, everything else is initialized to NONE so that it can be loaded from
 	// the config file.
@@ -60,9 +63,12 @@ CInputs::CInputs(std::shared_ptr<CInputSystem> system)
 	uiClearNVRAM       = AddSwitchInput("UIClearNVRAM",       "Clear NVRAM",           Game::INPUT_UI, "KEY_ALT+KEY_N");
 	uiSelectCrosshairs = AddSwitchInput("UISelectCrosshairs", "Select Crosshairs",     Game::INPUT_UI, "KEY_ALT+KEY_I");
 	uiToggleFrLimit    = AddSwitchInput("UIToggleFrameLimit", "Toggle Frame Limiting", Game::INPUT_UI, "KEY_ALT+KEY_T");
+	uiToggleFastForward = AddSwitchInput("UIToggleFastForward", "Toggle Fast-Forward", Game::INPUT_UI, "KEY_ALT+KEY_F");
+	uiTogglePerfOverlay = AddSwitchInput("UITogglePerfOverlay", "Toggle Performance Overlay", Game::INPUT_UI, "KEY_ALT+KEY_G");
 	uiDumpInpState     = AddSwitchInput("UIDumpInputState",   "Dump Input State",      Game::INPUT_UI, "KEY_ALT+KEY_U");
 	uiDumpTimings      = AddSwitchInput("UIDumpTimings",      "Dump Frame Timings",    Game::INPUT_UI, "KEY_ALT+KEY_O");
 	uiScreenshot       = AddSwitchInput("UIScreenShot",	      "Screenshot",            Game::INPUT_UI, "KEY_ALT+KEY_S");
+	uiRewind           = AddSwitchInput("UIRewind",           "Rewind",                Game::INPUT_UI, "KEY_BACKSPACE");
 #ifdef SUPERMODEL_DEBUGGER
 	uiEnterDebugger    = AddSwitchInput("UIEnterDebugger",    "Enter Debugger",        Game::INPUT_UI, "KEY_ALT+KEY_B");
 #endif
@@ -278,6 +284,9 @@ CInputs::CInputs(std::shared_ptr<CInputSystem> system)
 
 CInputs::~CInputs()
 {
+	SetDeferredPolling(0);
+	m_uiSwitches.Clear();
+	m_gameSwitches.Clear();
 }
 
 std::shared_ptr<CSwitchInput> CInputs::AddSwitchInput(const char *id, const char *label, unsigned gameFlags, const char *defaultMapping,
@@ -633,6 +642,17 @@ std::vector<std::shared_ptr<CInput>> CInputs::GetGameInputs(const Game& game)
 	return inputs;
 }
 
+std::vector<std::shared_ptr<CInput>> CInputs::GetEmulatedInputs(const Game& game)
+{
+	std::vector<std::shared_ptr<CInput>> inputs;
+	for (auto& i : m_inputs) {
+		if (!i->IsUIInput() && (i->gameFlags & game.inputs)) {
+			inputs.emplace_back(i);
+		}
+	}
+	return inputs;
+}
+
 void CInputs::CalibrateJoysticks()
 {
 	int numJoys = m_system->GetNumJoysticks();
@@ -759,6 +779,9 @@ void CInputs::PrintInputs(const Game *game)
 
 bool CInputs::Poll(const Game *game, unsigned dispX, unsigned dispY, unsigned dispW, unsigned dispH)
 {
+	auto start = std::chrono::steady_clock::now();
+	m_pollMicros = 0;
+
 	// Update the input system with the current display geometry
 	m_system->SetDisplayGeom(dispX, dispY, dispW, dispH);
 
@@ -768,12 +791,95 @@ bool CInputs::Poll(const Game *game, unsigned dispX, unsigned dispY, unsigned di
 
 	// Poll all UI inputs and all the inputs used by the current game, or all inputs if game is NULL
 	uint32_t gameFlags = game ? game->inputs : Game::INPUT_ALL;
+	if (m_deferGameInputs)
+	{
+		// Game inputs are left until the emulator reads them
+		PollInputs(true, 0);
+		m_gameFlags = gameFlags;
+		m_gameInputsPending = true;
+	}
+	else
+		PollInputs(true, gameFlags);
+
+	m_pollMicros += unsigned(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	return true;
+}
+
+void CInputs::PollInputs(bool uiInputs, uint32_t gameFlags)
+{
+	// Every input, switch or analog, is read from the same device state
+	m_system->LockDevices();
+	if (uiInputs)
+	{
+		if (!m_uiSwitches.IsCurrent())
+			m_uiSwitches.Compile(GetSwitchInputs(true, 0));
+		m_uiSwitches.Poll();
+	}
+	if (gameFlags)
+	{
+		if (gameFlags != m_gameSwitchFlags || !m_gameSwitches.IsCurrent())
+		{
+			m_gameSwitches.Compile(GetSwitchInputs(false, gameFlags));
+			m_gameSwitchFlags = gameFlags;
+		}
+		m_gameSwitches.Poll();
+	}
+
 	for (auto it = m_inputs.begin(); it != m_inputs.end(); ++it)
 	{
-		if ((*it)->IsUIInput() || ((*it)->gameFlags & gameFlags))
+		if ((*it)->flags & INPUT_FLAGS_SWITCH)
+			continue;
+		if ((*it)->IsUIInput() ? uiInputs : !!((*it)->gameFlags & gameFlags))
 			(*it)->Poll();
 	}
-	return true;
+	m_system->UnlockDevices();
+}
+
+std::vector<CSwitchInput*> CInputs::GetSwitchInputs(bool uiInputs, uint32_t gameFlags) const
+{
+	std::vector<CSwitchInput*> inputs;
+	for (auto it = m_inputs.begin(); it != m_inputs.end(); ++it)
+	{
+		if (((*it)->flags & INPUT_FLAGS_SWITCH) && ((*it)->IsUIInput() ? uiInputs : !!((*it)->gameFlags & gameFlags)))
+			inputs.push_back(static_cast<CSwitchInput*>(it->get()));
+	}
+	return inputs;
+}
+
+void CInputs::SetDeferredPolling(unsigned devicePollRate)
+{
+	// Anything still pending is polled now so no frame's inputs are lost
+	PollGameInputs();
+
+	m_deferGameInputs = devicePollRate > 0;
+	m_devicePollPeriod = m_deferGameInputs ? std::max(1000 / devicePollRate, 1u) : 0;
+}
+
+unsigned CInputs::GetDevicePollPeriod() const
+{
+	return m_devicePollPeriod;
+}
+
+void CInputs::PollDevices()
+{
+	// Once the game's inputs are sampled there is nothing left to update them for until the next frame
+	if (m_gameInputsPending)
+		m_system->PollDevices();
+}
+
+void CInputs::PollGameInputs()
+{
+	if (!m_gameInputsPending.exchange(false))
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+	PollInputs(false, m_gameFlags);
+	m_pollMicros += unsigned(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+unsigned CInputs::GetPollMicros() const
+{
+	return m_pollMicros;
 }
 
 void CInputs::DumpState(const Game *game)
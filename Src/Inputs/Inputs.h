@@ -29,10 +29,12 @@
 #define INCLUDED_INPUTS_H
 
 #include "InputTypes.h"
+#include "SwitchProgram.h"
 #include "Types.h"
 #include "Util/NewConfig.h"
 #include <vector>
 #include <memory>
+#include <atomic>
 
 class CInputSystem;
 class CInput;
@@ -50,6 +52,28 @@ private:
   // Vector of all created inputs
   std::vector<std::shared_ptr<CInput>> m_inputs;
 
+  // Deferred polling of the game's inputs (see SetDeferredPolling())
+  bool m_deferGameInputs = false;
+  std::atomic<bool> m_gameInputsPending;
+  uint32_t m_gameFlags = 0;
+  unsigned m_devicePollPeriod = 0;
+
+  // Compiled mappings of the UI switch inputs and of the switch inputs of the game last polled
+  CSwitchProgram m_uiSwitches;
+  CSwitchProgram m_gameSwitches;
+  uint32_t m_gameSwitchFlags = 0;
+
+  // Time spent polling since the start of the last Poll()
+  unsigned m_pollMicros = 0;
+
+  /*
+   * Polls the UI inputs if uiInputs is true and the game inputs selected by gameFlags. Switch inputs are evaluated
+   * first from their compiled mappings, then the others in order as virtual inputs depend on them.
+   */
+  void PollInputs(bool uiInputs, uint32_t gameFlags);
+
+  std::vector<CSwitchInput*> GetSwitchInputs(bool uiInputs, uint32_t gameFlags) const;
+
   /*
    * Adds a switch input (eg button) to this collection.
    */ 
@@ -100,9 +124,12 @@ public:
   std::shared_ptr<CSwitchInput> uiClearNVRAM;
   std::shared_ptr<CSwitchInput> uiSelectCrosshairs;
   std::shared_ptr<CSwitchInput> uiToggleFrLimit;
+  std::shared_ptr<CSwitchInput> uiToggleFastForward;
+  std::shared_ptr<CSwitchInput> uiTogglePerfOverlay;
   std::shared_ptr<CSwitchInput> uiDumpInpState;
   std::shared_ptr<CSwitchInput> uiDumpTimings;
   std::shared_ptr<CSwitchInput> uiScreenshot;
+  std::shared_ptr<CSwitchInput> uiRewind;
 #ifdef SUPERMODEL_DEBUGGER
   std::shared_ptr<CSwitchInput> uiEnterDebugger;
 #endif
@@ -287,6 +314,11 @@ public:
 
   std::vector<std::shared_ptr<CInput>> GetGameInputs(const Game& game);
 
+  /*
+   * Returns all inputs read by the emulator for the given game, including virtual ones, in a fixed order.
+   */
+  std::vector<std::shared_ptr<CInput>> GetEmulatedInputs(const Game& game);
+
   void CalibrateJoysticks();
 
   void CalibrateJoystick(int joyNum);
@@ -302,6 +334,37 @@ public:
    */
   bool Poll(const Game *game, unsigned dispX, unsigned dispY, unsigned dispW, unsigned dispH);
 
+  /*
+   * With a non-zero rate, Poll() only polls the input system and the UI inputs, leaving the game's inputs to be polled
+   * by PollGameInputs() when the emulator first reads them, as late in the frame as possible. Until then, the main
+   * thread should call PollDevices() at the given rate in Hz (at most 1000) while the emulator runs the frame on
+   * another thread. Zero polls everything in Poll().
+   */
+  void SetDeferredPolling(unsigned devicePollRate);
+
+  /*
+   * Returns the interval in milliseconds at which PollDevices() should be called, or 0 if polling is not deferred.
+   */
+  unsigned GetDevicePollPeriod() const;
+
+  /*
+   * Updates the devices that can change between calls to Poll() (see CInputSystem::PollDevices()) if the game's inputs
+   * have not been polled yet. Must be called from the same thread as Poll().
+   */
+  void PollDevices();
+
+  /*
+   * Polls the game's inputs once after each call to Poll() when polling is deferred, otherwise does nothing. Cheap
+   * enough to call on every input read.
+   */
+  void PollGameInputs();
+
+  /*
+   * Returns the time in microseconds spent polling the input system and updating inputs since the start of the last
+   * call to Poll(), including any deferred polling of the game's inputs.
+   */
+  unsigned GetPollMicros() const;
+
   /*
    * Prints the current values of the inputs for the given game, or all inputs if game is NULL, to stdout for debugging purposes.
    */
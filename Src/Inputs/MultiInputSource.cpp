@@ -29,6 +29,7 @@
 
 #include "Supermodel.h"
 #include "Input.h"
+#include "SwitchProgram.h"
 
 #include <vector>
 using namespace std;
@@ -165,6 +166,13 @@ bool CMultiInputSource::GetValueAsAnalog(int &val, int minVal, int offVal, int m
 	}
 }
 
+void CMultiInputSource::CompileSwitch(CSwitchProgram &program)
+{
+	for (size_t i = 0; i < m_numSrcs; i++)
+		m_srcArray[i]->CompileSwitch(program);
+	program.AddCombine(m_isOr, m_numSrcs);
+}
+
 bool CMultiInputSource::SendForceFeedbackCmd(ForceFeedbackCmd ffCmd)
 {
 	bool result = false;
@@ -220,3 +228,9 @@ bool CNegInputSource::GetValueAsAnalog(int &val, int minVal, int offVal, int max
 	val = maxVal;
 	return true;
 }
+
+void CNegInputSource::CompileSwitch(CSwitchProgram &program)
+{
+	m_source->CompileSwitch(program);
+	program.AddNot();
+}
@@ -0,0 +1,247 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+/*
+ * SwitchProgram.cpp
+ *
+ * Implementation of CSwitchProgram.
+ */
+
+#include "SwitchProgram.h"
+#include "InputSource.h"
+#include "InputTypes.h"
+
+CSwitchProgram::~CSwitchProgram()
+{
+	Clear();
+}
+
+void CSwitchProgram::Compile(const std::vector<CSwitchInput*> &inputs)
+{
+	Clear();
+
+	m_inputs = inputs;
+	for (size_t i = 0; i < m_inputs.size(); i++)
+	{
+		// Unmapped inputs are always off
+		size_t start = m_ops.size();
+		CInputSource *source = m_inputs[i]->GetSource();
+		if (source != NULL)
+		{
+			source->Acquire();
+			source->CompileSwitch(*this);
+		}
+		else
+			AddCombine(true, 0);
+		m_sources.push_back(source);
+
+		// Most mappings are a key or button, or a choice of them, and are evaluated in one step
+		UINT64 mask;
+		if (MakeMask(start, &mask))
+		{
+			m_ops.resize(start);
+			m_ops.push_back({ OpStoreAny, UINT16(i), UINT16(m_masks.size()) });
+			m_masks.push_back(mask);
+		}
+		else
+			m_ops.push_back({ OpStore, UINT16(i), 0 });
+		Pop(1);
+	}
+
+	m_leafStates.resize(m_leaves.size());
+	m_partStates.resize(m_parts.size());
+	m_leafIndex.clear();
+	m_partIndex.clear();
+	m_sourceGeneration = CInput::GetSourceGeneration();
+	m_compiled = true;
+}
+
+void CSwitchProgram::Clear()
+{
+	for (CInputSource *leaf : m_leaves)
+		leaf->Release();
+	for (CInputSource *source : m_sources)
+	{
+		if (source != NULL)
+			source->Release();
+	}
+	m_ops.clear();
+	m_leaves.clear();
+	m_leafStates.clear();
+	m_system = NULL;
+	m_parts.clear();
+	m_partStates.clear();
+	m_masks.clear();
+	m_inputs.clear();
+	m_sources.clear();
+	m_stack.clear();
+	m_leafIndex.clear();
+	m_partIndex.clear();
+	m_depth = 0;
+	m_compiled = false;
+}
+
+bool CSwitchProgram::IsCurrent() const
+{
+	// Any remapping creates a new source
+	return m_compiled && m_sourceGeneration == CInput::GetSourceGeneration();
+}
+
+void CSwitchProgram::Poll()
+{
+	// Snapshot the state of every device part used
+	UINT64 partBits = 0;
+	if (!m_parts.empty())
+	{
+		m_system->ReadSwitchParts(m_parts.data(), m_parts.size(), m_partStates.data());
+		for (size_t i = 0; i < m_parts.size() && i < 64; i++)
+			partBits |= UINT64(m_partStates[i]) << i;
+	}
+	for (size_t i = 0; i < m_leaves.size(); i++)
+	{
+		bool val = false;
+		m_leafStates[i] = m_leaves[i]->GetValueAsSwitch(val);
+	}
+
+	// Evaluate the mappings over the snapshot
+	UINT8 *stack = m_stack.data();
+	size_t sp = 0;
+	for (const Op &op : m_ops)
+	{
+		switch (op.code)
+		{
+		case OpLeaf:
+			stack[sp++] = m_leafStates[op.arg];
+			break;
+		case OpPart:
+			stack[sp++] = m_partStates[op.arg];
+			break;
+		case OpNot:
+			stack[sp - 1] ^= 1;
+			break;
+		case OpOr:
+		{
+			sp -= op.arg;
+			UINT8 val = 0;
+			for (unsigned i = 0; i < op.arg; i++)
+				val |= stack[sp + i];
+			stack[sp++] = val;
+			break;
+		}
+		case OpAnd:
+		{
+			sp -= op.arg;
+			UINT8 val = op.arg > 0;
+			for (unsigned i = 0; i < op.arg; i++)
+				val &= stack[sp + i];
+			stack[sp++] = val;
+			break;
+		}
+		case OpStore:
+			m_inputs[op.arg]->Update(!!stack[--sp]);
+			break;
+		case OpStoreAny:
+			m_inputs[op.arg]->Update((partBits & m_masks[op.arg2]) != 0);
+			break;
+		}
+	}
+}
+
+void CSwitchProgram::AddLeaf(CInputSource *source)
+{
+	auto it = m_leafIndex.find(source);
+	UINT16 index;
+	if (it != m_leafIndex.end())
+		index = it->second;
+	else
+	{
+		index = UINT16(m_leaves.size());
+		source->Acquire();
+		m_leaves.push_back(source);
+		m_leafIndex[source] = index;
+	}
+	m_ops.push_back({ OpLeaf, index, 0 });
+	Push();
+}
+
+void CSwitchProgram::AddPart(CInputSystem *system, const CInputSystem::SwitchPart &part, CInputSource *source)
+{
+	if (m_system == NULL)
+		m_system = system;
+	else if (system != m_system)
+	{
+		AddLeaf(source);
+		return;
+	}
+
+	UINT64 key = UINT64(part.kind) << 56 | UINT64(UINT8(part.povDir)) << 48 | UINT64(UINT16(part.devNum)) << 32 | UINT32(part.partNum);
+	auto it = m_partIndex.find(key);
+	UINT16 index;
+	if (it != m_partIndex.end())
+		index = it->second;
+	else
+	{
+		index = UINT16(m_parts.size());
+		m_parts.push_back(part);
+		m_partIndex[key] = index;
+	}
+	m_ops.push_back({ OpPart, index, 0 });
+	Push();
+}
+
+void CSwitchProgram::AddNot()
+{
+	m_ops.push_back({ OpNot, 0, 0 });
+}
+
+void CSwitchProgram::AddCombine(bool isOr, size_t count)
+{
+	m_ops.push_back({ isOr ? OpOr : OpAnd, UINT16(count), 0 });
+	Pop(count);
+	Push();
+}
+
+// An expression of nothing but device parts and ORs is true if any of the parts is active. If the ops from start on
+// are one, and all its parts are among the first 64, sets the mask of its parts and returns true.
+bool CSwitchProgram::MakeMask(size_t start, UINT64 *mask) const
+{
+	*mask = 0;
+	for (size_t i = start; i < m_ops.size(); i++)
+	{
+		const Op &op = m_ops[i];
+		if (op.code == OpPart && op.arg < 64)
+			*mask |= UINT64(1) << op.arg;
+		else if (op.code != OpOr)
+			return false;
+	}
+	return true;
+}
+
+void CSwitchProgram::Push()
+{
+	if (++m_depth > m_stack.size())
+		m_stack.resize(m_depth);
+}
+
+void CSwitchProgram::Pop(size_t count)
+{
+	m_depth -= count;
+}
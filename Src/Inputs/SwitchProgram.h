@@ -0,0 +1,145 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+/*
+ * SwitchProgram.h
+ *
+ * Header file for CSwitchProgram, the mappings of a set of switch inputs
+ * compiled into a flat program.
+ */
+
+#ifndef INCLUDED_SWITCHPROGRAM_H
+#define INCLUDED_SWITCHPROGRAM_H
+
+#include "Types.h"
+#include "InputSystem.h"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class CSwitchInput;
+
+/*
+ * Evaluates the mappings of switch inputs without walking their source trees. Each distinct device part (key, button,
+ * axis direction or POV direction) used by any of the mappings becomes a leaf that is read once per poll into a state
+ * array, and the combinations of leaves (KEY_ALT+KEY_P, !KEY_SHIFT, ...) become a postfix sequence of operations over
+ * that array, evaluated for all inputs in a single loop. The results are the same as CSwitchInput::Poll() would give.
+ *
+ * Keys, mouse buttons, joystick buttons and POV directions are read straight from the input system with a single
+ * CInputSystem::ReadSwitchParts() call. Only the leaves that need scaling, such as joystick axes read as switches, go
+ * through their input sources.
+ *
+ * The program holds references to the sources it was compiled from, so it stays valid if an input is remapped, but then
+ * no longer matches it (see IsCurrent()).
+ */
+class CSwitchProgram
+{
+public:
+	~CSwitchProgram();
+
+	/*
+	 * Compiles the current mappings of the given inputs, replacing any previous program. The inputs must remain valid
+	 * until the program is cleared or recompiled.
+	 */
+	void Compile(const std::vector<CSwitchInput*> &inputs);
+
+	/*
+	 * Releases the compiled program.
+	 */
+	void Clear();
+
+	/*
+	 * Returns true if the program has been compiled and none of the inputs has been remapped since.
+	 */
+	bool IsCurrent() const;
+
+	/*
+	 * Reads the leaves and updates the values of all the inputs.
+	 */
+	void Poll();
+
+	//
+	// Used by CInputSource::CompileSwitch() to emit the program
+	//
+
+	/*
+	 * Pushes the switch state of the given source, which is read once per poll however many mappings use it.
+	 */
+	void AddLeaf(CInputSource *source);
+
+	/*
+	 * Pushes the state of the given part of a device of the input system, which is read once per poll however many
+	 * mappings use it. Falls back to AddLeaf(source) if the part belongs to a different input system from the others.
+	 */
+	void AddPart(CInputSystem *system, const CInputSystem::SwitchPart &part, CInputSource *source);
+
+	/*
+	 * Replaces the value on top of the stack with its negation.
+	 */
+	void AddNot();
+
+	/*
+	 * Replaces the given number of values on top of the stack with true if any (isOr) or all of them are true. With no
+	 * values, pushes false.
+	 */
+	void AddCombine(bool isOr, size_t count);
+
+private:
+	enum EOpCode : UINT8
+	{
+		OpLeaf,		// push state of leaf arg
+		OpPart,		// push state of device part arg
+		OpNot,		// negate top of stack
+		OpOr,		// replace top arg values with whether any are true
+		OpAnd,		// replace top arg values with whether all are true (false if arg is 0)
+		OpStore,	// pop value into input arg
+		OpStoreAny	// set input arg to whether any of the first 64 device parts in mask arg2 are active
+	};
+
+	struct Op
+	{
+		EOpCode code;
+		UINT16 arg;
+		UINT16 arg2;
+	};
+
+	std::vector<Op> m_ops;
+	std::vector<CInputSource*> m_leaves;			// acquired
+	std::vector<UINT8> m_leafStates;
+	CInputSystem *m_system = NULL;					// system the device parts are read from
+	std::vector<CInputSystem::SwitchPart> m_parts;
+	std::vector<UINT8> m_partStates;
+	std::vector<UINT64> m_masks;					// for OpStoreAny
+	std::vector<CSwitchInput*> m_inputs;
+	std::vector<CInputSource*> m_sources;			// source each input was compiled from (acquired if not NULL)
+	std::vector<UINT8> m_stack;
+	std::unordered_map<CInputSource*, UINT16> m_leafIndex;
+	std::unordered_map<UINT64, UINT16> m_partIndex;
+	size_t m_depth = 0;								// stack depth while compiling
+	unsigned m_sourceGeneration = 0;				// CInput::GetSourceGeneration() when compiled
+	bool m_compiled = false;
+
+	void Push();
+	void Pop(size_t count);
+	bool MakeMask(size_t start, UINT64 *mask) const;
+};
+
+#endif	// INCLUDED_SWITCHPROGRAM_H
@@ -133,7 +133,7 @@ int CDSBResampler::UpSampleAndMix(float *outL, float *outR, INT16 *inL, INT16 *i
 	float	v[2], musicVol;
 
 	// Obtain program volume settings
-	musicVol = (float)std::max(0,std::min(200,m_config["MusicVolume"].ValueAs<int>()));
+	musicVol = (float)std::max(0,std::min(200,m_musicVolume.Value()));
 	musicVol = musicVol * (float) (1.0 / 100.0);
 
 	v[0] = musicVol * (float) volumeL * (float) (1.0 / (255.0*256.0)); // 256 is there to correct for fixed point interpolation below
@@ -402,7 +402,7 @@ void CDSB1::SendCommand(UINT8 data)
 
 void CDSB1::RunFrame(float *audioL, float *audioR)
 {
-	if (!m_config["EmulateDSB"].ValueAs<bool>())
+	if (!m_emulateDSB.Value())
 	{
 		// DSB code applies SCSP volume, too, so we must still mix
 		memset(mpegL, 0, (32000/60+2)*sizeof(INT16));
@@ -580,7 +580,7 @@ CZ80 *CDSB1::GetZ80(void)
 }
 
 CDSB1::CDSB1(const Util::Config::Node &config)
-  : m_config(config),
+  : m_emulateDSB(config, "EmulateDSB"),
     Resampler(config)
 {
 	progROM		= NULL;
@@ -966,7 +966,7 @@ void CDSB2::SendCommand(UINT8 data)
 
 void CDSB2::RunFrame(float *audioL, float *audioR)
 {
-  if (!m_config["EmulateDSB"].ValueAs<bool>())
+  if (!m_emulateDSB.Value())
   {
     // DSB code applies SCSP volume, too, so we must still mix
     memset(mpegL, 0, (32000/60+2) * sizeof(INT16));
@@ -1224,7 +1224,7 @@ M68KCtx *CDSB2::GetM68K(void)
 }
 
 CDSB2::CDSB2(const Util::Config::Node &config)
-  : m_config(config),
+  : m_emulateDSB(config, "EmulateDSB"),
     Resampler(config)
 {
 	progROM		= NULL;
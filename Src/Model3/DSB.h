@@ -74,12 +74,12 @@ public:
 	int		UpSampleAndMix(float *outL, float *outR, INT16 *inL, INT16 *inR, UINT8 volumeL, UINT8 volumeR, int sizeOut, int sizeIn, int outRate, int inRate);
 	void	Reset(void);
 	CDSBResampler(const Util::Config::Node &config)
-	  : m_config(config)
+	  : m_musicVolume(config, "MusicVolume")
 	{
 		Reset();
 	}
 private:
-	const Util::Config::Node &m_config;
+	Util::Config::Handle<int> m_musicVolume;
 	int	nFrac;
 	int	pFrac;
 };
@@ -202,7 +202,7 @@ public:
 	~CDSB1(void);
 
 private:
-  const Util::Config::Node &m_config;
+  Util::Config::Handle<bool> m_emulateDSB;
 
 	// Resampler
 	CDSBResampler	Resampler;
@@ -279,7 +279,7 @@ public:
 	~CDSB2(void);
 
 private:
-	const Util::Config::Node &m_config;
+	Util::Config::Handle<bool> m_emulateDSB;
 
 	// Private helper functions
 	void	WriteMPEGFIFO(UINT8 byte);
@@ -28,6 +28,8 @@
 #ifndef INCLUDED_IEMULATOR_H
 #define INCLUDED_IEMULATOR_H
 
+#include <cstdint>
+
 class CBlockFile;
 struct Game;
 struct ROMSet;
@@ -57,7 +59,7 @@ public:
   virtual void SaveState(CBlockFile *SaveState) = 0;
 
   /*
-   * LoadState(SaveState):
+   * LoadState(SaveState, incremental):
    *
    * Loads and resumes execution from a state image. Modifies data that may
    * be used by multiple threads -- use with caution and ensure threads are
@@ -66,9 +68,13 @@ public:
    * (inside RunFrame()).
    *
    * Parameters:
-   *    SaveState   Block file to load state information from.
+   *    SaveState     Block file to load state information from.
+   *    incremental   True if the state was saved earlier in this session and
+   *                  the renderers are up to date with the current state, so
+   *                  only what differs from it needs to be passed on to them
+   *                  (e.g., when rolling back after running ahead).
    */
-  virtual void LoadState(CBlockFile *SaveState) = 0;
+  virtual void LoadState(CBlockFile *SaveState, bool incremental) = 0;
   
   /*
    * SaveNVRAM(NVRAM):
@@ -111,6 +117,37 @@ public:
    */
   virtual void RenderFrame(void) = 0;
 
+  /*
+   * SetFrameOutput(renderVideo, outputAudio, syncVideo):
+   *
+   * Sets whether subsequent calls to RunFrame() draw the frame and pass the
+   * generated sound on to the audio output. Emulation proceeds identically
+   * either way; this is for frames that are computed and then thrown away,
+   * such as when running ahead to reduce input lag, or skipped when fast-
+   * forwarding. Must never be called while emulator is running (inside
+   * RunFrame()).
+   *
+   * Parameters:
+   *    renderVideo   True to render frames (default).
+   *    outputAudio   True to output audio (default).
+   *    syncVideo     True to copy video memory for rendering on frames that
+   *                  aren't rendered (default). When false, the copy is left
+   *                  to the next frame that is.
+   */
+  virtual void SetFrameOutput(bool renderVideo, bool outputAudio, bool syncVideo) = 0;
+
+  /*
+   * HashRAM(void):
+   *
+   * Computes a hash of main board RAM, for checking that two runs of the
+   * same inputs stay in step. Must never be called while emulator is running
+   * (inside RunFrame()).
+   *
+   * Returns:
+   *    CRC-32 of RAM.
+   */
+  virtual uint32_t HashRAM(void) = 0;
+
   /*
    * Reset(void):
    *
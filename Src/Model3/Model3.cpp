@@ -225,12 +225,14 @@
 #include "DriveBoard/WheelBoard.h"
 #include "Game.h"
 #include "ROMSet.h"
+#include "ROMImageCache.h"
 #include "Network/NetBoard.h"
 #include "Network/SimNetBoard.h"
 #include "OSD/Audio.h"
 #include "OSD/Video.h"
 #include "Util/Format.h"
 #include "Util/ByteSwap.h"
+#include "Util/CRC32.h"
 #include <functional>
 #include <set>
 #include <iostream>
@@ -247,6 +249,9 @@ UINT8 CModel3::ReadInputs(unsigned reg)
   UINT8 adc[8];
   UINT8 data;
   reg &= 0x3F;
+
+  // Inputs not polled at the start of the frame are sampled on the first read
+  Inputs->PollGameInputs();
   switch (reg)
   {
   case 0x00:  // input bank
@@ -1376,6 +1381,7 @@ void CModel3::Write8(UINT32 addr, UINT8 data)
   // RAM (most frequently accessed)
   if (addr < 0x00800000)
   {
+    ramDirty.Mark(addr);
     ram[addr^3] = data;
     return;
   }
@@ -1517,6 +1523,7 @@ void CModel3::Write16(UINT32 addr, UINT16 data)
   // RAM (most frequently accessed)
   if (addr < 0x00800000)
   {
+    ramDirty.Mark(addr);
     *(UINT16 *) &ram[addr^2] = data;
     return;
   }
@@ -1611,6 +1618,7 @@ void CModel3::Write32(UINT32 addr, UINT32 data)
   // RAM (most frequently accessed)
   if (addr<0x00800000)
   {
+    ramDirty.Mark(addr);
     *(UINT32 *) &ram[addr] = data;
     return;
   }
@@ -1854,7 +1862,7 @@ void CModel3::SaveState(CBlockFile *SaveState)
   SaveState->Write(&adcChannel, sizeof(adcChannel));
   SaveState->Write(&cromBankReg, sizeof(cromBankReg));
   SaveState->Write(&securityPtr, sizeof(securityPtr));
-  SaveState->Write(ram, 0x800000);
+  SaveState->Write(ram, 0x800000, &ramDirty);
   SaveState->Write(backupRAM, 0x20000);
   SaveState->Write(securityRAM, 0x20000);
   SaveState->Write(&midiCtrlPort, sizeof(midiCtrlPort));
@@ -1875,7 +1883,7 @@ void CModel3::SaveState(CBlockFile *SaveState)
   m_jtag.SaveState(SaveState);
 }
 
-void CModel3::LoadState(CBlockFile *SaveState)
+void CModel3::LoadState(CBlockFile *SaveState, bool incremental)
 {
   // Load Model 3 state
   if (Result::OKAY != SaveState->FindBlock("Model 3"))
@@ -1893,6 +1901,7 @@ void CModel3::LoadState(CBlockFile *SaveState)
   SetCROMBank(cromBankReg); // update CROM bank
   SaveState->Read(&securityPtr, sizeof(securityPtr));
   SaveState->Read(ram, 0x800000);
+  ramDirty.MarkAll();
   SaveState->Read(backupRAM, 0x20000);
   SaveState->Read(securityRAM, 0x20000);
   SaveState->Read(&midiCtrlPort, sizeof(midiCtrlPort));
@@ -1901,7 +1910,7 @@ void CModel3::LoadState(CBlockFile *SaveState)
   m_securityFirstRead = securityFirstRead != 0;
 
   // All devices...
-  GPU.LoadState(SaveState);
+  GPU.LoadState(SaveState, incremental);
   TileGen.LoadState(SaveState);
   EEPROM.LoadState(SaveState);
   SCSI.LoadState(SaveState);
@@ -1946,6 +1955,7 @@ void CModel3::ClearNVRAM(void)
 
 void CModel3::RunFrame(void)
 {
+  Util::Config::FrameScope frameScope;
   UINT32 start = CThread::GetTicks();
 
   // See if currently running multi-threaded
@@ -1955,32 +1965,57 @@ void CModel3::RunFrame(void)
     if (!StartThreads())
       goto ThreadError;
 
+    // If multi-threading GPU, the frame rendered is the one synced at the end of the last frame, which may have
+    // been skipped. Sync it now while the PPC main board thread is still waiting
+    if (m_gpuMultiThreaded && m_renderVideo && m_gpuSyncPending)
+      SyncGPUs();
+
+    // The drive board thread reads the game's inputs too, so they can't be left for the PPC main board thread to poll
+    if (DriveBoard->IsAttached())
+      Inputs->PollGameInputs();
+
     // Wake threads for PPC main board (if multi-threading GPU), sound board (if sync'd) and drive board (if attached) so they can process a frame
     if ((m_gpuMultiThreaded       && !ppcBrdThreadSync->Post()) ||
         (syncSndBrdThread         && !sndBrdThreadSync->Post()) ||
         (DriveBoard->IsAttached()  && !drvBrdThreadSync->Post()))
       goto ThreadError;
 
+    // Without audio output the audio callback no longer paces an unsync'd sound board thread, so keep it going from here
+    if (!syncSndBrdThread && !m_outputAudio)
+      WakeSoundBoardThread();
+
     // If not multi-threading GPU, then run PPC main board for a frame and sync GPUs now in this thread
     if (!m_gpuMultiThreaded)
     {
       RunMainBoardFrame();
-      SyncGPUs();
+      SyncGPUsForOutput();
     }
 
     // Render frame
-    RenderFrame();
+    if (m_renderVideo)
+      RenderFrame();
 
     // Enter notify wait critical section
     if (!notifyLock->Lock())
       goto ThreadError;
 
-    // Wait for PPC main board, sound board and drive board threads to finish their work (if they are running and haven't finished already)
+    // Wait for PPC main board, sound board and drive board threads to finish their work (if they are running and haven't finished already).
+    // If the game's inputs are polled late, keep their devices up to date in the meantime
+    unsigned devicePollPeriod = m_gpuMultiThreaded ? Inputs->GetDevicePollPeriod() : 0;
     while ((m_gpuMultiThreaded      && !ppcBrdThreadDone) ||
            (syncSndBrdThread        && !sndBrdThreadDone) ||
            (DriveBoard->IsAttached() && !drvBrdThreadDone))
     {
-      if (!notifySync->Wait(notifyLock))
+      if (devicePollPeriod == 0)
+      {
+        if (!notifySync->Wait(notifyLock))
+          goto ThreadError;
+        continue;
+      }
+      if (!notifySync->Wait(notifyLock, devicePollPeriod) || !notifyLock->Unlock())
+        goto ThreadError;
+      Inputs->PollDevices();
+      if (!notifyLock->Lock())
         goto ThreadError;
     }
     ppcBrdThreadDone = false;
@@ -1993,17 +2028,18 @@ void CModel3::RunFrame(void)
 
     // If multi-threading GPU, then sync GPUs last while PPC main board thread is waiting
     if (m_gpuMultiThreaded)
-      SyncGPUs();
+      SyncGPUsForOutput();
 
-    if (NetBoard->IsRunning() && m_config["SimulateNet"].ValueAs<bool>())
+    if (NetBoard->IsRunning() && m_simulateNet.Value())
         RunNetBoardFrame();
   }
   else
   {
     // If not multi-threaded, then just process and render a single frame for PPC main board, sound board and drive board in turn in this thread
     RunMainBoardFrame();
-    SyncGPUs();
-    RenderFrame();
+    SyncGPUsForOutput();
+    if (m_renderVideo)
+      RenderFrame();
     RunSoundBoardFrame();
     if (DriveBoard->IsAttached())
       RunDriveBoardFrame();
@@ -2153,10 +2189,21 @@ void CModel3::SyncGPUs(void)
 
   timings.syncSize = GPU.SyncSnapshots() + TileGen.SyncSnapshots();
   gpusReady = true;
+  m_gpuSyncPending = false;
 
   timings.syncTicks = CThread::GetTicks() - start;
 }
 
+void CModel3::SyncGPUsForOutput(void)
+{
+  // Snapshots are only taken for frames that may be rendered. Writes keep
+  // accumulating in the dirty page maps until the next sync
+  if (m_renderVideo || m_syncVideo)
+    SyncGPUs();
+  else
+    m_gpuSyncPending = true;
+}
+
 void CModel3::RenderFrame(void)
 {
   UINT32 start = CThread::GetTicks();
@@ -2174,6 +2221,7 @@ void CModel3::RenderFrame(void)
     GPU.EndFrame();
     TileGen.EndFrame();
     m_superAA->Draw();
+    timings.uploadMicros = m_render3D->GetUploadTime();
   }
 
   EndFrameVideo();
@@ -2181,6 +2229,19 @@ void CModel3::RenderFrame(void)
   timings.renderTicks = CThread::GetTicks() - start;
 }
 
+void CModel3::SetFrameOutput(bool renderVideo, bool outputAudio, bool syncVideo)
+{
+  m_renderVideo = renderVideo;
+  m_outputAudio = outputAudio;
+  m_syncVideo = syncVideo;
+  SoundBoard.SetAudioOutput(outputAudio);
+}
+
+uint32_t CModel3::HashRAM(void)
+{
+  return Util::CRC32(0, ram, 0x800000);
+}
+
 bool CModel3::RunSoundBoardFrame(void)
 {
   UINT32 start = CThread::GetTicks();
@@ -2198,7 +2259,9 @@ void CModel3::RunDriveBoardFrame(void)
 
 void CModel3::RunNetBoardFrame(void)
 {
+  UINT32 start = CThread::GetTicks();
   NetBoard->RunFrame();
+  timings.netTicks = CThread::GetTicks() - start;
 }
 
 bool CModel3::StartThreads(void)
@@ -2456,9 +2519,10 @@ void CModel3::DeleteThreadObjects(void)
 
 void CModel3::DumpTimings(void)
 {
-  printf("PPC:%3ums%c render:%3ums%c sync:%4uK%c%3ums%c snd:%3ums%c drv:%3ums%c frame:%3ums%c\n",
+  printf("PPC:%3ums%c render:%3ums%c upload:%5uus%c sync:%4uK%c%3ums%c snd:%3ums%c drv:%3ums%c frame:%3ums%c\n",
     timings.ppcTicks, (timings.ppcTicks > timings.renderTicks ? '!' : ','),
     timings.renderTicks, (timings.renderTicks > timings.ppcTicks ? '!' : ','),
+    timings.uploadMicros, (timings.uploadMicros > 1000 ? '!' : ','),
     timings.syncSize / 1024, (timings.syncSize / 1024 > 128 ? '!' : ','),
     timings.syncTicks, (timings.syncTicks > 1 ? '!' : ','),
     timings.sndTicks, (timings.sndTicks > 10 ? '!' : ','),
@@ -2800,6 +2864,7 @@ void CModel3::Reset(void)
 {
   // Clear memory (but do not modify backup RAM!)
   memset(ram, 0, 0x800000);
+  ramDirty.MarkAll();
 
   // Initial bank is bank 0
   SetCROMBank(0xFF);
@@ -2866,49 +2931,111 @@ Result CModel3::LoadGame(const Game &game, const ROMSet &rom_set)
 {
   m_game = Game();
 
-  /*
-   * Copy in ROM data with mirroring as necessary for the following cases:
-   *
-   *  - VROM: 64MB. If <= 32MB, mirror to high 32MB.
-   *  - Banked CROM: 128MB. If <= 64MB, mirror to high 64MB.
-   *  - Fixed CROM: 8MB. If < 8MB, loaded only in high part of space and low
-   *    part is a mirror of (banked) CROM0.
-   *  - Sample ROM: 16MB. If <= 8MB, mirror to high 8MB.
-   */
-  if (rom_set.get_rom("vrom").size <= 32*0x100000)
+  // ROM regions as they end up in memory. The ROM image cache stores exactly
+  // these, so a cached image replaces all of the assembly below.
+  struct ImageSection
   {
-    rom_set.get_rom("vrom").CopyTo(&vrom[0], 32*100000);
-    rom_set.get_rom("vrom").CopyTo(&vrom[32*0x100000], 32*0x100000);
-  }
-  else
-    rom_set.get_rom("vrom").CopyTo(vrom, 64*0x100000);
-  if (rom_set.get_rom("banked_crom").size <= 64*0x100000)
+    const char *name;
+    UINT8 *ptr;
+    size_t size;
+    size_t rom_size;
+  } image[] =
   {
-    rom_set.get_rom("banked_crom").CopyTo(&crom[8*0x100000 + 0], 64*0x100000);
-    rom_set.get_rom("banked_crom").CopyTo(&crom[8*0x100000 + 64*0x100000], 64*0x100000);
-  }
-  else
-    rom_set.get_rom("banked_crom").CopyTo(&crom[8*0x100000 + 0], 128*0x100000);
-  size_t crom_size = rom_set.get_rom("crom").size;
-  rom_set.get_rom("crom").CopyTo(&crom[8*0x100000 - crom_size], crom_size);
-  if (crom_size < 8*0x100000)
-    rom_set.get_rom("banked_crom").CopyTo(&crom[0], 8*0x100000 - crom_size);
-  if (rom_set.get_rom("sound_samples").size <= 8*0x100000)
+    { "crom",               crom,       8*0x100000 + 128*0x100000,  0 },
+    { "vrom",               vrom,       64*0x100000,                0 },
+    { "sound_program",      soundROM,   512*1024,                   0 },
+    { "sound_samples",      sampleROM,  16*0x100000,                0 },
+    { "mpeg_program",       dsbROM,     128*1024,                   0 },
+    { "mpeg_music",         mpegROM,    16*0x100000,                0 },
+    { "driveboard_program", driveROM,   64*1024,                    0 }
+  };
+  auto rom_size = [&image](const std::string &name) -> size_t
+  {
+    for (auto &section: image)
+    {
+      if (name == section.name)
+        return section.rom_size;
+    }
+    return 0;
+  };
+
+  if (rom_set.image_cache && rom_set.image_cache->IsOpen())
   {
-    rom_set.get_rom("sound_samples").CopyTo(&sampleROM[0], 8*0x100000);
-    rom_set.get_rom("sound_samples").CopyTo(&sampleROM[8*0x100000], 8*0x100000);
+    for (auto &section: image)
+    {
+      if (Result::OKAY != rom_set.image_cache->LoadSection(section.ptr, section.size, &section.rom_size, section.name))
+        return Result::FAIL;
+    }
   }
   else
-    rom_set.get_rom("sound_samples").CopyTo(sampleROM, 16*0x100000);
-  rom_set.get_rom("sound_program").CopyTo(soundROM, 512*1024);
-  rom_set.get_rom("mpeg_program").CopyTo(dsbROM, 128*1024);
-  rom_set.get_rom("mpeg_music").CopyTo(mpegROM, 16*0x100000);
-  rom_set.get_rom("driveboard_program").CopyTo(driveROM, 64*1024);
+  {
+    /*
+     * Copy in ROM data with mirroring as necessary for the following cases:
+     *
+     *  - VROM: 64MB. If <= 32MB, mirror to high 32MB.
+     *  - Banked CROM: 128MB. If <= 64MB, mirror to high 64MB.
+     *  - Fixed CROM: 8MB. If < 8MB, loaded only in high part of space and low
+     *    part is a mirror of (banked) CROM0.
+     *  - Sample ROM: 16MB. If <= 8MB, mirror to high 8MB.
+     */
+    if (rom_set.get_rom("vrom").size <= 32*0x100000)
+    {
+      rom_set.get_rom("vrom").CopyTo(&vrom[0], 32*100000);
+      rom_set.get_rom("vrom").CopyTo(&vrom[32*0x100000], 32*0x100000);
+    }
+    else
+      rom_set.get_rom("vrom").CopyTo(vrom, 64*0x100000);
+    if (rom_set.get_rom("banked_crom").size <= 64*0x100000)
+    {
+      rom_set.get_rom("banked_crom").CopyTo(&crom[8*0x100000 + 0], 64*0x100000);
+      rom_set.get_rom("banked_crom").CopyTo(&crom[8*0x100000 + 64*0x100000], 64*0x100000);
+    }
+    else
+      rom_set.get_rom("banked_crom").CopyTo(&crom[8*0x100000 + 0], 128*0x100000);
+    size_t crom_size = rom_set.get_rom("crom").size;
+    rom_set.get_rom("crom").CopyTo(&crom[8*0x100000 - crom_size], crom_size);
+    if (crom_size < 8*0x100000)
+      rom_set.get_rom("banked_crom").CopyTo(&crom[0], 8*0x100000 - crom_size);
+    if (rom_set.get_rom("sound_samples").size <= 8*0x100000)
+    {
+      rom_set.get_rom("sound_samples").CopyTo(&sampleROM[0], 8*0x100000);
+      rom_set.get_rom("sound_samples").CopyTo(&sampleROM[8*0x100000], 8*0x100000);
+    }
+    else
+      rom_set.get_rom("sound_samples").CopyTo(sampleROM, 16*0x100000);
+    rom_set.get_rom("sound_program").CopyTo(soundROM, 512*1024);
+    rom_set.get_rom("mpeg_program").CopyTo(dsbROM, 128*1024);
+    rom_set.get_rom("mpeg_music").CopyTo(mpegROM, 16*0x100000);
+    rom_set.get_rom("driveboard_program").CopyTo(driveROM, 64*1024);
+
+    // Convert PowerPC and 68K ROMs to little endian words
+    Util::FlipEndian32(crom, 8*0x100000 + 128*0x100000);
+    Util::FlipEndian16(soundROM, 512*1024);
+    Util::FlipEndian16(sampleROM, 16*0x100000);
 
-  // Convert PowerPC and 68K ROMs to little endian words
-  Util::FlipEndian32(crom, 8*0x100000 + 128*0x100000);
-  Util::FlipEndian16(soundROM, 512*1024);
-  Util::FlipEndian16(sampleROM, 16*0x100000);
+    // 68K program for DSB2 needs to be byte swapped
+    if (rom_set.get_rom("mpeg_program").size && game.mpeg_board == "DSB2")
+      Util::FlipEndian16(dsbROM, 128*1024);
+
+    for (auto &section: image)
+      section.rom_size = rom_set.get_rom(section.name).size;
+    image[0].rom_size += rom_set.get_rom("banked_crom").size;
+
+    if (rom_set.image_cache)
+    {
+      std::vector<ROMImageCache::Section> sections;
+      for (auto &section: image)
+      {
+        ROMImageCache::Section cached;
+        cached.name = section.name;
+        cached.data = section.ptr;
+        cached.size = section.size;
+        cached.rom_size = section.rom_size;
+        sections.push_back(cached);
+      }
+      rom_set.image_cache->Save(sections); // failure only costs the next startup
+    }
+  }
 
   // Configure CPU and PCI bridge
   PPC_CONFIG  ppc_config;
@@ -2959,7 +3086,7 @@ Result CModel3::LoadGame(const Game &game, const ROMSet &rom_set)
   m_jtag.SetStepping(m_stepping);
 
   // MPEG board (if present)
-  if (rom_set.get_rom("mpeg_program").size)
+  if (rom_size("mpeg_program"))
   {
     if (game.mpeg_board == "DSB1")
     {
@@ -2969,7 +3096,6 @@ Result CModel3::LoadGame(const Game &game, const ROMSet &rom_set)
     }
     else if (game.mpeg_board == "DSB2")
     {
-      Util::FlipEndian16(dsbROM, 128*1024); // 68K program needs to be byte swapped
       DSB = new(std::nothrow) CDSB2(m_config);
       if (NULL == DSB)
         return ErrorLog("Insufficient memory for Digital Sound Board object.");
@@ -2984,19 +3110,19 @@ Result CModel3::LoadGame(const Game &game, const ROMSet &rom_set)
   SoundBoard.AttachDSB(DSB);
 
   // Drive board (if present)
-  if (game.driveboard_type == Game::DRIVE_BOARD_WHEEL && rom_set.get_rom("driveboard_program").size)
+  if (game.driveboard_type == Game::DRIVE_BOARD_WHEEL && rom_size("driveboard_program"))
   {
     DriveBoard = new CWheelBoard(m_config);
     if (DriveBoard->Init(driveROM) != Result::OKAY)
       return Result::FAIL;
   }
-  else if (game.driveboard_type == Game::DRIVE_BOARD_JOYSTICK && rom_set.get_rom("driveboard_program").size)
+  else if (game.driveboard_type == Game::DRIVE_BOARD_JOYSTICK && rom_size("driveboard_program"))
   {
     DriveBoard = new CJoyBoard(m_config);
     if (DriveBoard->Init(driveROM) != Result::OKAY)
       return Result::FAIL;
   }
-  else if (game.driveboard_type == Game::DRIVE_BOARD_BILLBOARD && rom_set.get_rom("driveboard_program").size)
+  else if (game.driveboard_type == Game::DRIVE_BOARD_BILLBOARD && rom_size("driveboard_program"))
   {
     DriveBoard = new CBillBoard(m_config);
     if (DriveBoard->Init(driveROM) != Result::OKAY)
@@ -3063,6 +3189,7 @@ void CModel3::AttachRenderers(CRender2D *Render2DPtr, IRender3D *Render3DPtr, Su
 {
   TileGen.AttachRenderer(Render2DPtr);
   GPU.AttachRenderer(Render3DPtr);
+  m_render3D = Render3DPtr;
   m_superAA = superAA;
 }
 
@@ -3137,6 +3264,7 @@ Result CModel3::Init(void)
 
   // Set up pointers
   ram = &memoryPool[RAM_OFFSET];
+  ramDirty.Resize(0x800000);
   crom = &memoryPool[CROM_OFFSET];
   vrom = &memoryPool[VROM_OFFSET];
   soundROM = &memoryPool[SOUNDROM_OFFSET];
@@ -3199,12 +3327,14 @@ CModel3::CModel3(Util::Config::Node &config)
   : m_config(config),
     m_multiThreaded(config["MultiThreaded"].ValueAs<bool>()),
     m_gpuMultiThreaded(config["GPUMultiThreaded"].ValueAs<bool>()),
+    m_simulateNet(config, "SimulateNet"),
     sndBrdWakeNotify(false),
     TileGen(config),
     GPU(config),
     SoundBoard(config),
     m_jtag(GPU),
-    m_superAA(nullptr)
+    m_superAA(nullptr),
+    m_render3D(nullptr)
 {
   // Initialize pointers so dtor can know whether to free them
   memoryPool = NULL;
@@ -3247,7 +3377,11 @@ CModel3::CModel3(Util::Config::Node &config)
   drvBrdThreadRunning = false;
   drvBrdThreadDone = false;
 
-  syncSndBrdThread = false;
+  // Running ahead and input recordings need the sound board to advance
+  // exactly one frame per RunFrame(), not at the pace of the audio callback
+  syncSndBrdThread = config["RunAhead"].ValueAs<unsigned>() > 0 ||
+    !config["RecordInputs"].ValueAs<std::string>().empty() ||
+    !config["ReplayInputs"].ValueAs<std::string>().empty();
   ppcBrdThreadSync = NULL;
   sndBrdThreadSync = NULL;
   drvBrdThreadSync = NULL;
@@ -43,6 +43,7 @@
 #include "CPU/PowerPC/ppc.h"
 #include "Network/INetBoard.h"
 #include "Util/NewConfig.h"
+#include "Util/DirtyPageMap.h"
 #include "Graphics/SuperAA.h"
 #include "OSD/Thread.h"
 
@@ -61,6 +62,7 @@ struct FrameTimings
   UINT32 drvTicks;
   UINT32 netTicks;
   UINT32 frameTicks;
+  UINT32 uploadMicros;  // GPU vertex upload time reported by the 3D renderer
   UINT64 frameId;
 };
 
@@ -82,12 +84,14 @@ public:
   bool PauseThreads(void);
   bool ResumeThreads(void);
   void SaveState(CBlockFile *SaveState);
-  void LoadState(CBlockFile *SaveState);
+  void LoadState(CBlockFile *SaveState, bool incremental);
   void SaveNVRAM(CBlockFile *NVRAM);
   void LoadNVRAM(CBlockFile *NVRAM);
   void ClearNVRAM(void);
   void RunFrame(void);
   void RenderFrame(void);
+  void SetFrameOutput(bool renderVideo, bool outputAudio, bool syncVideo);
+  uint32_t HashRAM(void);
   void Reset(void);
   const Game &GetGame(void) const;
   void AttachRenderers(CRender2D *Render2DPtr, IRender3D *Render3DPtr, SuperAA *superAA);
@@ -203,6 +207,7 @@ private:
 
   void RunMainBoardFrame(void);                       // Runs PPC main board for a frame
   void SyncGPUs(void);                                // Sync's up GPUs in preparation for rendering - must be called when PPC is not running
+  void SyncGPUsForOutput(void);                       // Same as above, unless disabled for frames that aren't rendered
   bool RunSoundBoardFrame(void);                      // Runs sound board for a frame
   void RunDriveBoardFrame(void);                      // Runs drive board for a frame
   void RunNetBoardFrame(void);                        // Runs net board for a frame
@@ -228,6 +233,11 @@ private:
   Util::Config::Node &m_config;
   bool m_multiThreaded;
   bool m_gpuMultiThreaded;
+  Util::Config::Handle<bool> m_simulateNet;
+  bool m_renderVideo = true;  // RunFrame() renders (off for frames that are thrown away or skipped)
+  bool m_outputAudio = true;
+  bool m_syncVideo = true;    // sync GPUs on frames that aren't rendered
+  bool m_gpuSyncPending = false;
 
   // Game and hardware information
   Game m_game;
@@ -249,6 +259,7 @@ private:
   // Emulated core Model 3 memory regions
   UINT8   *memoryPool;  // single allocated region for all ROM and system RAM
   UINT8   *ram;         // 8 MB PowerPC RAM
+  Util::DirtyPageMap ramDirty;  // pages of PowerPC RAM written since the last rewind snapshot
   UINT8   *crom;        // 8+128 MB CROM (fixed CROM first, then 64MB of banked CROMs -- Daytona2 might need extra?)
   UINT8   *vrom;        // 64 MB VROM (video ROM, visible only to Real3D)
   UINT8   *soundROM;    // 512 KB sound ROM (68K program)
@@ -317,6 +328,7 @@ private:
   CCrypto     m_cryptoDevice; // Encryption device
   CJTAG       m_jtag;         // JTAG interface
   SuperAA     *m_superAA;
+  IRender3D   *m_render3D;
   INetBoard   *NetBoard;      // Net board
   bool		    m_runNetBoard;
 };
@@ -53,9 +53,9 @@ public:
   {
   }
 
-  void LoadState(CBlockFile *SaveState) override
+  void LoadState(CBlockFile *SaveState, bool incremental) override
   {
-    m_real3D.LoadState(SaveState);
+    m_real3D.LoadState(SaveState, incremental);
     m_tileGen.LoadState(SaveState);
   }
 
@@ -73,7 +73,18 @@ public:
 
   void RunFrame(void) override
   {
-    RenderFrame();
+    if (m_renderVideo)
+      RenderFrame();
+  }
+
+  void SetFrameOutput(bool renderVideo, bool outputAudio, bool syncVideo) override
+  {
+    m_renderVideo = renderVideo;
+  }
+
+  uint32_t HashRAM(void) override
+  {
+    return 0;
   }
 
   void RenderFrame(void) override
@@ -95,7 +106,7 @@ public:
       ErrorLog("Unable to load state from '%s'.", m_stateFilePath.c_str());
     else
     {
-      LoadState(&SaveState);
+      LoadState(&SaveState, false);
       SaveState.Close();
     }
   }
@@ -173,6 +184,7 @@ private:
   CIRQ                      m_irq;
   CTileGen                  m_tileGen;
   CReal3D                   m_real3D;
+  bool                      m_renderVideo = true;
 };
 
 #endif  // INCLUDED_CMODEL3GRAPHICSSTATE_H
@@ -91,7 +91,8 @@ void CReal3D::SaveState(CBlockFile *SaveState)
 {
   SaveState->NewBlock("Real3D", __FILE__);
 
-  SaveState->Write(memoryPool, MEM_POOL_SIZE_RW); // Don't write out read-only snapshots or dirty page arrays
+  MergeDirtyPages();
+  SaveState->Write(memoryPool, MEM_POOL_SIZE_RW, &memoryPoolDirty); // Don't write out read-only snapshots or dirty page arrays
   SaveState->Write(&fifoIdx, sizeof(fifoIdx));
   SaveState->Write(m_vromTextureFIFO, sizeof(m_vromTextureFIFO));
 
@@ -128,7 +129,7 @@ void CReal3D::SaveState(CBlockFile *SaveState)
   SaveState->Write(&highCullUpdateBlockOffset, sizeof(highCullUpdateBlockOffset));
 }
 
-void CReal3D::LoadState(CBlockFile *SaveState)
+void CReal3D::LoadState(CBlockFile *SaveState, bool incremental)
 {
   if (Result::OKAY != SaveState->FindBlock("Real3D"))
   {
@@ -136,12 +137,22 @@ void CReal3D::LoadState(CBlockFile *SaveState)
     return;
   }
 
-  SaveState->Read(memoryPool, MEM_POOL_SIZE_RW);
+  const uint8_t *pool = incremental ? SaveState->ReadSpan(MEM_POOL_SIZE_RW) : NULL;
+  if (pool != NULL)
+  {
+    LoadChangedPages(pool);
+    memoryPoolDirty.MarkAll();
+  }
+  else
+  {
+    SaveState->Read(memoryPool, MEM_POOL_SIZE_RW);
+    memoryPoolDirty.MarkAll();
 
-  // If multi-threaded, update read-only snapshots too
-  if (m_gpuMultiThreaded)
-    UpdateSnapshots(true);
-  Render3D->UploadTextures(0, 0, 0, 2048, 2048);
+    // If multi-threaded, update read-only snapshots too
+    if (m_gpuMultiThreaded)
+      UpdateSnapshots(true);
+    Render3D->UploadTextures(0, 0, 0, 2048, 2048);
+  }
   SaveState->Read(&fifoIdx, sizeof(fifoIdx));
   SaveState->Read(&m_vromTextureFIFO, sizeof(m_vromTextureFIFO));
 
@@ -233,9 +244,80 @@ uint32_t CReal3D::SyncSnapshots(void)
   Render3D->SetBlockCulling(m_blockCullingRO);
 
   // Update read-only snapshots
+  MergeDirtyPages();
   return UpdateSnapshots(false);
 }
 
+void CReal3D::MergeDirtyPages(void)
+{
+  static_assert(PAGE_WIDTH == Util::DirtyPageMap::PageWidth, "dirty page arrays must match DirtyPageMap layout");
+
+  // Writes are only tracked for the read-only snapshots
+  if (!m_gpuMultiThreaded)
+  {
+    memoryPoolDirty.MarkAll();
+    return;
+  }
+
+  memoryPoolDirty.Merge(OFFSET_8E, cullingRAMHiDirty, DIRTY_SIZE(0x100000));
+  memoryPoolDirty.Merge(OFFSET_98, polyRAMDirty, DIRTY_SIZE(0x400000));
+  memoryPoolDirty.Merge(OFFSET_TEXRAM, textureRAMDirty, DIRTY_SIZE(0x800000));
+
+  // Buffered high culling and polygon RAM updates land in low culling RAM
+  // unmarked, and the texture FIFO isn't tracked at all
+  memoryPoolDirty.MarkRange(OFFSET_8C, 0x400000);
+  memoryPoolDirty.MarkRange(OFFSET_TEXFIFO, 0x100000);
+}
+
+void CReal3D::LoadChangedPages(const uint8_t *pool)
+{
+  struct Region
+  {
+    unsigned offset;
+    unsigned size;
+    uint8_t *dirty;
+  };
+  const Region regions[] =
+  {
+    { OFFSET_8C,      0x400000, cullingRAMLoDirty },
+    { OFFSET_8E,      0x100000, cullingRAMHiDirty },
+    { OFFSET_98,      0x400000, polyRAMDirty },
+    { OFFSET_TEXRAM,  0x800000, textureRAMDirty },
+    { OFFSET_TEXFIFO, 0x100000, NULL }
+  };
+
+  // Each page of texture RAM is one row of the 2048x2048 texture sheet
+  static_assert(2048 * sizeof(uint16_t) == PAGE_SIZE, "texture rows must be one page");
+  unsigned firstRow = 2048;
+  unsigned lastRow = 0;
+
+  for (const Region &region : regions)
+  {
+    for (unsigned addr = 0; addr < region.size; addr += PAGE_SIZE)
+    {
+      const uint8_t *src = pool + region.offset + addr;
+      uint8_t *dst = memoryPool + region.offset + addr;
+      if (memcmp(dst, src, PAGE_SIZE) == 0)
+        continue;
+      memcpy(dst, src, PAGE_SIZE);
+
+      // Changed pages reach the read-only snapshots as if they had been written
+      if (m_gpuMultiThreaded && region.dirty != NULL)
+        MARK_DIRTY(region.dirty, addr);
+      if (region.offset == OFFSET_TEXRAM)
+      {
+        firstRow = (std::min)(firstRow, addr / PAGE_SIZE);
+        lastRow = (std::max)(lastRow, addr / PAGE_SIZE);
+      }
+    }
+  }
+
+  if (m_gpuMultiThreaded)
+    UpdateSnapshots(false);
+  if (firstRow <= lastRow)
+    Render3D->UploadTextures(0, 0, firstRow, 2048, lastRow - firstRow + 1);
+}
+
 uint32_t CReal3D::UpdateSnapshot(bool copyWhole, uint8_t *src, uint8_t *dst, unsigned size, uint8_t *dirty)
 {
   unsigned dirtySize = DIRTY_SIZE(size);
@@ -1053,6 +1135,7 @@ void CReal3D::Reset(void)
 
   unsigned memSize = (m_gpuMultiThreaded ? MEMORY_POOL_SIZE : MEM_POOL_SIZE_RW);
   memset(memoryPool, 0, memSize);
+  memoryPoolDirty.MarkAll();
   memset(m_vromTextureFIFO, 0, sizeof(m_vromTextureFIFO));
   memset(m_internalRenderConfig, 0, sizeof(m_internalRenderConfig));
 
@@ -1113,6 +1196,8 @@ Result CReal3D::Init(const uint8_t *vromPtr, IBus *BusObjectPtr, CIRQ *IRQObject
   if (NULL == memoryPool)
     return ErrorLog("Insufficient memory for Real3D object (needs %1.1f MB).", memSizeMB);
 
+  memoryPoolDirty.Resize(MEM_POOL_SIZE_RW);
+
   // Set up main pointers
   cullingRAMLo = (uint32_t *) &memoryPool[OFFSET_8C];
   cullingRAMHi = (uint32_t *) &memoryPool[OFFSET_8E];
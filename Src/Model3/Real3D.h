@@ -35,6 +35,7 @@
 #include "CPU/Bus.h"
 #include "Graphics/IRender3D.h"
 #include "Util/NewConfig.h"
+#include "Util/DirtyPageMap.h"
 
 #include <cstdint>
 #include <unordered_map>
@@ -94,14 +95,17 @@ public:
   void SaveState(CBlockFile *SaveState);
 
   /*
-   * LoadState(SaveState):
+   * LoadState(SaveState, incremental):
    *
    * Loads and a state image.
    *
    * Parameters:
-   *    SaveState   Block file to load state information from.
+   *    SaveState     Block file to load state information from.
+   *    incremental   If true, the renderer is up to date with the current
+   *                  memory, so only pages that differ are copied and only
+   *                  texture rows that differ are uploaded.
    */
-  void LoadState(CBlockFile *SaveState);
+  void LoadState(CBlockFile *SaveState, bool incremental);
 
   /*
    * BeginVBlank(void):
@@ -463,6 +467,8 @@ private:
 
   void      UploadTexture(uint32_t header, const uint16_t *texData);
   uint32_t  UpdateSnapshots(bool copyWhole);
+  void      MergeDirtyPages(void);
+  void      LoadChangedPages(const uint8_t *pool);
   uint32_t  UpdateSnapshot(bool copyWhole, uint8_t *src, uint8_t *dst, unsigned size, uint8_t *dirty);
   void      SyncBufferedMem(UpdateBlock* updateBlock, uint32_t* updateBuffer, uint32_t* dst, uint8_t* dirty);
   void      FlushTextures();
@@ -518,6 +524,10 @@ private:
   uint8_t   *polyRAMDirty = nullptr;
   uint8_t   *textureRAMDirty = nullptr;
 
+  // Pages of the read-write memory pool written since the last rewind snapshot
+  // (accumulated from the arrays above before they are cleared)
+  Util::DirtyPageMap memoryPoolDirty;
+
   // Queued texture uploads
   std::vector<QueuedUploadTextures> queuedUploadTextures;
   std::vector<QueuedUploadTextures> queuedUploadTexturesRO;  // Read-only copy of queue
@@ -217,6 +217,7 @@ void CSoundBoard::Write8(unsigned int a,unsigned char d)
 	switch ((a>>20)&0xF)
 	{
 	case 0x0:	// SCSP RAM 1 (master): 000000-0FFFFF
+		ram1Dirty.Mark(a);
 		ram1[a^1] = d;
 		break;
 		
@@ -225,6 +226,7 @@ void CSoundBoard::Write8(unsigned int a,unsigned char d)
 		break;
 		
 	case 0x2:	// SCSP RAM 2 (slave): 200000-2FFFFF
+		ram2Dirty.Mark(a&0x0FFFFF);
 		ram2[(a&0x0FFFFF)^1] = d;
 		break;
 	
@@ -249,6 +251,7 @@ void CSoundBoard::Write16(unsigned int a,unsigned short d)
 	switch ((a>>20)&0xF)
 	{
 	case 0x0:	// SCSP RAM 1 (master): 000000-0FFFFF
+		ram1Dirty.Mark(a);
 		*(UINT16 *) &ram1[a] = d;
 		break;
 		
@@ -257,6 +260,7 @@ void CSoundBoard::Write16(unsigned int a,unsigned short d)
 		break;
 		
 	case 0x2:	// SCSP RAM 2 (slave): 200000-2FFFFF
+		ram2Dirty.Mark(a&0x0FFFFF);
 		*(UINT16 *) &ram2[a&0x0FFFFF] = d;
 		break;
 	
@@ -275,6 +279,11 @@ void CSoundBoard::Write32(unsigned int a,unsigned int d)
 	switch ((a>>20)&0xF)
 	{
 	case 0x0:	// SCSP RAM 1 (master): 000000-0FFFFF
+		ram1Dirty.Mark(a);
+		if (a+2 < 0x100000)
+			ram1Dirty.Mark(a+2);
+		else
+			ram2Dirty.Mark(0);	// spills over into RAM 2
 		*(UINT16 *) &ram1[a] = (d>>16);
 		*(UINT16 *) &ram1[a+2] = (d&0xFFFF);
 		break;
@@ -284,6 +293,8 @@ void CSoundBoard::Write32(unsigned int a,unsigned int d)
 		break;
 		
 	case 0x2:	// SCSP RAM 2 (slave): 200000-2FFFFF
+		ram2Dirty.Mark(a&0x0FFFFF);
+		ram2Dirty.Mark((a+2)&0x0FFFFF);
 		*(UINT16 *) &ram2[a&0x0FFFFF] = (d>>16);
 		*(UINT16 *) &ram2[(a+2)&0x0FFFFF] = (d&0xFFFF);
 		break;
@@ -353,8 +364,10 @@ static INT16 ClampINT16(float x)
 
 bool CSoundBoard::RunFrame(void)
 {
+	Util::Config::FrameScope frameScope;
+
 	// Run sound board first to generate SCSP audio
-	if (m_config["EmulateSound"].ValueAs<bool>())
+	if (m_emulateSound.Value())
 	{
 		M68KSetContext(&M68K);
 		SCSP_Update();
@@ -369,7 +382,7 @@ bool CSoundBoard::RunFrame(void)
 	}
 
 	// Compute sound volume as 
-	float soundVol = (float)std::max(0,std::min(200,m_config["SoundVolume"].ValueAs<int>()));
+	float soundVol = (float)std::max(0,std::min(200,m_soundVolume.Value()));
 	soundVol = soundVol * (float)(1.0 / 100.0);
 
 	// Apply sound volume setting to SCSP channels only
@@ -391,8 +404,11 @@ bool CSoundBoard::RunFrame(void)
 			DSB->RunFrame(audioRL, audioRR);
 	}
 
-	// Output the audio buffers
-	bool bufferFull = OutputAudio(NUM_SAMPLES_PER_FRAME, audioFL, audioFR, audioRL, audioRR, m_config["FlipStereo"].ValueAs<bool>());
+	// Output the audio buffers (when discarded, report the buffer as full so
+	// that an unsync'd sound board thread doesn't keep running frames)
+	if (!outputAudio)
+		return true;
+	bool bufferFull = OutputAudio(NUM_SAMPLES_PER_FRAME, audioFL, audioFR, audioRL, audioRR, m_flipStereo.Value());
 
 #ifdef SUPERMODEL_LOG_AUDIO
 	// Output to binary file
@@ -413,10 +429,17 @@ bool CSoundBoard::RunFrame(void)
 	return bufferFull;
 }
 
+void CSoundBoard::SetAudioOutput(bool enable)
+{
+	outputAudio = enable;
+}
+
 void CSoundBoard::Reset(void)
 {
 	// Even if SCSP emulation is disabled, we must reset to establish a valid 68K state
 	memcpy(ram1, soundROM, 16);				// copy 68K vector table
+	ram1Dirty.MarkAll();
+	ram2Dirty.MarkAll();
 	ctrlReg = 0;							// set default banks
 	UpdateROMBanks();
 	M68KSetContext(&M68K);
@@ -435,8 +458,8 @@ void CSoundBoard::Reset(void)
 void CSoundBoard::SaveState(CBlockFile *SaveState)
 {
 	SaveState->NewBlock("Sound Board", __FILE__);
-	SaveState->Write(ram1, 0x100000);
-	SaveState->Write(ram2, 0x100000);
+	SaveState->Write(ram1, 0x100000, &ram1Dirty);
+	SaveState->Write(ram2, 0x100000, &ram2Dirty);
 	SaveState->Write(&ctrlReg, sizeof(ctrlReg));
 	
 	// All other devices...
@@ -457,6 +480,8 @@ void CSoundBoard::LoadState(CBlockFile *SaveState)
 	
 	SaveState->Read(ram1, 0x100000);
 	SaveState->Read(ram2, 0x100000);
+	ram1Dirty.MarkAll();
+	ram2Dirty.MarkAll();
 	SaveState->Read(&ctrlReg, sizeof(ctrlReg));
 	UpdateROMBanks();
 	
@@ -500,6 +525,8 @@ Result CSoundBoard::Init(const UINT8 *soundROMPtr, const UINT8 *sampleROMPtr)
 	// Set up memory pointers
 	ram1 = &memoryPool[OFFSET_RAM1];
 	ram2 = &memoryPool[OFFSET_RAM2];
+	ram1Dirty.Resize(0x100000);
+	ram2Dirty.Resize(0x100000);
 	audioFL = (float*)&memoryPool[OFFSET_AUDIO_FRONTLEFT];
 	audioFR = (float*)&memoryPool[OFFSET_AUDIO_FRONTRIGHT];
 	audioRL = (float*)&memoryPool[OFFSET_AUDIO_REARLEFT];
@@ -519,6 +546,8 @@ Result CSoundBoard::Init(const UINT8 *soundROMPtr, const UINT8 *sampleROMPtr)
 		return Result::FAIL;
 	SCSP_SetRAM(0, ram1);
 	SCSP_SetRAM(1, ram2);
+	SCSP_SetRAMDirtyMap(0, &ram1Dirty);
+	SCSP_SetRAMDirtyMap(1, &ram2Dirty);
 	
 	// Binary logging
 #ifdef SUPERMODEL_LOG_AUDIO
@@ -541,7 +570,10 @@ CDSB *CSoundBoard::GetDSB(void)
 }
 
 CSoundBoard::CSoundBoard(const Util::Config::Node &config)
-  : m_config(config)
+  : m_config(config),
+    m_emulateSound(config, "EmulateSound"),
+    m_soundVolume(config, "SoundVolume"),
+    m_flipStereo(config, "FlipStereo")
 {
 	DSB = NULL;
 	memoryPool = NULL;
@@ -556,6 +588,7 @@ CSoundBoard::CSoundBoard(const Util::Config::Node &config)
 
 	sampleBank = nullptr;
 	ctrlReg = 0;
+	outputAudio = true;
 
 	DebugLog("Built Sound Board\n");
 }
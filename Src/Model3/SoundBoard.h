@@ -31,6 +31,7 @@
 #include "Types.h"
 #include "CPU/Bus.h"
 #include "Model3/DSB.h"
+#include "Util/DirtyPageMap.h"
 
 /*
  * CSoundBoard:
@@ -111,6 +112,17 @@ public:
 	 */
 	bool RunFrame(void);
 
+	/*
+	 * SetAudioOutput(enable):
+	 *
+	 * Sets whether RunFrame() passes the sound it generates on to the audio
+	 * output. The sound board is emulated the same way either way.
+	 *
+	 * Parameters:
+	 *		enable	True to output audio (default), false to discard it.
+	 */
+	void SetAudioOutput(bool enable);
+
 	/*
 	 * Reset(void):
 	 *
@@ -184,6 +196,9 @@ private:
 	
 	// Config
 	const Util::Config::Node &m_config;
+	Util::Config::Handle<bool>	m_emulateSound;
+	Util::Config::Handle<int>	m_soundVolume;
+	Util::Config::Handle<bool>	m_flipStereo;
 
 	// Digital Sound Board
 	CDSB		*DSB;
@@ -197,6 +212,7 @@ private:
 	const UINT8	*sampleBank;	// sample ROM bank switching (points to high or low 8MB)
 	UINT8		*memoryPool;	// single allocated region for all sound board RAM
 	UINT8		*ram1, *ram2;	// SCSP1 and SCSP2 RAM
+	Util::DirtyPageMap	ram1Dirty, ram2Dirty;	// pages written since the last rewind snapshot
 	
 	// Registers
 	UINT8	ctrlReg;			// control register: ROM banking
@@ -204,6 +220,7 @@ private:
 	// Audio
 	float* audioFL, * audioFR;	// left and right front audio channels (1/60th second, 44.1 KHz)
 	float* audioRL, * audioRR;	// left and right rear audio channels (1/60th second, 44.1 KHz)
+	bool	outputAudio;		// pass generated audio on to the OSD layer
 };
 
 
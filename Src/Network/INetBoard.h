@@ -27,6 +27,17 @@
 #include "Game.h"
 #include "BlockFile.h"
 
+// Traffic on the link to the other cabinets, totals since it was set up
+struct NetLinkStats
+{
+	UINT64 bytesSent = 0;
+	UINT64 bytesReceived = 0;
+	UINT64 messagesSent = 0;
+	UINT64 messagesReceived = 0;
+	UINT64 bytesSaved = 0;			// by delta encoding, if enabled
+	UINT32 latencyMicros = 0;		// most recent wait for data from the other end
+};
+
 class INetBoard
 {
 public:
@@ -47,6 +58,8 @@ public:
 
 	virtual void GetGame(const Game&) = 0;
 
+	virtual NetLinkStats GetLinkStats(void) = 0;
+
 	virtual UINT8 ReadCommRAM8(unsigned addr) = 0;
 	virtual UINT16 ReadCommRAM16(unsigned addr) = 0;
 	virtual UINT32 ReadCommRAM32(unsigned addr) = 0;
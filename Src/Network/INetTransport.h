@@ -0,0 +1,65 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef INCLUDED_INETTRANSPORT_H
+#define INCLUDED_INETTRANSPORT_H
+
+#include <vector>
+#include <cstdint>
+
+// Message based link to the next machine in the ring. Each Send() arrives as
+// one Receive() on the other end, in order. Zero sized messages tell the other
+// machines that the link is broken.
+class INetSend
+{
+public:
+	virtual ~INetSend()
+	{
+	}
+
+	virtual bool Send(const void* data, int length) = 0;
+	virtual bool Connect() = 0;
+	virtual bool Connected() = 0;
+
+	// totals since construction, safe to read from any thread
+	virtual uint64_t BytesSent() const = 0;
+	virtual uint64_t MessagesSent() const = 0;
+};
+
+// Link from the previous machine in the ring
+class INetReceive
+{
+public:
+	virtual ~INetReceive()
+	{
+	}
+
+	virtual bool CheckDataAvailable(int timeoutMS = 0) = 0;	// timeoutMS -1 = wait forever until data arrives, 0 = no waiting, 1+ wait time in milliseconds
+	virtual std::vector<char>& Receive() = 0;
+	virtual bool Connected() = 0;
+
+	// totals since construction and the time the last Receive() spent waiting, safe to read from any thread
+	virtual uint64_t BytesReceived() const = 0;
+	virtual uint64_t MessagesReceived() const = 0;
+	virtual uint32_t LastWaitMicros() const = 0;
+};
+
+#endif
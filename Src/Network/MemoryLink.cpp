@@ -0,0 +1,215 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "MemoryLink.h"
+#include "OSD/Logger.h"
+#include "OSD/Thread.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+
+struct MemoryChannel
+{
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<std::vector<char>> messages;
+	std::vector<std::vector<char>> spare;		// buffers of received messages, reused for sending
+	bool senderConnected = false;
+	bool senderClosed = false;
+	bool receiverClosed = false;
+};
+
+// listening ports in this process
+static std::mutex s_portsMutex;
+static std::map<int, std::shared_ptr<MemoryChannel>> s_ports;
+
+MemorySend::MemorySend(int port) :
+	m_port(port),
+	m_bytesSent(0),
+	m_messagesSent(0)
+{
+}
+
+MemorySend::~MemorySend()
+{
+	if (m_channel) {
+		std::lock_guard<std::mutex> lock(m_channel->mutex);
+		m_channel->senderClosed = true;
+		m_channel->cond.notify_all();
+	}
+}
+
+bool MemorySend::Send(const void* data, int length)
+{
+	if (!Connected()) {
+		return false;
+	}
+
+	auto channel = m_channel;
+	std::lock_guard<std::mutex> lock(channel->mutex);
+
+	if (channel->receiverClosed) {
+		m_channel = nullptr;		// same as a failed socket send
+		return true;
+	}
+
+	std::vector<char> message;
+	if (!channel->spare.empty()) {
+		message = std::move(channel->spare.back());
+		channel->spare.pop_back();
+	}
+	message.assign((const char*)data, (const char*)data + length);
+	channel->messages.push_back(std::move(message));
+	channel->cond.notify_all();
+
+	m_bytesSent += length;
+	m_messagesSent++;
+
+	return true;
+}
+
+bool MemorySend::Connect()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_portsMutex);
+		auto it = s_ports.find(m_port);
+		if (it != s_ports.end()) {
+
+			// like TCPReceive, a port takes a single connection
+			std::lock_guard<std::mutex> channelLock(it->second->mutex);
+			if (!it->second->senderConnected) {
+				it->second->senderConnected = true;
+				it->second->cond.notify_all();
+				m_channel = it->second;
+			}
+		}
+	}
+
+	// callers retry until connected, don't let them spin
+	if (!m_channel) {
+		CThread::Sleep(10);
+	}
+
+	return Connected();
+}
+
+bool MemorySend::Connected()
+{
+	return m_channel != nullptr;
+}
+
+MemoryReceive::MemoryReceive(int port) :
+	m_port(port),
+	m_bytesReceived(0),
+	m_messagesReceived(0),
+	m_lastWaitMicros(0)
+{
+	m_recBuffer.reserve(0x10000);
+
+	std::lock_guard<std::mutex> lock(s_portsMutex);
+	if (s_ports.count(port)) {
+		ErrorLog("In-process net port %d is already in use.", port);
+		return;
+	}
+
+	m_channel = std::make_shared<MemoryChannel>();
+	s_ports[port] = m_channel;
+}
+
+MemoryReceive::~MemoryReceive()
+{
+	if (!m_channel) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(s_portsMutex);
+		s_ports.erase(m_port);
+	}
+
+	std::lock_guard<std::mutex> lock(m_channel->mutex);
+	m_channel->receiverClosed = true;
+	m_channel->cond.notify_all();
+}
+
+bool MemoryReceive::CheckDataAvailable(int timeoutMS)
+{
+	if (!m_channel) {
+		return false;
+	}
+
+	std::unique_lock<std::mutex> lock(m_channel->mutex);
+	if (!m_channel->senderConnected) {
+		return false;
+	}
+
+	// a closed sender counts, Receive() then reports the broken link
+	auto ready = [this] { return !m_channel->messages.empty() || m_channel->senderClosed; };
+	if (timeoutMS < 0) {
+		m_channel->cond.wait(lock, ready);
+	}
+	else if (timeoutMS > 0) {
+		m_channel->cond.wait_for(lock, std::chrono::milliseconds(timeoutMS), ready);
+	}
+
+	return ready();
+}
+
+std::vector<char>& MemoryReceive::Receive()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	if (!m_channel) {
+		m_recBuffer.clear();
+		return m_recBuffer;
+	}
+
+	std::unique_lock<std::mutex> lock(m_channel->mutex);
+	m_channel->cond.wait(lock, [this] { return !m_channel->senderConnected || !m_channel->messages.empty() || m_channel->senderClosed; });
+
+	if (m_channel->messages.empty()) {
+		m_recBuffer.clear();
+		return m_recBuffer;
+	}
+
+	// take the message's buffer and hand our previous one back for reuse
+	std::swap(m_recBuffer, m_channel->messages.front());
+	m_channel->spare.push_back(std::move(m_channel->messages.front()));
+	m_channel->messages.pop_front();
+
+	m_bytesReceived += m_recBuffer.size();
+	m_messagesReceived++;
+	m_lastWaitMicros = uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+	return m_recBuffer;
+}
+
+bool MemoryReceive::Connected()
+{
+	if (!m_channel) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_channel->mutex);
+	return m_channel->senderConnected && !m_channel->senderClosed;
+}
@@ -0,0 +1,84 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef INCLUDED_MEMORYLINK_H
+#define INCLUDED_MEMORYLINK_H
+
+#include <atomic>
+#include <memory>
+#include "INetTransport.h"
+
+/*
+ * In-process net transport, for running several linked machines inside one
+ * process (see NetLinkHarness). Ports work as they do over TCP: a
+ * MemoryReceive takes a port and a MemorySend connects to it, the address is
+ * ignored. Messages are handed over in memory and their buffers are recycled,
+ * so a running link doesn't allocate.
+ */
+
+struct MemoryChannel;
+
+class MemorySend : public INetSend
+{
+public:
+	MemorySend(int port);
+	~MemorySend();
+
+	bool Send(const void* data, int length);
+	bool Connect();
+	bool Connected();
+
+	uint64_t BytesSent() const		{ return m_bytesSent; }
+	uint64_t MessagesSent() const	{ return m_messagesSent; }
+
+private:
+
+	int m_port;
+	std::shared_ptr<MemoryChannel> m_channel;
+	std::atomic<uint64_t> m_bytesSent;
+	std::atomic<uint64_t> m_messagesSent;
+};
+
+class MemoryReceive : public INetReceive
+{
+public:
+	MemoryReceive(int port);
+	~MemoryReceive();
+
+	bool CheckDataAvailable(int timeoutMS = 0);
+	std::vector<char>& Receive();
+	bool Connected();
+
+	uint64_t BytesReceived() const		{ return m_bytesReceived; }
+	uint64_t MessagesReceived() const	{ return m_messagesReceived; }
+	uint32_t LastWaitMicros() const		{ return m_lastWaitMicros; }
+
+private:
+
+	int m_port;
+	std::shared_ptr<MemoryChannel> m_channel;
+	std::vector<char> m_recBuffer;
+	std::atomic<uint64_t> m_bytesReceived;
+	std::atomic<uint64_t> m_messagesReceived;
+	std::atomic<uint32_t> m_lastWaitMicros;
+};
+
+#endif
@@ -1320,6 +1320,23 @@ void CNetBoard::GetGame(const Game& gameinfo)
 	Gameinfo = gameinfo;
 }
 
+NetLinkStats CNetBoard::GetLinkStats(void)
+{
+	NetLinkStats stats;
+	if (nets)
+	{
+		stats.bytesSent = nets->BytesSent();
+		stats.messagesSent = nets->MessagesSent();
+	}
+	if (netr)
+	{
+		stats.bytesReceived = netr->BytesReceived();
+		stats.messagesReceived = netr->MessagesReceived();
+		stats.latencyMicros = netr->LastWaitMicros();
+	}
+	return stats;
+}
+
 UINT8 CNetBoard::ReadCommRAM8(unsigned addr)
 {
 	return CommRAM[addr];
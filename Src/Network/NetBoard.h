@@ -62,6 +62,8 @@ public:
 
 	void GetGame(const Game&);
 
+	NetLinkStats GetLinkStats(void);
+
 	UINT8 ReadCommRAM8(unsigned addr);
 	UINT16 ReadCommRAM16(unsigned addr);
 	UINT32 ReadCommRAM32(unsigned addr);
@@ -0,0 +1,260 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "NetLinkHarness.h"
+#include "SimNetBoard.h"
+#include "OSD/Logger.h"
+#include "OSD/Thread.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const unsigned SEGMENT_SIZE = 0x100;		// per machine, in the range games use
+static const unsigned CHANGING_SIZE = 0x20;		// leading part that changes every frame
+
+namespace
+{
+	struct MachineResult
+	{
+		bool linked = false;
+		unsigned framesRun = 0;
+		unsigned segmentsChecked = 0;
+		unsigned badSegments = 0;
+		double seconds = 0.0;
+		std::vector<uint32_t> frameMicros;
+		NetLinkStats stats;
+	};
+
+	// Holds the machines that are done until all of them are, so none takes its
+	// end of the ring down while the others still need it
+	class Barrier
+	{
+	public:
+		Barrier(unsigned count)
+			: m_remaining(count)
+		{
+		}
+
+		void Arrive()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (--m_remaining == 0)
+				m_cond.notify_all();
+			else
+				m_cond.wait(lock, [this] { return m_remaining == 0; });
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		unsigned m_remaining;
+	};
+}
+
+static double Seconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+
+static void RunMachine(const Util::Config::Node& baseConfig, const Game& game, bool typeTwo, unsigned index, unsigned numMachines,
+	unsigned numFrames, Barrier* barrier, MachineResult* result)
+{
+	const unsigned portBase = baseConfig["PortIn"].ValueAs<unsigned>();
+	const unsigned lookahead = baseConfig["NetLookahead"].ValueAs<unsigned>();
+	const unsigned timeoutMS = baseConfig["NetTimeout"].ValueAs<unsigned>();
+
+	// each machine listens on its own port and sends to the next one round the ring
+	Util::Config::Node config(baseConfig);
+	config.Set("Network", true);
+	config.Set("PortIn", portBase + index);
+	config.Set("PortOut", portBase + (index + 1) % numMachines);
+	config.Set<std::string>("AddressOut", "127.0.0.1");
+	config.Set<std::string>("NetTransport", "memory");
+
+	std::vector<uint8_t> ram(0x10000);
+	std::vector<uint8_t> buffer(0x20000);
+	auto board = std::make_unique<CSimNetBoard>(config);
+	board->GetGame(game);
+
+	auto fail = [&](const char* what, unsigned frame)
+	{
+		ErrorLog("Net link harness: machine %u %s (frame %u).", index, what, frame);
+		board.reset();	// lets the rest of the ring see the link go down
+		barrier->Arrive();
+	};
+
+	if (board->Init(ram.data(), buffer.data()) != Result::OKAY)
+	{
+		fail("failed to initialize", 0);
+		return;
+	}
+
+	// what the game sets up before starting the board: master or slave and the segment size
+	auto writeRAM16 = [&ram](unsigned addr, uint16_t data) { memcpy(&ram[addr], &data, sizeof(data)); };
+	const unsigned setup = typeTwo ? 0x200 : 0x400;
+	writeRAM16(setup + 0, index == 0 ? 0 : 1);
+	writeRAM16(setup + 2, 0x1000);
+	writeRAM16(setup + 4, SEGMENT_SIZE);
+	board->WriteIORegister(0xc0, 1);
+
+	// run frames until the link is up; type one games then report their own initialization as done
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMS);
+	for (unsigned frame = 0; board->GetState() != State::ready; frame++)
+	{
+		if (board->GetState() == State::error || std::chrono::steady_clock::now() > deadline)
+		{
+			fail("did not link up", frame);
+			return;
+		}
+
+		board->RunFrame();
+		if (!typeTwo && frame == 0)
+			board->WriteIORegister(0x88, 0xf000);
+		CThread::Sleep(1);
+	}
+	result->linked = true;
+
+	result->frameMicros.reserve(numFrames);
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned frame = 0; frame < numFrames; frame++)
+	{
+		// our segment: machine index, frame number, then a pattern to fill it out
+		// which, like game data, mostly stays the same from one frame to the next
+		board->WriteCommRAM8(0x100, uint8_t(index));
+		for (unsigned i = 0; i < 4; i++)
+			board->WriteCommRAM8(0x101 + i, uint8_t(frame >> (i * 8)));
+		for (unsigned i = 5; i < SEGMENT_SIZE; i++)
+			board->WriteCommRAM8(0x100 + i, uint8_t(i < CHANGING_SIZE ? frame + i : index + i));
+
+		// the main board owns the whole bank, so leave junk where the segments of
+		// the others go: the net board has to fill them in again in every exchange
+		for (unsigned i = 0; i < numMachines * SEGMENT_SIZE; i++)
+			board->WriteCommRAM8(0x100 + SEGMENT_SIZE + i, 0xa5);
+
+		auto frameStart = std::chrono::steady_clock::now();
+		board->RunFrame();
+		result->frameMicros.push_back(uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frameStart).count()));
+		result->framesRun++;
+
+		if (board->GetState() != State::ready)
+		{
+			result->seconds = Seconds(std::chrono::steady_clock::now() - start);
+			result->stats = board->GetLinkStats();
+			fail("lost the link", frame);
+			return;
+		}
+
+		// The segments read back are those of the exchange lookahead frames
+		// back, and each exchange sends the bank written the frame before it
+		// (the first exchange sends the bank no frame has written yet, still all
+		// zeros). Until the lookahead has been used up, the segments read back
+		// are those of the first exchange. In each exchange, segment s comes from
+		// s + 1 machines back round the ring.
+		unsigned exchange = frame + 1;
+		bool warmingUp = exchange < lookahead + 2;
+		uint32_t expectedFrame = warmingUp ? 0 : exchange - lookahead - 2;
+		for (unsigned s = 0; s < numMachines; s++)
+		{
+			unsigned segment = 0x100 + SEGMENT_SIZE * (s + 1);
+			unsigned sender = (index + numMachines - 1 - s) % numMachines;
+			uint32_t stamp = 0;
+			for (unsigned i = 0; i < 4; i++)
+				stamp |= uint32_t(board->ReadCommRAM8(segment + 1 + i)) << (i * 8);
+			bool ok;
+			if (warmingUp)
+				ok = board->ReadCommRAM8(segment) == 0 && stamp == 0 &&
+					board->ReadCommRAM8(segment + CHANGING_SIZE - 1) == 0 &&
+					board->ReadCommRAM8(segment + SEGMENT_SIZE - 1) == 0;
+			else
+				ok = board->ReadCommRAM8(segment) == sender && stamp == expectedFrame &&
+					board->ReadCommRAM8(segment + CHANGING_SIZE - 1) == uint8_t(expectedFrame + CHANGING_SIZE - 1) &&
+					board->ReadCommRAM8(segment + SEGMENT_SIZE - 1) == uint8_t(sender + SEGMENT_SIZE - 1);
+			result->segmentsChecked++;
+			if (!ok)
+				result->badSegments++;
+		}
+	}
+	result->seconds = Seconds(std::chrono::steady_clock::now() - start);
+	result->stats = board->GetLinkStats();
+
+	barrier->Arrive();
+}
+
+bool RunNetLinkHarness(const Util::Config::Node &config, const std::string &gameName, unsigned numMachines, unsigned numFrames)
+{
+	if (numMachines < 1 || numMachines > 8)
+	{
+		ErrorLog("Net link harness needs 1 to 8 machines.");
+		return false;
+	}
+
+	Game game;
+	game.name = gameName;
+	game.netboard_present = true;
+	bool typeTwo = gameName == "lemans24" || gameName == "von2" || gameName == "dirtdvls";
+
+	printf("Net link harness: %u machine(s) linked in memory as '%s', %u frames, lookahead %u\n",
+		numMachines, gameName.c_str(), numFrames, config["NetLookahead"].ValueAs<unsigned>());
+
+	std::vector<MachineResult> results(numMachines);
+	Barrier barrier(numMachines);
+	std::vector<std::thread> threads;
+	for (unsigned i = 0; i < numMachines; i++)
+		threads.emplace_back(RunMachine, std::cref(config), std::cref(game), typeTwo, i, numMachines, numFrames, &barrier, &results[i]);
+	for (auto& thread : threads)
+		thread.join();
+
+	bool ok = true;
+	std::vector<uint32_t> frameMicros;
+	unsigned segmentsChecked = 0;
+	unsigned badSegments = 0;
+	for (unsigned i = 0; i < numMachines; i++)
+	{
+		const MachineResult& result = results[i];
+		ok = ok && result.linked && result.framesRun == numFrames && result.badSegments == 0;
+		segmentsChecked += result.segmentsChecked;
+		badSegments += result.badSegments;
+		frameMicros.insert(frameMicros.end(), result.frameMicros.begin(), result.frameMicros.end());
+
+		double seconds = std::max(result.seconds, 1e-6);
+		printf("  Machine %u: %s, %u frames in %.3f s (%.1f frames/s), sent %.2f MB, received %.2f MB (%.2f MB/s), saved %.2f MB\n",
+			i, result.linked ? "linked" : "not linked", result.framesRun, result.seconds, result.framesRun / seconds,
+			result.stats.bytesSent / 1048576.0, result.stats.bytesReceived / 1048576.0,
+			(result.stats.bytesSent + result.stats.bytesReceived) / 1048576.0 / seconds, result.stats.bytesSaved / 1048576.0);
+	}
+
+	if (!frameMicros.empty())
+	{
+		std::sort(frameMicros.begin(), frameMicros.end());
+		auto percentile = [&frameMicros](double p) { return frameMicros[std::min(frameMicros.size() - 1, size_t(p / 100.0 * frameMicros.size()))]; };
+		printf("  Frame exchange time: p50 %u us, p99 %u us, max %u us\n", percentile(50.0), percentile(99.0), frameMicros.back());
+	}
+	printf("  Segments checked: %u, mismatched: %u\n", segmentsChecked, badSegments);
+	printf("%s\n", ok ? "PASSED" : "FAILED");
+
+	return ok;
+}
@@ -0,0 +1,56 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef INCLUDED_NETLINKHARNESS_H
+#define INCLUDED_NETLINKHARNESS_H
+
+#include <string>
+#include "Util/NewConfig.h"
+
+/*
+ * RunNetLinkHarness():
+ *
+ * Links numMachines simulated net boards in a ring inside this process, each
+ * on its own thread and connected through MemoryLink rather than sockets. In
+ * place of the game, each machine has a scripted main board that brings the
+ * link up as the given game would and then exchanges stamped segments for
+ * numFrames frames as fast as the link allows. Every received segment is
+ * checked for the right sender and frame, so a run is repeatable and makes a
+ * regression test of the ring protocol. Throughput and per-frame exchange
+ * times are printed to stdout.
+ *
+ * Only the net board is run: the CPU and sound cores hold global state, so
+ * complete machines can't be run side by side in one process.
+ *
+ * Parameters:
+ *    config       Settings to use (NetLookahead, NetTimeout, NetDelta and
+ *                 PortIn, which is the first of the in-process ports).
+ *    gameName     A linkable game, which decides the set-up protocol.
+ *    numMachines  Number of machines, 1 to 8.
+ *    numFrames    Frames to run once the link is up.
+ *
+ * Returns:
+ *    True if all machines linked up and every frame carried the expected
+ *    data.
+ */
+bool RunNetLinkHarness(const Util::Config::Node &config, const std::string &gameName, unsigned numMachines, unsigned numFrames);
+
+#endif
@@ -21,8 +21,13 @@
  **/
 
 #include <thread>
+#include <chrono>
+#include <algorithm>
 #include "Supermodel.h"
 #include "SimNetBoard.h"
+#include "TCPSend.h"
+#include "TCPReceive.h"
+#include "MemoryLink.h"
 #include <OSD/Thread.h>
 
  // these make 16-bit read/writes much neater
@@ -31,6 +36,64 @@
 
 static const uint64_t netGUID = 0x5bf177da34872;
 
+// Delta encoded segments start with their type. A delta is the XOR against the
+// segment sent in the same round of the previous frame, stored as runs: a
+// control byte below 0x80 is followed by that many plus one XOR bytes, 0x80 and
+// above stands for (n & 0x7f) + 1 unchanged bytes.
+static const uint8_t SEGMENT_KEYFRAME = 0;
+static const uint8_t SEGMENT_DELTA = 1;
+
+static void EncodeDelta(const uint8_t* data, const uint8_t* prev, size_t size, std::vector<uint8_t>& out)
+{
+	out.clear();
+	out.push_back(SEGMENT_DELTA);
+
+	size_t i = 0;
+	while (i < size)
+	{
+		bool same = data[i] == prev[i];
+		size_t run = 1;
+		while (i + run < size && run < 0x80 && (data[i + run] == prev[i + run]) == same)
+			run++;
+
+		if (same)
+			out.push_back(uint8_t(0x80 | (run - 1)));
+		else
+		{
+			out.push_back(uint8_t(run - 1));
+			for (size_t j = i; j < i + run; j++)
+				out.push_back(data[j] ^ prev[j]);
+		}
+		i += run;
+	}
+}
+
+// applies a delta to prev in place, false if it is malformed
+static bool DecodeDelta(const uint8_t* in, size_t inSize, uint8_t* prev, size_t size)
+{
+	size_t i = 0;
+	size_t pos = 1;		// skip type
+	while (pos < inSize)
+	{
+		uint8_t control = in[pos++];
+		size_t run = (control & 0x7f) + 1;
+		if (i + run > size)
+			return false;
+
+		if (!(control & 0x80))
+		{
+			if (pos + run > inSize)
+				return false;
+			for (size_t j = 0; j < run; j++)
+				prev[i + j] ^= in[pos + j];
+			pos += run;
+		}
+		i += run;
+	}
+
+	return i == size;
+}
+
 inline bool CSimNetBoard::IsGame(const char* gameName)
 {
 	return (m_gameInfo.name == gameName) || (m_gameInfo.parent == gameName);
@@ -44,6 +107,8 @@ CSimNetBoard::~CSimNetBoard(void)
 {
 	m_quit = true;
 
+	StopLink();
+
 	if (m_connectThread.joinable())
 		m_connectThread.join();
 }
@@ -85,9 +150,25 @@ Result CSimNetBoard::Init(uint8_t* netRAMPtr, uint8_t* netBufferPtr)
 	port_in = m_config["PortIn"].ValueAs<unsigned>();
 	port_out = m_config["PortOut"].ValueAs<unsigned>();
 	addr_out = m_config["AddressOut"].ValueAs<std::string>();
+	m_lookahead = m_config["NetLookahead"].ValueAsDefault<unsigned>(0);
+	m_timeoutMS = m_config["NetTimeout"].ValueAsDefault<unsigned>(5000);
+	m_delta = m_config["NetDelta"].ValueAsDefault<bool>(false);
+	m_keyframeInterval = std::max(m_config["NetDeltaKeyframe"].ValueAsDefault<unsigned>(60), 1u);
 
-	nets = std::make_unique<TCPSend>(addr_out, port_out);
-	netr = std::make_unique<TCPReceive>(port_in);
+	// machines that don't agree on the wire format fail the link check
+	m_linkGUID = m_delta ? (netGUID ^ 0xde17a) : netGUID;
+
+	// machines linked inside this process (see NetLinkHarness) talk through memory instead of sockets
+	if (m_config["NetTransport"].ValueAsDefault<std::string>("tcp") == "memory")
+	{
+		nets = std::make_unique<MemorySend>(port_out);
+		netr = std::make_unique<MemoryReceive>(port_in);
+	}
+	else
+	{
+		nets = std::make_unique<TCPSend>(addr_out, port_out);
+		netr = std::make_unique<TCPReceive>(port_in);
+	}
 
 	return Result::OKAY;
 }
@@ -152,22 +233,22 @@ void CSimNetBoard::RunFrame(void)
 				}
 
 				// check all linked instances have the same GUID
-				nets->Send(&netGUID, sizeof(netGUID));
+				nets->Send(&m_linkGUID, sizeof(m_linkGUID));
 				auto& recv_data = netr->Receive();
 				if (recv_data.empty())
 					break;
 				uint64_t testGUID;
 				memcpy(&testGUID, recv_data.data(), recv_data.size());
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 					testGUID = 0;
 
 				// send the GUID for one more loop
 				nets->Send(&testGUID, sizeof(testGUID));
 				netr->Receive();
 				
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 				{
-					ErrorLog("unable to verify connection. Make sure all machines are using same build!");
+					ErrorLog("unable to verify connection. Make sure all machines are using same build and net settings!");
 					m_state = State::error;
 					break;
 				}
@@ -194,7 +275,7 @@ void CSimNetBoard::RunFrame(void)
 					break;
 				uint64_t testGUID;
 				memcpy(&testGUID, recv_data.data(), recv_data.size());
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 					testGUID = 0;
 				nets->Send(&testGUID, sizeof(testGUID));
 
@@ -203,13 +284,13 @@ void CSimNetBoard::RunFrame(void)
 				if (recv_data.empty())
 					break;
 				memcpy(&testGUID, recv_data.data(), recv_data.size());
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 					testGUID = 0;
 				nets->Send(&testGUID, sizeof(testGUID));
 
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 				{
-					ErrorLog("unable to verify connection. Make sure all machines are using same build!");
+					ErrorLog("unable to verify connection. Make sure all machines are using same build and net settings!");
 					m_state = State::error;
 					break;
 				}
@@ -258,6 +339,7 @@ void CSimNetBoard::RunFrame(void)
 			CommRAM16[0xc] = FLIPENDIAN16(0x100);
 			CommRAM16[0xe] = FLIPENDIAN16(RAM16[0x402] - m_segmentSize + 0x200);
 
+			StartLink();
 			m_state = State::ready;
 		}
 		else
@@ -279,23 +361,23 @@ void CSimNetBoard::RunFrame(void)
 					netr->Receive();
 
 				// check all linked instances have the same GUID
-				nets->Send(&netGUID, sizeof(netGUID));
+				nets->Send(&m_linkGUID, sizeof(m_linkGUID));
 				auto& recv_data = netr->Receive();
 				if (recv_data.empty())
 					break;
 
 				uint64_t testGUID;
 				memcpy(&testGUID, recv_data.data(), recv_data.size());
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 					testGUID = 0;
 
 				// send the GUID for one more loop
 				nets->Send(&testGUID, sizeof(testGUID));
 				netr->Receive();
 
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 				{
-					ErrorLog("unable to verify connection. Make sure all machines are using same build!");
+					ErrorLog("unable to verify connection. Make sure all machines are using same build and net settings!");
 					m_state = State::error;
 					break;
 				}
@@ -322,7 +404,7 @@ void CSimNetBoard::RunFrame(void)
 					break;
 				uint64_t testGUID;
 				memcpy(&testGUID, recv_data.data(), recv_data.size());
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 					testGUID = 0;
 				nets->Send(&testGUID, sizeof(testGUID));
 
@@ -331,13 +413,13 @@ void CSimNetBoard::RunFrame(void)
 				if (recv_data.empty())
 					break;
 				memcpy(&testGUID, recv_data.data(), recv_data.size());
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 					testGUID = 0;
 				nets->Send(&testGUID, sizeof(testGUID));
 
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 				{
-					ErrorLog("unable to verify connection. Make sure all machines are using same build!");
+					ErrorLog("unable to verify connection. Make sure all machines are using same build and net settings!");
 					m_state = State::error;
 					break;
 				}
@@ -371,7 +453,7 @@ void CSimNetBoard::RunFrame(void)
 					break;
 				uint64_t testGUID;
 				memcpy(&testGUID, recv_data.data(), recv_data.size());
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 					testGUID = 0;
 				nets->Send(&testGUID, sizeof(testGUID));
 
@@ -380,13 +462,13 @@ void CSimNetBoard::RunFrame(void)
 				if (recv_data.empty())
 					break;
 				memcpy(&testGUID, recv_data.data(), recv_data.size());
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 					testGUID = 0;
 				nets->Send(&testGUID, sizeof(testGUID));
 
-				if (testGUID != netGUID)
+				if (testGUID != m_linkGUID)
 				{
-					ErrorLog("unable to verify connection. Make sure all machines are using same build!");
+					ErrorLog("unable to verify connection. Make sure all machines are using same build and net settings!");
 					m_state = State::error;
 					break;
 				}
@@ -449,6 +531,7 @@ void CSimNetBoard::RunFrame(void)
 			CommRAM16[0xc] = FLIPENDIAN16(0x100);
 			CommRAM16[0xe] = FLIPENDIAN16(RAM16[0x206] + 0x80);
 
+			StartLink();
 			m_state = State::ready;
 		}
 		break;
@@ -457,22 +540,11 @@ void CSimNetBoard::RunFrame(void)
 		m_counter++;
 		CommRAM16[0x6] = FLIPENDIAN16(m_counter);
 		
-		// we only send what we need to; helps cut down on bandwidth
-		// each machine has to receive back its own data (TODO: copy this data manually?)
-		for (int i = 0; i < m_numMachines; i++)
+		if (!ExchangeSegments())
 		{
-			nets->Send(CommRAM + 0x100 + i * m_segmentSize, m_segmentSize);
-			auto& recv_data = netr->Receive();
-			if (recv_data.empty())
-			{
-				// link broken - send an "empty" packet to alert other machines
-				nets->Send(nullptr, 0);
-				m_state = State::error;
-				if (m_gameType == GameType::one)
-					m_status1 = 0x40;			// send "link broken" message to mainboard
-				break;
-			}
-			memcpy(CommRAM + 0x100 + (i + 1) * m_segmentSize, recv_data.data(), recv_data.size());
+			m_state = State::error;
+			if (m_gameType == GameType::one)
+				m_status1 = 0x40;			// send "link broken" message to mainboard
 		}
 
 		// swap CommRAM banks
@@ -502,6 +574,7 @@ void CSimNetBoard::Reset(void)
 	// if netboard was active, send an "empty" packet so the other machines don't get stuck waiting for data
 	if (m_state == State::ready)
 	{
+		StopLink();
 		nets->Send(nullptr, 0);
 		netr->Receive();
 	}
@@ -520,11 +593,34 @@ bool CSimNetBoard::IsRunning(void)
 	return m_attached && m_running;
 }
 
+State CSimNetBoard::GetState(void) const
+{
+	return m_state;
+}
+
 void CSimNetBoard::GetGame(const Game& gameInfo)
 {
 	m_gameInfo = gameInfo;
 }
 
+NetLinkStats CSimNetBoard::GetLinkStats(void)
+{
+	NetLinkStats stats;
+	if (nets)
+	{
+		stats.bytesSent = nets->BytesSent();
+		stats.messagesSent = nets->MessagesSent();
+	}
+	if (netr)
+	{
+		stats.bytesReceived = netr->BytesReceived();
+		stats.messagesReceived = netr->MessagesReceived();
+	}
+	stats.bytesSaved = uint64_t(std::max<int64_t>(m_bytesSaved, 0));
+	stats.latencyMicros = m_roundTripMicros;
+	return stats;
+}
+
 void CSimNetBoard::ConnectProc(void)
 {
 	if (m_connected)
@@ -552,6 +648,205 @@ void CSimNetBoard::ConnectProc(void)
 	m_connected = true;
 }
 
+void CSimNetBoard::StartLink(void)
+{
+	StopLink();
+
+	m_sendQueue.clear();
+	m_receiveQueue.clear();
+	m_frameInUse.clear();
+	m_framesQueued = 0;
+	m_framesUsed = 0;
+	m_linkStop = false;
+	m_linkBroken = false;
+
+	// both ends of each hop start from all zeros
+	m_lastSent.assign(m_numMachines, std::vector<uint8_t>(m_segmentSize));
+	m_lastReceived.assign(m_numMachines, std::vector<uint8_t>(m_segmentSize));
+	m_encodeBuffer.reserve(2 * m_segmentSize + 1);		// worst case delta, alternating changed and unchanged bytes
+
+	m_linkThread = std::thread(&CSimNetBoard::LinkProc, this);
+}
+
+void CSimNetBoard::StopLink(void)
+{
+	if (!m_linkThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_linkMutex);
+		m_linkStop = true;
+	}
+	m_linkCond.notify_all();
+	m_linkThread.join();
+}
+
+// Runs the ring protocol: each frame, our segment is sent to the next machine,
+// then each segment received from the previous machine is passed straight on,
+// until our own comes back. Segments are forwarded as soon as they arrive
+// rather than when the emulator gets around to its next frame, so the whole
+// exchange overlaps with emulation.
+void CSimNetBoard::LinkProc(void)
+{
+	const size_t segmentSize = m_segmentSize;
+
+	for (uint32_t frame = 0; ; frame++)
+	{
+		std::vector<uint8_t> segment;
+		{
+			std::unique_lock<std::mutex> lock(m_linkMutex);
+			m_linkCond.wait(lock, [this] { return m_linkStop || !m_sendQueue.empty(); });
+			if (m_linkStop)
+				return;
+			segment = std::move(m_sendQueue.front());
+			m_sendQueue.pop_front();
+		}
+
+		// we only send what we need to; helps cut down on bandwidth
+		// each machine has to receive back its own data (TODO: copy this data manually?)
+		std::vector<uint8_t> received(m_numMachines * segmentSize);
+		const uint8_t* send = segment.data();
+		bool broken = false;
+		auto start = std::chrono::steady_clock::now();
+		bool keyframe = frame % m_keyframeInterval == 0;
+		for (int i = 0; i < m_numMachines && !broken; i++)
+		{
+			SendSegment(i, send, keyframe);
+
+			// wait for the previous machine, giving up if asked to stop
+			while (!netr->CheckDataAvailable(10))
+			{
+				if (m_linkStop)
+					return;
+				if (!netr->Connected())
+					break;
+			}
+
+			if (!ReceiveSegment(i, received.data() + i * segmentSize))
+			{
+				broken = true;
+				break;
+			}
+			send = received.data() + i * segmentSize;
+		}
+
+		if (broken)
+		{
+			// link broken - send an "empty" packet to alert other machines
+			nets->Send(nullptr, 0);
+			std::lock_guard<std::mutex> lock(m_linkMutex);
+			m_linkBroken = true;
+			m_linkCond.notify_all();
+			return;
+		}
+
+		m_roundTripMicros = uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+		{
+			std::lock_guard<std::mutex> lock(m_linkMutex);
+			m_receiveQueue.push_back(std::move(received));
+		}
+		m_linkCond.notify_all();
+	}
+}
+
+void CSimNetBoard::SendSegment(unsigned round, const uint8_t* segment, bool keyframe)
+{
+	if (!m_delta)
+	{
+		nets->Send(segment, m_segmentSize);
+		return;
+	}
+
+	std::vector<uint8_t>& last = m_lastSent[round];
+	if (!keyframe)
+		EncodeDelta(segment, last.data(), m_segmentSize, m_encodeBuffer);
+
+	// a delta can come out larger than the segment when most of it changes
+	if (keyframe || m_encodeBuffer.size() > m_segmentSize)
+	{
+		m_encodeBuffer.assign(1, SEGMENT_KEYFRAME);
+		m_encodeBuffer.insert(m_encodeBuffer.end(), segment, segment + m_segmentSize);
+	}
+
+	// net of the type byte, which makes a keyframe cost a byte more than a plain segment
+	m_bytesSaved += int64_t(m_segmentSize) - int64_t(m_encodeBuffer.size());
+
+	nets->Send(m_encodeBuffer.data(), int(m_encodeBuffer.size()));
+	memcpy(last.data(), segment, m_segmentSize);
+}
+
+// false if the link is broken or the data is malformed
+bool CSimNetBoard::ReceiveSegment(unsigned round, uint8_t* segment)
+{
+	auto& recv_data = netr->Receive();
+	if (recv_data.empty())
+		return false;
+
+	if (!m_delta)
+	{
+		memcpy(segment, recv_data.data(), std::min<size_t>(recv_data.size(), m_segmentSize));
+		return true;
+	}
+
+	std::vector<uint8_t>& last = m_lastReceived[round];
+	const uint8_t* data = (const uint8_t*)recv_data.data();
+	if (data[0] == SEGMENT_KEYFRAME)
+		memcpy(last.data(), data + 1, std::min<size_t>(recv_data.size() - 1, m_segmentSize));
+	else if (data[0] != SEGMENT_DELTA || !DecodeDelta(data, recv_data.size(), last.data(), m_segmentSize))
+	{
+		ErrorLog("net board received a malformed segment.");
+		return false;
+	}
+
+	memcpy(segment, last.data(), m_segmentSize);
+	return true;
+}
+
+// Queues this frame's segment and copies in the segments received for the frame
+// m_lookahead frames back (the first frame until then), waiting for that frame
+// only if it hasn't been received yet. Both CommRAM banks are filled in this
+// way, so the same frame is copied in again until a newer one is due. Returns
+// false if the link is broken or the frame doesn't arrive in time.
+bool CSimNetBoard::ExchangeSegments(void)
+{
+	std::unique_lock<std::mutex> lock(m_linkMutex);
+
+	m_sendQueue.emplace_back(CommRAM + 0x100, CommRAM + 0x100 + m_segmentSize);
+	m_framesQueued++;
+	m_linkCond.notify_all();
+
+	// the first frame is always waited for so that there is data to work with
+	uint32_t framesNeeded = std::max<uint32_t>(m_framesQueued > m_lookahead ? m_framesQueued - m_lookahead : 0, 1);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_timeoutMS);
+	bool arrived = m_linkCond.wait_until(lock, deadline, [this, framesNeeded]
+	{
+		return m_linkBroken || m_framesUsed + m_receiveQueue.size() >= framesNeeded;
+	});
+
+	if (m_linkBroken)
+		return false;
+	if (!arrived)
+	{
+		ErrorLog("net board link timed out waiting for data from the other machines.");
+		lock.unlock();
+		StopLink();
+		nets->Send(nullptr, 0);
+		return false;
+	}
+
+	// skip any frames older than the one needed
+	while (m_framesUsed < framesNeeded)
+	{
+		m_frameInUse.swap(m_receiveQueue.front());
+		m_receiveQueue.pop_front();
+		m_framesUsed++;
+	}
+
+	memcpy(CommRAM + 0x100 + m_segmentSize, m_frameInUse.data(), m_frameInUse.size());
+	return true;
+}
+
 uint8_t CSimNetBoard::ReadCommRAM8(unsigned addr)
 {
 	return externalCommRAM[addr];
@@ -24,8 +24,13 @@
 #define INCLUDED_SIMNETBOARD_H
 
 #include <cstdint>
-#include "TCPSend.h"
-#include "TCPReceive.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "INetTransport.h"
 #include "INetBoard.h"
 
 enum class State
@@ -59,9 +64,12 @@ public:
 
 	bool IsAttached(void);
 	bool IsRunning(void);
+	State GetState(void) const;
 
 	void GetGame(const Game& gameInfo);
 
+	NetLinkStats GetLinkStats(void);
+
 	uint8_t ReadCommRAM8(unsigned addr);
 	uint16_t ReadCommRAM16(unsigned addr);
 	uint32_t ReadCommRAM32(unsigned addr);
@@ -90,8 +98,32 @@ private:
 	std::atomic_bool m_quit = false;
 	std::atomic_bool m_connected = false;
 
-	std::unique_ptr<TCPSend> nets = nullptr;
-	std::unique_ptr<TCPReceive> netr = nullptr;
+	std::unique_ptr<INetSend> nets = nullptr;
+	std::unique_ptr<INetReceive> netr = nullptr;
+
+	// segment exchange, pipelined on its own thread once the link is up
+	std::thread m_linkThread;
+	std::mutex m_linkMutex;
+	std::condition_variable m_linkCond;
+	std::deque<std::vector<uint8_t>> m_sendQueue;		// our segment for each frame not yet sent
+	std::deque<std::vector<uint8_t>> m_receiveQueue;	// received segments of each frame not yet used
+	std::vector<uint8_t> m_frameInUse;					// received segments of the frame last used
+	uint32_t m_framesQueued = 0;
+	uint32_t m_framesUsed = 0;
+	std::atomic_bool m_linkStop = false;
+	bool m_linkBroken = false;
+	unsigned m_lookahead = 0;		// frames the received data may lag behind
+	unsigned m_timeoutMS = 0;
+	std::atomic<uint32_t> m_roundTripMicros = 0;	// last time for our segment to go round the ring
+
+	// optional delta encoding of segments against those sent in the same round of the previous frame
+	bool m_delta = false;
+	unsigned m_keyframeInterval = 0;				// frames between full segments
+	uint64_t m_linkGUID = 0;						// checked at link up, differs if the wire format does
+	std::vector<std::vector<uint8_t>> m_lastSent;	// per round, only used by the link thread
+	std::vector<std::vector<uint8_t>> m_lastReceived;
+	std::vector<uint8_t> m_encodeBuffer;
+	std::atomic<int64_t> m_bytesSaved = 0;			// negative while keyframes outweigh the deltas
 
 	Game m_gameInfo;
 	GameType m_gameType = GameType::unknown;
@@ -112,6 +144,12 @@ private:
 
 	inline bool IsGame(const char* gameName);
 	void ConnectProc(void);
+	void StartLink(void);
+	void StopLink(void);
+	void LinkProc(void);
+	bool ExchangeSegments(void);
+	void SendSegment(unsigned round, const uint8_t* segment, bool keyframe);
+	bool ReceiveSegment(unsigned round, uint8_t* segment);
 };
 
 #endif
\ No newline at end of file
@@ -23,6 +23,8 @@
 #include "TCPReceive.h"
 #include "OSD/Logger.h"
 #include "OSD/Thread.h"
+#include <chrono>
+#include <cstring>
 
 #if defined(_DEBUG)
 #include <cstdio>
@@ -34,10 +36,19 @@
 TCPReceive::TCPReceive(int port) :
 	m_listenSocket(nullptr),
 	m_receiveSocket(nullptr),
-	m_socketSet(nullptr)
+	m_socketSet(nullptr),
+	m_readPos(0),
+	m_writePos(0),
+	m_bytesReceived(0),
+	m_messagesReceived(0),
+	m_lastWaitMicros(0)
 {
 	SDLNet_Init();
 
+	// buffers cover the largest comm ram segment up front, they only grow if ever needed
+	m_inBuffer.resize(0x10000);
+	m_recBuffer.reserve(0x10000);
+
 	m_socketSet = SDLNet_AllocSocketSet(1);
 
 	IPaddress ip;
@@ -84,6 +95,11 @@ bool TCPReceive::CheckDataAvailable(int timeoutMS)
 		return false;
 	}
 
+	// anything already read in counts, the rest of the message is on its way
+	if (m_writePos > m_readPos) {
+		return true;
+	}
+
 	return SDLNet_CheckSockets(m_socketSet, timeoutMS) > 0;
 }
 
@@ -95,31 +111,77 @@ std::vector<char>& TCPReceive::Receive()
 		return m_recBuffer;
 	}
 
+	auto start = std::chrono::steady_clock::now();
+
 	int size = 0;
-	int result = SDLNet_TCP_Recv(m_receiveSocket, &size, sizeof(int));
-	DPRINTF("Received %i bytes\n", result);
-	if (result <= 0) {
-		SDLNet_TCP_Close(m_receiveSocket);
-		m_receiveSocket = nullptr;
+	if (Fill(sizeof(int))) {
+		memcpy(&size, m_inBuffer.data() + m_readPos, sizeof(int));
+	}
+
+	// nothing we exchange comes close to a megabyte, anything larger is a corrupt stream
+	if (size < 0 || size > 0x100000 || !Fill(sizeof(int) + size_t(size))) {
+		Disconnect();
+		m_recBuffer.clear();
+		return m_recBuffer;
+	}
+
+	// within the reserved capacity this is just a copy
+	const char* payload = m_inBuffer.data() + m_readPos + sizeof(int);
+	m_recBuffer.assign(payload, payload + size);
+
+	m_readPos += sizeof(int) + size_t(size);
+	if (m_readPos == m_writePos) {
+		m_readPos = m_writePos = 0;
+	}
+
+	m_bytesReceived += sizeof(int) + size_t(size);
+	m_messagesReceived++;
+	m_lastWaitMicros = uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+	return m_recBuffer;
+}
+
+bool TCPReceive::Fill(size_t bytes)
+{
+	if (!m_receiveSocket) {
+		return false;
 	}
 
-	// reserve our space
-	m_recBuffer.resize(size);
+	// not enough room left at the end, move what we have to the front first
+	if (m_readPos + bytes > m_inBuffer.size()) {
+		memmove(m_inBuffer.data(), m_inBuffer.data() + m_readPos, m_writePos - m_readPos);
+		m_writePos -= m_readPos;
+		m_readPos = 0;
 
-	while (size) {
+		if (bytes > m_inBuffer.size()) {
+			m_inBuffer.resize(bytes);
+		}
+	}
 
-		result = SDLNet_TCP_Recv(m_receiveSocket, m_recBuffer.data() + (m_recBuffer.size() - size), size);
+	while (m_writePos - m_readPos < bytes) {
+
+		// take whatever has arrived, which may include the start of following messages
+		int result = SDLNet_TCP_Recv(m_receiveSocket, m_inBuffer.data() + m_writePos, int(m_inBuffer.size() - m_writePos));
 		DPRINTF("Received %i bytes\n", result);
 		if (result <= 0) {
-			SDLNet_TCP_Close(m_receiveSocket);
-			m_receiveSocket = nullptr;
-			break;
+			return false;
 		}
 
-		size -= result;
+		m_writePos += result;
 	}
 
-	return m_recBuffer;
+	return true;
+}
+
+void TCPReceive::Disconnect()
+{
+	if (m_receiveSocket) {
+		SDLNet_DelSocket(m_socketSet, (SDLNet_GenericSocket)m_receiveSocket.load());
+		SDLNet_TCP_Close(m_receiveSocket);
+		m_receiveSocket = nullptr;
+	}
+
+	m_readPos = m_writePos = 0;
 }
 
 void TCPReceive::ListenFunc()
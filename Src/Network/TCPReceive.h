@@ -26,9 +26,11 @@
 #include <thread>
 #include <atomic>
 #include <vector>
+#include <cstdint>
 #include "SDLIncludes.h"
+#include "INetTransport.h"
 
-class TCPReceive
+class TCPReceive : public INetReceive
 {
 public:
 	TCPReceive(int port);
@@ -38,9 +40,15 @@ public:
 	std::vector<char>& Receive();
 	bool Connected();
 
+	uint64_t BytesReceived() const		{ return m_bytesReceived; }
+	uint64_t MessagesReceived() const	{ return m_messagesReceived; }
+	uint32_t LastWaitMicros() const		{ return m_lastWaitMicros; }
+
 private:
 
 	void ListenFunc();
+	bool Fill(size_t bytes);
+	void Disconnect();
 
 	TCPsocket m_listenSocket;
 	std::atomic<TCPsocket> m_receiveSocket;
@@ -48,6 +56,15 @@ private:
 	std::thread m_listenThread;
 	std::atomic_bool m_running;
 	std::vector<char> m_recBuffer;
+
+	// raw stream, read in as large chunks as are available and split into messages from here
+	std::vector<char> m_inBuffer;
+	size_t m_readPos;
+	size_t m_writePos;
+
+	std::atomic<uint64_t> m_bytesReceived;
+	std::atomic<uint64_t> m_messagesReceived;
+	std::atomic<uint32_t> m_lastWaitMicros;
 };
 
 #endif
\ No newline at end of file
@@ -22,6 +22,7 @@
 
 #include "TCPSend.h"
 #include "OSD/Logger.h"
+#include <cstring>
 
 #if defined(_DEBUG)
 #include <stdio.h>
@@ -33,9 +34,13 @@
 TCPSend::TCPSend(std::string& ip, int port) :
 	m_ip(ip),
 	m_port(port),
-	m_socket(nullptr)
+	m_socket(nullptr),
+	m_bytesSent(0),
+	m_messagesSent(0)
 {
 	SDLNet_Init();
+
+	m_sendBuffer.resize(0x10000);		// covers the largest comm ram segment, grows if ever needed
 }
 
 TCPSend::~TCPSend()
@@ -58,18 +63,29 @@ bool TCPSend::Send(const void * data, int length)
 
 	DPRINTF("Sending %i bytes\n", length);
 
-	int sent = SDLNet_TCP_Send(m_socket, &length, sizeof(int));		// pack the length at the start of transmission.
+	// pack the length at the start of transmission. Header and payload go out in a single send, otherwise
+	// the header leaves as a tiny segment of its own (sdl_net already sets TCP_NODELAY on the socket)
+	int total = int(sizeof(int)) + length;
+	if (size_t(total) > m_sendBuffer.size()) {
+		m_sendBuffer.resize(total);
+	}
 
-	if (!length)
-		return true;		// 0 sized packet will blow our connex
+	memcpy(m_sendBuffer.data(), &length, sizeof(int));
+	if (length) {
+		memcpy(m_sendBuffer.data() + sizeof(int), data, length);
+	}
 
-	sent = SDLNet_TCP_Send(m_socket, data, length);
+	int sent = SDLNet_TCP_Send(m_socket, m_sendBuffer.data(), total);
 
-	if (sent < length) {
+	if (sent < total) {
 		SDLNet_TCP_Close(m_socket);
 		m_socket = nullptr;
+		return true;
 	}
 
+	m_bytesSent += total;
+	m_messagesSent++;
+
 	return true;
 }
 
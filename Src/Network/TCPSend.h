@@ -24,9 +24,13 @@
 #define _TCPSEND_H_
 
 #include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
 #include "SDLIncludes.h"
+#include "INetTransport.h"
 
-class TCPSend
+class TCPSend : public INetSend
 {
 public:
 	TCPSend(std::string& ip, int port);
@@ -35,12 +39,19 @@ public:
 	bool Send(const void* data, int length);
 	bool Connect();
 	bool Connected();
+
+	uint64_t BytesSent() const		{ return m_bytesSent; }
+	uint64_t MessagesSent() const	{ return m_messagesSent; }
+
 private:
 
 	std::string	m_ip;
 	int			m_port;
 	TCPsocket	m_socket;		// sdl socket
 
+	std::vector<char> m_sendBuffer;		// length prefix + payload, so each message goes out in one send
+	std::atomic<uint64_t> m_bytesSent;
+	std::atomic<uint64_t> m_messagesSent;
 };
 
 #endif
@@ -53,6 +53,13 @@ extern Result OpenAudio(const Util::Config::Node& config);
  */
 extern bool OutputAudio(unsigned numSamples, const float* leftFrontBuffer, const float* rightFrontBuffer, const float* leftRearBuffer, const float* rightRearBuffer, bool flipStereo);
 
+/*
+ * GetAudioUnderRuns()
+ *
+ * Returns the number of audio buffer under-runs since audio was opened.
+ */
+extern unsigned GetAudioUnderRuns();
+
 /*
  * CloseAudio()
  *
@@ -66,6 +66,9 @@
     "; Graphics\n"
     "New3DEngine = true\n"
     "QuadRendering = false\n"
+    "IndirectDraw = true\n"
+    "ModelCache = false\n"
+    "ShaderCache = true\n"
     "WideScreen = false\n"
     "Stretch = false\n"
     "WideBackground = false\n"
@@ -86,12 +89,29 @@
     "; one (e.g., Fighting Vipers 2)\n"
     "LegacySoundDSP = false\n"
     "\n"
+    "; Poll game inputs when the game reads them rather than at the start of each\n"
+    "; frame, updating controllers meanwhile this many times a second (up to\n"
+    "; 1000; 0 polls everything once per frame)\n"
+    "InputPollRate = 0\n"
+    "\n"
     "; Network board\n"
     "Network = false\n"
     "SimulateNet = true\n"
     "PortIn = 1970\n"
     "PortOut = 1971\n"
     "AddressOut = \"127.0.0.1\"\n"
+    "; Frames the link data of the simulated net board may lag behind so that it\n"
+    "; can be exchanged while emulation runs, and milliseconds to wait for it\n"
+    "; before the link is considered broken. 0 waits for every frame's data, as\n"
+    "; the real link does. Games see other cabinets' data that many frames late\n"
+    "; with 1 or more, which is experimental\n"
+    "NetLookahead = 0\n"
+    "NetTimeout = 5000\n"
+    "; Send only what changed in each segment of link data since the previous\n"
+    "; frame, with the full data every NetDeltaKeyframe frames. All linked\n"
+    "; machines must use the same setting\n"
+    "NetDelta = false\n"
+    "NetDeltaKeyframe = 60\n"
     "\n"
     "; Common\n"
     "InputStart1 = \"KEY_1,JOY1_BUTTON9\"\n"
@@ -20,6 +20,8 @@
  **/
 
 #include "OSD/Logger.h"
+#include <algorithm>
+#include <chrono>
 #include <set>
 #ifdef _WIN32
 #include <windows.h>
@@ -31,6 +33,9 @@
 // Logger object is used to redirect log messages appropriately
 static std::shared_ptr<CLogger> s_Logger;
 
+// Its level, so that disabled messages are discarded without a call
+static CLogger::LogLevel s_logLevel = CLogger::LogLevel::All;
+
 
 std::shared_ptr<CLogger> GetLogger()
 {
@@ -40,11 +45,12 @@ std::shared_ptr<CLogger> GetLogger()
 void SetLogger(std::shared_ptr<CLogger> logger)
 {
   s_Logger = logger;
+  s_logLevel = logger ? logger->GetLogLevel() : CLogger::LogLevel::All;
 }
 
 void DebugLog(const char *fmt, ...)
 {
-  if (!s_Logger)
+  if (!s_Logger || s_logLevel > CLogger::LogLevel::Debug)
     return;
   va_list vl;
   va_start(vl, fmt);
@@ -54,7 +60,7 @@ void DebugLog(const char *fmt, ...)
 
 void InfoLog(const char *fmt, ...)
 {
-  if (!s_Logger)
+  if (!s_Logger || s_logLevel > CLogger::LogLevel::Info)
     return;
   va_list vl;
   va_start(vl, fmt);
@@ -156,7 +162,14 @@ std::shared_ptr<CLogger> CreateLogger(const Util::Config::Node &config)
     loggers.push_back(std::make_shared<CSystemLogger>(logLevel));
   }
 
-  return std::make_shared<CMultiLogger>(loggers);
+  // Debug logging comes from emulation code and must not slow it down, so it
+  // is formatted and written on a separate thread
+  auto multiLogger = std::make_shared<CMultiLogger>(loggers);
+  if (logLevel <= CLogger::LogLevel::Debug && config["LogAsync"].ValueAsDefault<bool>(true))
+  {
+    return std::make_shared<CAsyncLogger>(multiLogger);
+  }
+  return multiLogger;
 }
 
 /*
@@ -196,6 +209,16 @@ void CMultiLogger::ErrorLog(const char *fmt, va_list vl)
   }
 }
 
+CLogger::LogLevel CMultiLogger::GetLogLevel() const
+{
+  LogLevel level = LogLevel::Error;
+  for (auto &logger: m_loggers)
+  {
+    level = (std::min)(level, logger->GetLogLevel());
+  }
+  return level;
+}
+
 CMultiLogger::CMultiLogger(std::vector<std::shared_ptr<CLogger>> loggers)
   : m_loggers(loggers)
 {
@@ -224,6 +247,11 @@ void CConsoleErrorLogger::ErrorLog(const char *fmt, va_list vl)
   fprintf(stderr, "Error: %s\n", string);
 }
 
+CLogger::LogLevel CConsoleErrorLogger::GetLogLevel() const
+{
+  return LogLevel::Error;
+}
+
 /*
  * CFileLogger
  */
@@ -284,6 +312,11 @@ void CFileLogger::ErrorLog(const char *fmt, va_list vl)
   ReopenFiles(std::ios::app);
 }
 
+CLogger::LogLevel CFileLogger::GetLogLevel() const
+{
+  return m_logLevel;
+}
+
 void CFileLogger::ReopenFiles(std::ios_base::openmode mode)
 {
   // Close existing
@@ -400,3 +433,548 @@ CSystemLogger::CSystemLogger(CLogger::LogLevel level)
   : m_logLevel(level)
 {
 }
+
+CLogger::LogLevel CSystemLogger::GetLogLevel() const
+{
+  return m_logLevel;
+}
+
+/*
+ * CAsyncLogger
+ *
+ * Records in the ring buffers are a RecordHeader followed by the arguments in
+ * 8-byte slots. Strings are copied (up to MAX_STRING_LENGTH bytes) as a length
+ * slot followed by the characters, padded to a multiple of 8. Neither the
+ * record layout nor the argument types are stored: the background thread
+ * parses the format string again to find them.
+ *
+ * Positions in the buffer only ever increase and are wrapped when used. A
+ * record never wraps around the end of the buffer; the space left over is
+ * skipped with a padding record (or without one, when too small to hold its
+ * header).
+ */
+
+static const size_t ASYNC_LOG_BUFFER_SIZE = 256 * 1024;  // per thread, power of 2
+static const size_t MAX_STRING_LENGTH = 4095;
+static const size_t MAX_FORMAT_SPEC_LENGTH = 32;
+static const uint32_t PADDING_RECORD = 0xffffffff;
+
+struct RecordHeader
+{
+  uint32_t size;    // entire record, multiple of 8
+  uint32_t level;   // CLogger::LogLevel or PADDING_RECORD
+  uint64_t seq;
+  const char *fmt;
+  uint64_t reserved;
+};
+
+static_assert(sizeof(RecordHeader) % 8 == 0, "records must stay 8 byte aligned");
+
+enum class ArgType
+{
+  None,         // %%
+  Int,
+  Long,
+  LongLong,
+  SizeT,
+  IntMax,
+  PtrDiff,
+  Double,
+  LongDouble,
+  Pointer,
+  String,
+  Unsupported
+};
+
+// Parses the conversion starting at p (which points to '%') and returns a
+// pointer just past it. Width and precision given as '*' each take an int
+// argument ahead of the value.
+static const char *ParseFormatSpec(const char *p, int *numStars, ArgType *type)
+{
+  const char *start = p++;
+  *numStars = 0;
+  if (*p == '%')
+  {
+    *type = ArgType::None;
+    return p + 1;
+  }
+
+  while (*p && strchr("-+ #0", *p))
+    p++;
+  if (*p == '*')
+  {
+    *numStars += 1;
+    p++;
+  }
+  while (*p >= '0' && *p <= '9')
+    p++;
+  if (*p == '.')
+  {
+    p++;
+    if (*p == '*')
+    {
+      *numStars += 1;
+      p++;
+    }
+    while (*p >= '0' && *p <= '9')
+      p++;
+  }
+
+  enum { NoModifier, hh, h, l, ll, z, j, t, L } modifier = NoModifier;
+  switch (*p)
+  {
+  case 'h': modifier = p[1] == 'h' ? hh : h; p += p[1] == 'h' ? 2 : 1; break;
+  case 'l': modifier = p[1] == 'l' ? ll : l; p += p[1] == 'l' ? 2 : 1; break;
+  case 'z': modifier = z; p++; break;
+  case 'j': modifier = j; p++; break;
+  case 't': modifier = t; p++; break;
+  case 'L': modifier = L; p++; break;
+  default:  break;
+  }
+
+  *type = ArgType::Unsupported;
+  char conversion = *p;
+  if (conversion == '\0')
+    return p;
+  p++;
+  switch (conversion)
+  {
+  case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+    switch (modifier)
+    {
+    case NoModifier:
+    case hh:
+    case h:   *type = ArgType::Int; break;
+    case l:   *type = ArgType::Long; break;
+    case ll:  *type = ArgType::LongLong; break;
+    case z:   *type = ArgType::SizeT; break;
+    case j:   *type = ArgType::IntMax; break;
+    case t:   *type = ArgType::PtrDiff; break;
+    default:  break;
+    }
+    break;
+  case 'c':
+    if (modifier == NoModifier)
+      *type = ArgType::Int;
+    break;
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+    if (modifier == NoModifier || modifier == l)
+      *type = ArgType::Double;
+    else if (modifier == L)
+      *type = ArgType::LongDouble;
+    break;
+  case 'p':
+    *type = ArgType::Pointer;
+    break;
+  case 's':
+    if (modifier == NoModifier)
+      *type = ArgType::String;
+    break;
+  default:
+    break;
+  }
+  if (size_t(p - start) >= MAX_FORMAT_SPEC_LENGTH)
+    *type = ArgType::Unsupported;
+  return p;
+}
+
+static void PutSlot(std::vector<uint8_t> *record, uint64_t value)
+{
+  size_t offset = record->size();
+  record->resize(offset + sizeof(value));
+  memcpy(record->data() + offset, &value, sizeof(value));
+}
+
+static void PutDouble(std::vector<uint8_t> *record, double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  PutSlot(record, bits);
+}
+
+static void PutString(std::vector<uint8_t> *record, const char *str)
+{
+  if (!str)
+    str = "(null)";
+  size_t length = strnlen(str, MAX_STRING_LENGTH);
+  PutSlot(record, length);
+  size_t offset = record->size();
+  record->resize(offset + ((length + 7) & ~size_t(7)));
+  memcpy(record->data() + offset, str, length);
+}
+
+// Copies the arguments of a message after the record header. Returns false if
+// the format can't be reproduced later.
+static bool EncodeArgs(std::vector<uint8_t> *record, const char *fmt, va_list vl)
+{
+  for (const char *p = fmt; *p; )
+  {
+    if (*p != '%')
+    {
+      p++;
+      continue;
+    }
+    int numStars;
+    ArgType type;
+    p = ParseFormatSpec(p, &numStars, &type);
+    if (type == ArgType::Unsupported)
+      return false;
+    for (int i = 0; i < numStars; i++)
+      PutSlot(record, uint64_t(int64_t(va_arg(vl, int))));
+    switch (type)
+    {
+    case ArgType::Int:        PutSlot(record, uint64_t(int64_t(va_arg(vl, int)))); break;
+    case ArgType::Long:       PutSlot(record, uint64_t(int64_t(va_arg(vl, long)))); break;
+    case ArgType::LongLong:   PutSlot(record, uint64_t(va_arg(vl, long long))); break;
+    case ArgType::SizeT:      PutSlot(record, uint64_t(va_arg(vl, size_t))); break;
+    case ArgType::IntMax:     PutSlot(record, uint64_t(va_arg(vl, intmax_t))); break;
+    case ArgType::PtrDiff:    PutSlot(record, uint64_t(int64_t(va_arg(vl, ptrdiff_t)))); break;
+    case ArgType::Double:     PutDouble(record, va_arg(vl, double)); break;
+    case ArgType::LongDouble: PutDouble(record, double(va_arg(vl, long double))); break;
+    case ArgType::Pointer:    PutSlot(record, uint64_t(uintptr_t(va_arg(vl, void *)))); break;
+    case ArgType::String:     PutString(record, va_arg(vl, const char *)); break;
+    default:                  break;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+static void FormatArg(std::string *out, const char *spec, const int *stars, int numStars, T value)
+{
+  char buf[4096];
+  int n;
+  if (numStars == 0)
+    n = snprintf(buf, sizeof(buf), spec, value);
+  else if (numStars == 1)
+    n = snprintf(buf, sizeof(buf), spec, stars[0], value);
+  else
+    n = snprintf(buf, sizeof(buf), spec, stars[0], stars[1], value);
+  if (n > 0)
+    out->append(buf, (std::min)(size_t(n), sizeof(buf) - 1));
+}
+
+// Formats a message from its format string and the encoded arguments
+static std::string FormatRecord(const char *fmt, const uint8_t *args)
+{
+  auto GetSlot = [&args]()
+  {
+    uint64_t value;
+    memcpy(&value, args, sizeof(value));
+    args += sizeof(value);
+    return value;
+  };
+  auto GetDouble = [&GetSlot]()
+  {
+    uint64_t bits = GetSlot();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  };
+
+  std::string message;
+  for (const char *p = fmt; *p; )
+  {
+    const char *literal = p;
+    while (*p && *p != '%')
+      p++;
+    message.append(literal, p - literal);
+    if (!*p)
+      break;
+
+    int numStars;
+    ArgType type;
+    const char *start = p;
+    p = ParseFormatSpec(p, &numStars, &type);
+    char spec[MAX_FORMAT_SPEC_LENGTH];
+    memcpy(spec, start, p - start);
+    spec[p - start] = '\0';
+    int stars[2];
+    for (int i = 0; i < numStars; i++)
+      stars[i] = int(int64_t(GetSlot()));
+
+    switch (type)
+    {
+    case ArgType::None:       message += '%'; break;
+    case ArgType::Int:        FormatArg(&message, spec, stars, numStars, int(int64_t(GetSlot()))); break;
+    case ArgType::Long:       FormatArg(&message, spec, stars, numStars, long(int64_t(GetSlot()))); break;
+    case ArgType::LongLong:   FormatArg(&message, spec, stars, numStars, (long long)(GetSlot())); break;
+    case ArgType::SizeT:      FormatArg(&message, spec, stars, numStars, size_t(GetSlot())); break;
+    case ArgType::IntMax:     FormatArg(&message, spec, stars, numStars, intmax_t(GetSlot())); break;
+    case ArgType::PtrDiff:    FormatArg(&message, spec, stars, numStars, ptrdiff_t(int64_t(GetSlot()))); break;
+    case ArgType::Double:     FormatArg(&message, spec, stars, numStars, GetDouble()); break;
+    case ArgType::LongDouble: FormatArg(&message, spec, stars, numStars, (long double)(GetDouble())); break;
+    case ArgType::Pointer:    FormatArg(&message, spec, stars, numStars, reinterpret_cast<void *>(uintptr_t(GetSlot()))); break;
+    case ArgType::String:
+    {
+      size_t length = size_t(GetSlot());
+      std::string str(reinterpret_cast<const char *>(args), length);
+      args += (length + 7) & ~size_t(7);
+      FormatArg(&message, spec, stars, numStars, str.c_str());
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return message;
+}
+
+// Single producer (the owning thread), single consumer (the writer thread)
+struct CAsyncLogger::RingBuffer
+{
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> record;        // scratch space for encoding, used by the owning thread only
+  std::atomic<uint64_t> writePos{0};
+  std::atomic<uint64_t> readPos{0};
+  std::atomic<bool> wakePending{false};
+
+  // Returns false if there is no room, otherwise the position just past it
+  bool Write(const std::vector<uint8_t> &rec, uint64_t *end)
+  {
+    size_t capacity = data.size();
+    uint64_t write = writePos.load(std::memory_order_relaxed);
+    uint64_t read = readPos.load(std::memory_order_acquire);
+    size_t offset = size_t(write & (capacity - 1));
+    size_t padding = capacity - offset < rec.size() ? capacity - offset : 0;
+    if (capacity - size_t(write - read) < padding + rec.size())
+      return false;
+    if (padding >= sizeof(RecordHeader))
+    {
+      RecordHeader header = { uint32_t(padding), PADDING_RECORD, 0, nullptr, 0 };
+      memcpy(&data[offset], &header, sizeof(header));
+    }
+    memcpy(&data[size_t((write + padding) & (capacity - 1))], rec.data(), rec.size());
+    *end = write + padding + rec.size();
+    writePos.store(*end, std::memory_order_release);
+    return true;
+  }
+
+  size_t Used() const
+  {
+    return size_t(writePos.load(std::memory_order_relaxed) - readPos.load(std::memory_order_relaxed));
+  }
+
+  RingBuffer()
+    : data(ASYNC_LOG_BUFFER_SIZE)
+  {
+  }
+};
+
+// A thread's buffer for the async logger it last logged to
+struct CAsyncLogger::ThreadBuffer
+{
+  uint64_t loggerId = 0;
+  std::shared_ptr<RingBuffer> ring;
+};
+
+static std::atomic<uint64_t> s_nextAsyncLoggerId{1};
+
+CAsyncLogger::RingBuffer *CAsyncLogger::GetRingBuffer()
+{
+  static thread_local ThreadBuffer t_buffer;
+  if (t_buffer.loggerId != m_id)
+  {
+    // The buffer for any previous logger is left to it to drain and release
+    t_buffer.ring = std::make_shared<RingBuffer>();
+    t_buffer.loggerId = m_id;
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_rings.push_back(t_buffer.ring);
+  }
+  return t_buffer.ring.get();
+}
+
+void CAsyncLogger::Log(LogLevel level, const char *fmt, va_list vl)
+{
+  if (level < m_logLevel)
+    return;
+
+  // Anything logged by the writer thread itself (or by the logger it feeds)
+  // can't wait for the writer thread
+  if (std::this_thread::get_id() == m_thread.get_id())
+  {
+    switch (level)
+    {
+    case LogLevel::Debug: m_logger->DebugLog(fmt, vl); break;
+    case LogLevel::Info:  m_logger->InfoLog(fmt, vl); break;
+    default:              m_logger->ErrorLog(fmt, vl); break;
+    }
+    return;
+  }
+
+  RingBuffer *ring = GetRingBuffer();
+  std::vector<uint8_t> &record = ring->record;
+  record.resize(sizeof(RecordHeader));
+
+  va_list vl_tmp;
+  va_copy(vl_tmp, vl);
+  bool encoded = EncodeArgs(&record, fmt, vl_tmp);
+  va_end(vl_tmp);
+  if (!encoded || record.size() > ASYNC_LOG_BUFFER_SIZE / 4)
+  {
+    // Format it here and pass it on as a string
+    char string[MAX_STRING_LENGTH + 1];
+    vsnprintf(string, sizeof(string), fmt, vl);
+    record.resize(sizeof(RecordHeader));
+    PutString(&record, string);
+    fmt = "%s";
+  }
+
+  RecordHeader header = { uint32_t(record.size()), uint32_t(level), m_nextSeq.fetch_add(1, std::memory_order_relaxed), fmt, 0 };
+  memcpy(record.data(), &header, sizeof(header));
+
+  uint64_t end;
+  if (level == LogLevel::Debug)
+  {
+    if (!ring->Write(record, &end))
+    {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    // Hurry the writer thread along when the buffer is getting full
+    if (ring->Used() > ASYNC_LOG_BUFFER_SIZE / 2 && !ring->wakePending.exchange(true))
+      m_wakeWriter.notify_one();
+    return;
+  }
+
+  // Info and error messages are never dropped and are written before
+  // returning
+  std::unique_lock<std::mutex> lock(m_mtx);
+  while (!ring->Write(record, &end))
+  {
+    m_wakeWriter.notify_one();
+    m_written.wait(lock);
+  }
+  m_wakeWriter.notify_one();
+  m_written.wait(lock, [ring, end]() { return ring->readPos.load(std::memory_order_acquire) >= end; });
+}
+
+void CAsyncLogger::WriteMessages(const std::vector<std::shared_ptr<RingBuffer>> &rings)
+{
+  struct Message
+  {
+    uint64_t seq;
+    LogLevel level;
+    const char *fmt;
+    const uint8_t *args;
+  };
+  std::vector<Message> messages;
+  std::vector<uint64_t> ends(rings.size());
+
+  // Gather everything published so far
+  for (size_t i = 0; i < rings.size(); i++)
+  {
+    RingBuffer &ring = *rings[i];
+    size_t capacity = ring.data.size();
+    uint64_t read = ring.readPos.load(std::memory_order_relaxed);
+    uint64_t write = ring.writePos.load(std::memory_order_acquire);
+    while (read < write)
+    {
+      size_t offset = size_t(read & (capacity - 1));
+      if (capacity - offset < sizeof(RecordHeader))
+      {
+        read += capacity - offset;
+        continue;
+      }
+      RecordHeader header;
+      memcpy(&header, &ring.data[offset], sizeof(header));
+      if (header.level != PADDING_RECORD)
+        messages.push_back({ header.seq, LogLevel(header.level), header.fmt, &ring.data[offset + sizeof(RecordHeader)] });
+      read += header.size;
+    }
+    ends[i] = write;
+  }
+
+  std::sort(messages.begin(), messages.end(), [](const Message &a, const Message &b) { return a.seq < b.seq; });
+  for (auto &message: messages)
+  {
+    std::string str = FormatRecord(message.fmt, message.args);
+    switch (message.level)
+    {
+    case LogLevel::Debug: m_logger->DebugLog("%s", str.c_str()); break;
+    case LogLevel::Info:  m_logger->InfoLog("%s", str.c_str()); break;
+    default:              m_logger->ErrorLog("%s", str.c_str()); break;
+    }
+  }
+
+  uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+  if (dropped != m_droppedReported)
+  {
+    m_logger->InfoLog("Log buffer full: %llu debug messages dropped.", (unsigned long long) (dropped - m_droppedReported));
+    m_droppedReported = dropped;
+  }
+
+  // Hand the space back
+  for (size_t i = 0; i < rings.size(); i++)
+  {
+    rings[i]->readPos.store(ends[i], std::memory_order_release);
+    rings[i]->wakePending.store(false, std::memory_order_relaxed);
+  }
+}
+
+void CAsyncLogger::WriterThread()
+{
+  std::unique_lock<std::mutex> lock(m_mtx);
+  while (true)
+  {
+    bool quit = m_quit;
+    std::vector<std::shared_ptr<RingBuffer>> rings = m_rings;
+    lock.unlock();
+    WriteMessages(rings);
+    rings.clear();
+    lock.lock();
+
+    // Release buffers of threads that have exited
+    m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(),
+      [](const std::shared_ptr<RingBuffer> &ring) { return ring.use_count() == 1 && ring->Used() == 0; }),
+      m_rings.end());
+
+    m_written.notify_all();
+    if (quit)
+      break;
+    m_wakeWriter.wait_for(lock, std::chrono::milliseconds(10));
+  }
+}
+
+void CAsyncLogger::DebugLog(const char *fmt, va_list vl)
+{
+  Log(LogLevel::Debug, fmt, vl);
+}
+
+void CAsyncLogger::InfoLog(const char *fmt, va_list vl)
+{
+  Log(LogLevel::Info, fmt, vl);
+}
+
+void CAsyncLogger::ErrorLog(const char *fmt, va_list vl)
+{
+  Log(LogLevel::Error, fmt, vl);
+}
+
+CLogger::LogLevel CAsyncLogger::GetLogLevel() const
+{
+  return m_logLevel;
+}
+
+uint64_t CAsyncLogger::GetDroppedCount() const
+{
+  return m_dropped.load(std::memory_order_relaxed);
+}
+
+CAsyncLogger::CAsyncLogger(std::shared_ptr<CLogger> logger)
+  : m_logger(logger),
+    m_logLevel(logger->GetLogLevel()),
+    m_id(s_nextAsyncLoggerId.fetch_add(1))
+{
+  m_thread = std::thread(&CAsyncLogger::WriterThread, this);
+}
+
+CAsyncLogger::~CAsyncLogger()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_quit = true;
+  }
+  m_wakeWriter.notify_one();
+  m_thread.join();
+}
@@ -36,9 +36,12 @@
 #include <cstdio>
 #include <cstdarg>
 #include <cstring>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 
@@ -135,6 +138,18 @@ public:
 	}
 
 	virtual void ErrorLog(const char *fmt, va_list vl) = 0;
+
+	/*
+	 * GetLogLevel():
+	 *
+	 * Returns:
+	 *		The lowest level of message that is output. Messages below it may
+	 *		be discarded without being passed to the logger at all.
+	 */
+	virtual LogLevel GetLogLevel() const
+	{
+		return LogLevel::All;
+	}
 };
 
 /*
@@ -148,6 +163,7 @@ public:
   void DebugLog(const char *fmt, va_list vl);
   void InfoLog(const char *fmt, va_list vl);
   void ErrorLog(const char *fmt, va_list vl);
+  LogLevel GetLogLevel() const;
   CMultiLogger(std::vector<std::shared_ptr<CLogger>> loggers);
 
 private:
@@ -168,6 +184,7 @@ class CConsoleErrorLogger: public CLogger
   void DebugLog(const char *fmt, va_list vl);
   void InfoLog(const char *fmt, va_list vl);
   void ErrorLog(const char *fmt, va_list vl);
+  LogLevel GetLogLevel() const;
 };
 
 /*
@@ -183,6 +200,7 @@ public:
   void DebugLog(const char *fmt, va_list vl);
   void InfoLog(const char *fmt, va_list vl);
   void ErrorLog(const char *fmt, va_list vl);
+  LogLevel GetLogLevel() const;
   CFileLogger(LogLevel level, const std::vector<std::string> &filenames);
   CFileLogger(LogLevel level, const std::vector<std::string> &filenames, const std::vector<FILE *> &systemFiles);
 
@@ -208,12 +226,64 @@ public:
   void DebugLog(const char *fmt, va_list vl);
   void InfoLog(const char *fmt, va_list vl);
   void ErrorLog(const char *fmt, va_list vl);
+  LogLevel GetLogLevel() const;
   CSystemLogger(LogLevel level);
 
 private:
   LogLevel m_logLevel;
 };
 
+/*
+ * CAsyncLogger:
+ *
+ * Moves formatting and output off the calling thread. Each thread copies the
+ * format string pointer and the raw arguments into its own fixed-size ring
+ * buffer, and a background thread formats the messages and passes them on to
+ * another logger in the order they were logged. Debug messages that don't fit
+ * are dropped and counted. Info and error messages wait until they have been
+ * written, so they still survive a crash.
+ *
+ * Format strings must stay valid (i.e., be string literals). Formats the
+ * background thread can't reproduce (%n, wide strings) are formatted on the
+ * calling thread instead.
+ */
+class CAsyncLogger: public CLogger
+{
+public:
+  void DebugLog(const char *fmt, va_list vl);
+  void InfoLog(const char *fmt, va_list vl);
+  void ErrorLog(const char *fmt, va_list vl);
+  LogLevel GetLogLevel() const;
+
+  // Number of messages dropped because a thread's buffer was full
+  uint64_t GetDroppedCount() const;
+
+  CAsyncLogger(std::shared_ptr<CLogger> logger);
+  ~CAsyncLogger();
+
+private:
+  struct RingBuffer;
+  struct ThreadBuffer;
+
+  std::shared_ptr<CLogger> m_logger;
+  const LogLevel m_logLevel;
+  const uint64_t m_id;                            // identifies this logger to the per-thread buffers
+  std::atomic<uint64_t> m_nextSeq{0};             // orders messages across threads
+  std::atomic<uint64_t> m_dropped{0};
+  uint64_t m_droppedReported = 0;
+  std::mutex m_mtx;                               // guards m_rings, m_quit and the condition variables
+  std::condition_variable m_wakeWriter;
+  std::condition_variable m_written;
+  std::vector<std::shared_ptr<RingBuffer>> m_rings;
+  bool m_quit = false;
+  std::thread m_thread;
+
+  RingBuffer *GetRingBuffer();
+  void Log(LogLevel level, const char *fmt, va_list vl);
+  void WriteMessages(const std::vector<std::shared_ptr<RingBuffer>> &rings);
+  void WriterThread();
+};
+
 
 /******************************************************************************
  Log Functions
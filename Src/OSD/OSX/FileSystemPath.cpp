@@ -43,6 +43,8 @@ namespace FileSystemPath
             return "";
         case Assets:
             return "Assets/";
+        case Cache:
+            return "Cache/";
         }
     }
 }
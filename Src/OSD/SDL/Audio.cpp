@@ -681,6 +681,11 @@ bool OutputAudio(unsigned numSamples, const float* leftFrontBuffer, const float*
     return bufferFull;
 }
 
+unsigned GetAudioUnderRuns()
+{
+    return underRuns;
+}
+
 void CloseAudio()
 {
     // Close SDL audio output
@@ -1,5 +1,7 @@
 #include "SDLIncludes.h"
 #include <GL/glew.h>
+#include <algorithm>
+#include <cfloat>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -13,9 +15,12 @@
 #include "../Pkgs/imgui/imgui_impl_opengl3.h"
 #include "../Src/Util/NewConfig.h"
 #include "Util/ConfigBuilders.h"
+#include "Util/Format.h"
+#include "OSD/FileSystemPath.h"
 #include "../Src/OSD/SDL/SDLInputSystem.h"
 #include "../Src/Inputs/Inputs.h"
 #include "Main.h"
+#include "Telemetry.h"
 
 #ifdef _WIN32
     #include "../Src/OSD/Windows/DirectInputSystem.h"
@@ -868,7 +873,7 @@ std::vector<std::string> RunGUI(const std::string& configPath, Util::Config::Nod
     ImGui_ImplOpenGL3_Init("#version 410");
 
     std::string xmlFile = config["GameXMLFile"].ValueAs<std::string>();
-    GameLoader loader(xmlFile);
+    GameLoader loader(xmlFile, Util::Format() << FileSystemPath::GetPath(FileSystemPath::Cache) << "Games.bin");
     auto& games = loader.GetGames();
     int selectedGame = -1;  // -1 means no selection
     std::vector<std::string> romFiles;
@@ -928,3 +933,93 @@ exitNoSave:
 }
 
 
+
+static bool s_overlayInitialized = false;
+
+static void InitPerformanceOverlay(SDL_Window* window)
+{
+    // The emulator window is never resized from here and its inputs belong to the game, so
+    // the overlay ignores the mouse and keyboard and never touches the cursor
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.ConfigFlags |= ImGuiConfigFlags_NoMouse | ImGuiConfigFlags_NoMouseCursorChange | ImGuiConfigFlags_NoKeyboard;
+    io.IniFilename = nullptr;
+    ImGui::StyleColorsDark();
+
+    // The New3D engine runs on a 4.1 core profile, the legacy engine on a compatibility one
+    GLint profile = 0;
+    glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &profile);
+
+    ImGui_ImplSDL2_InitForOpenGL(window, SDL_GL_GetCurrentContext());
+    ImGui_ImplOpenGL3_Init((profile & GL_CONTEXT_CORE_PROFILE_BIT) ? "#version 410" : nullptr);
+    s_overlayInitialized = true;
+}
+
+void DrawPerformanceOverlay(SDL_Window* window, const CTelemetry& telemetry)
+{
+    if (!s_overlayInitialized) {
+        InitPerformanceOverlay(window);
+    }
+
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplSDL2_NewFrame();
+    ImGui::NewFrame();
+
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
+    ImGui::SetNextWindowBgAlpha(0.6f);
+    ImGui::Begin("Performance", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
+
+    size_t numSamples = telemetry.GetNumSamples();
+    if (numSamples == 0) {
+        ImGui::TextUnformatted("Waiting for frames...");
+    }
+    else {
+        const CTelemetry::Sample& latest = telemetry.GetSample(numSamples - 1);
+        float targetMs = latest.targetMs;
+
+        // Frame times, oldest first, and a histogram of them from 0 to twice the target
+        static float frameMs[CTelemetry::HISTORY_SIZE];
+        constexpr int numBuckets = 32;
+        float buckets[numBuckets] = {};
+        float maxMs = 0.0f;
+        for (size_t i = 0; i < numSamples; i++) {
+            float ms = telemetry.GetSample(i).frameMs;
+            frameMs[i] = ms;
+            maxMs = std::max(maxMs, ms);
+            int bucket = int(ms / (2.0f * targetMs) * numBuckets);
+            buckets[std::min(std::max(bucket, 0), numBuckets - 1)] += 1.0f;
+        }
+
+        ImGui::Text("Frame: %5.2f ms (target %5.2f ms, %.3f Hz)", latest.frameMs, targetMs, 1000.0f / targetMs);
+        ImGui::Text("p50 %5.2f  p95 %5.2f  p99 %5.2f  max %5.2f ms",
+            telemetry.GetFrameMsPercentile(50.0f), telemetry.GetFrameMsPercentile(95.0f), telemetry.GetFrameMsPercentile(99.0f), maxMs);
+        ImGui::PlotLines("##frametimes", frameMs, int(numSamples), 0, nullptr, 0.0f, 2.0f * targetMs, ImVec2(300, 60));
+        ImGui::PlotHistogram("##histogram", buckets, numBuckets, 0, nullptr, 0.0f, FLT_MAX, ImVec2(300, 60));
+
+        const FrameTimings& t = latest.timings;
+        ImGui::Text("PPC %3u  render %3u  sync %3u  snd %3u  drv %3u  net %3u ms", t.ppcTicks, t.renderTicks, t.syncTicks, t.sndTicks, t.drvTicks, t.netTicks);
+        ImGui::Text("Emulated frame %3u ms, sync %4u KB, upload %5u us, input %4u us", t.frameTicks, t.syncSize / 1024, t.uploadMicros, latest.inputMicros);
+        ImGui::Text("Audio under-runs: %u", latest.audioUnderRuns);
+        if (latest.net.messagesSent || latest.net.messagesReceived) {
+            ImGui::Text("Net: sent %llu KB, received %llu KB, saved %llu KB, latency %u us",
+                (unsigned long long) (latest.net.bytesSent / 1024), (unsigned long long) (latest.net.bytesReceived / 1024),
+                (unsigned long long) (latest.net.bytesSaved / 1024), latest.net.latencyMicros);
+        }
+    }
+
+    ImGui::End();
+    ImGui::Render();
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+}
+
+void ShutdownPerformanceOverlay()
+{
+    if (!s_overlayInitialized) {
+        return;
+    }
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplSDL2_Shutdown();
+    ImGui::DestroyContext();
+    s_overlayInitialized = false;
+}
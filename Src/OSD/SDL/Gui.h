@@ -4,6 +4,13 @@
 #include <string>
 #include <vector>
 
+class CTelemetry;
+
 std::vector<std::string> RunGUI(const std::string& configPath, Util::Config::Node& config);
 
+// In-game performance overlay, drawn over the emulator output before the buffers are swapped.
+// It is set up on first use with the window's current GL context.
+void DrawPerformanceOverlay(SDL_Window* window, const CTelemetry& telemetry);
+void ShutdownPerformanceOverlay();
+
 #endif // !_GUI_H_
@@ -71,6 +71,7 @@
 #include <cstdarg>
 #include <memory>
 #include <vector>
+#include <thread>
 #include <algorithm>
 #include <GL/glew.h>
 
@@ -86,9 +87,14 @@
 #include "Util/ConfigBuilders.h"
 #include "OSD/FileSystemPath.h"
 #include "GameLoader.h"
+#include "ROMImageCache.h"
+#include "RewindBuffer.h"
+#include "RunAhead.h"
+#include "Inputs/InputRecording.h"
 #include "SDLInputSystem.h"
 #include "SDLIncludes.h"
 #include "Debugger/SupermodelDebugger.h"
+#include "CPU/PowerPC/PPCProfiler.h"
 #ifndef SUPERMODEL_OSX
 #include "Graphics/Legacy3D/Legacy3D.h"
 #endif
@@ -98,12 +104,15 @@
 #include "OSD/Audio.h"
 #include "Graphics/New3D/VBO.h"
 #include "Graphics/SuperAA.h"
+#include "Graphics/Shader.h"
 #include "Sound/MPEG/MpegAudio.h"
 
 #include <iostream>
 #include "Util/BMPFile.h"
 
 #include "Crosshair.h"
+#include "Telemetry.h"
+#include "Network/NetLinkHarness.h"
 #include "OSD/DefaultConfigFile.h"
 #include "Gui.h"
 
@@ -115,6 +124,7 @@
 static const std::string s_analysisPath = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Analysis);
 static const std::string s_configFilePath = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Config) << "Supermodel.ini";
 static const std::string s_gameXMLFilePath = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Config) << "Games.xml";
+static const std::string s_gameDefinitionCachePath = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Cache) << "Games.bin";
 static const std::string s_musicXMLFilePath = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Config) << "Music.xml";
 static const std::string s_logFilePath = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Log) << "Supermodel.log";
 
@@ -144,6 +154,12 @@ static CRTcolor CRTcolors = CRTcolor::None; // default to no gamma/color adaptio
  */
 static CCrosshair* s_crosshair = nullptr;
 
+/*
+ * Performance telemetry and its overlay
+ */
+static std::unique_ptr<CTelemetry> s_telemetry;
+static bool s_showPerformanceOverlay = false;
+
 static Result SetGLGeometry(unsigned *xOffsetPtr, unsigned *yOffsetPtr, unsigned *xResPtr, unsigned *yResPtr, unsigned *totalXResPtr, unsigned *totalYResPtr, bool keepAspectRatio)
 {
   // What resolution did we actually get?
@@ -701,22 +717,28 @@ static void TestPolygonHeaderBits(IEmulator *Emu)
  including terminating \0).
 
  Different subsystems output their own blocks.
+
+ Save states are captured into memory on the emulation thread and compressed
+ and written out on a background thread. Uncompressed save states from older
+ versions load as before.
 ******************************************************************************/
 
 static const int STATE_FILE_VERSION = 6;  // save state file version
 static const int NVRAM_FILE_VERSION = 0;  // NVRAM file version
 static unsigned s_saveSlot = 0;           // save state slot #
+static std::thread s_saveStateWriter;     // compresses and writes the last save state
 
-static void SaveState(IEmulator *Model3)
+static void WaitForSaveStateWriter()
+{
+  if (s_saveStateWriter.joinable())
+    s_saveStateWriter.join();
+}
+
+static std::vector<uint8_t> SaveStateToMemory(IEmulator *Model3)
 {
   CBlockFile  SaveState;
 
-  std::string file_path = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Saves) << Model3->GetGame().name << ".st" << s_saveSlot;
-  if (Result::OKAY != SaveState.Create(file_path, "Supermodel Save State", "Supermodel Version " SUPERMODEL_VERSION))
-  {
-    ErrorLog("Unable to save state to '%s'.", file_path.c_str());
-    return;
-  }
+  SaveState.CreateInMemory("Supermodel Save State", "Supermodel Version " SUPERMODEL_VERSION);
 
   // Write file format version and ROM set ID to header block
   int32_t fileVersion = STATE_FILE_VERSION;
@@ -725,9 +747,46 @@ static void SaveState(IEmulator *Model3)
 
   // Save state
   Model3->SaveState(&SaveState);
-  SaveState.Close();
-  printf("Saved state to '%s'.\n", file_path.c_str());
-  InfoLog("Saved state to '%s'.", file_path.c_str());
+  return SaveState.TakeBuffer();
+}
+
+static void SaveState(IEmulator *Model3)
+{
+  std::string file_path = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Saves) << Model3->GetGame().name << ".st" << s_saveSlot;
+
+  // Only one write is in flight at a time, so states hit the disk in order
+  WaitForSaveStateWriter();
+  s_saveStateWriter = std::thread([file_path, data = SaveStateToMemory(Model3)]()
+  {
+    if (Result::OKAY != CBlockFile::WriteCompressed(file_path, data))
+    {
+      ErrorLog("Unable to save state to '%s'.", file_path.c_str());
+      return;
+    }
+    printf("Saved state to '%s'.\n", file_path.c_str());
+    InfoLog("Saved state to '%s'.", file_path.c_str());
+  });
+}
+
+static Result LoadStateFromBlockFile(IEmulator *Model3, CBlockFile *SaveState, const std::string &file_path)
+{
+  if (Result::OKAY != SaveState->FindBlock("Supermodel Save State"))
+  {
+    ErrorLog("'%s' does not appear to be a valid save state file.", file_path.c_str());
+    return Result::FAIL;
+  }
+
+  int32_t fileVersion;
+  SaveState->Read(&fileVersion, sizeof(fileVersion));
+  if (fileVersion != STATE_FILE_VERSION)
+  {
+    ErrorLog("'%s' is incompatible with this version of Supermodel.", file_path.c_str());
+    return Result::FAIL;
+  }
+
+  // Load
+  Model3->LoadState(SaveState, false);
+  return Result::OKAY;
 }
 
 static void LoadState(IEmulator *Model3, std::string file_path = std::string())
@@ -738,6 +797,9 @@ static void LoadState(IEmulator *Model3, std::string file_path = std::string())
   if (file_path.empty())
     file_path = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Saves) << Model3->GetGame().name << ".st" << s_saveSlot;
 
+  // The state may still be on its way to disk
+  WaitForSaveStateWriter();
+
   // Open and check to make sure format is correct
   if (Result::OKAY != SaveState.Load(file_path))
   {
@@ -745,22 +807,8 @@ static void LoadState(IEmulator *Model3, std::string file_path = std::string())
     return;
   }
 
-  if (Result::OKAY != SaveState.FindBlock("Supermodel Save State"))
-  {
-    ErrorLog("'%s' does not appear to be a valid save state file.", file_path.c_str());
+  if (Result::OKAY != LoadStateFromBlockFile(Model3, &SaveState, file_path))
     return;
-  }
-
-  int32_t fileVersion;
-  SaveState.Read(&fileVersion, sizeof(fileVersion));
-  if (fileVersion != STATE_FILE_VERSION)
-  {
-    ErrorLog("'%s' is incompatible with this version of Supermodel.", file_path.c_str());
-    return;
-  }
-
-  // Load
-  Model3->LoadState(&SaveState);
   SaveState.Close();
   printf("Loaded state from '%s'.\n", file_path.c_str());
   InfoLog("Loaded state from '%s'.", file_path.c_str());
@@ -859,6 +907,10 @@ void EndFrameVideo()
   if (videoInputs)
     s_crosshair->Update(currentInputs, videoInputs, xOffset, yOffset, xRes, yRes);
 
+  // Draw performance overlay
+  if (s_showPerformanceOverlay && s_telemetry)
+    DrawPerformanceOverlay(s_window, *s_telemetry);
+
   // Swap the buffers
   SDL_GL_SwapWindow(s_window);
 }
@@ -916,6 +968,15 @@ static void SuperSleepUntil(const uint64_t target)
  Main Program Loop
 ******************************************************************************/
 
+// Milliseconds since *start, which is advanced to now for timing the next phase
+static double StartupPhaseMs(uint64_t *start)
+{
+  uint64_t now = SDL_GetPerformanceCounter();
+  double ms = double(now - *start) * 1000.0 / double(SDL_GetPerformanceFrequency());
+  *start = now;
+  return ms;
+}
+
 #ifdef SUPERMODEL_DEBUGGER
 int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *Inputs, COutputs *Outputs, std::shared_ptr<Debugger::CDebugger> Debugger)
 {
@@ -925,19 +986,42 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
 {
 #endif // SUPERMODEL_DEBUGGER
   std::string initialState = s_runtime_config["InitStateFile"].ValueAs<std::string>();
+  std::string recordInputsFile = s_runtime_config["RecordInputs"].ValueAs<std::string>();
+  std::string replayInputsFile = s_runtime_config["ReplayInputs"].ValueAs<std::string>();
   uint64_t    prevFPSTicks;
   unsigned    fpsFramesElapsed;
   bool        gameHasLightguns = false;
   bool        quit = false;
   bool        paused = false;
   bool        dumpTimings = false;
+  bool        rewinding = false;
+  bool        fastForward = s_runtime_config["FastForward"].ValueAs<bool>();
+  unsigned    fastForwardFrames = 0;
+  std::unique_ptr<RewindBuffer> rewind;
+  std::unique_ptr<RunAhead> runAhead;
+  std::unique_ptr<CInputRecording> inputRecording;
+  std::unique_ptr<CInputRecording> inputReplay;
+  uint64_t    replayStartTicks = 0;
+  uint64_t    prevFrameTicks = 0;
+  float       targetFrameMs = 0;
+  CModel3     *timedModel3 = dynamic_cast<CModel3 *>(Model3);  // only the real system has frame timings
+#ifdef SUPERMODEL_PROFILER
+  std::unique_ptr<CPPCProfiler> profiler;
+#endif
+  Util::Config::Handle<bool> throttle(s_runtime_config, "Throttle");  // read every frame, changeable while running
+  Util::Config::Handle<bool> showFrameRate(s_runtime_config, "ShowFrameRate");
+  Util::Config::Handle<unsigned> fastForwardFrameSkip(s_runtime_config, "FastForwardFrameSkip");
+  Util::Config::Handle<bool> fastForwardSyncVideo(s_runtime_config, "FastForwardSyncVideo");
 
   // Initialize and load ROMs
+  uint64_t startupTime = SDL_GetPerformanceCounter();
   if (Result::OKAY != Model3->Init())
     return 1;
+  InfoLog("Startup: initialized emulator in %1.1f ms.", StartupPhaseMs(&startupTime));
   if (Model3->LoadGame(game, *rom_set) != Result::OKAY)
     return 1;
   *rom_set = ROMSet();  // free up this memory we won't need anymore
+  InfoLog("Startup: loaded ROMs into emulator in %1.1f ms.", StartupPhaseMs(&startupTime));
 
   // Customized music for games with MPEG boards
   MpegDec::LoadCustomTracks(s_musicXMLFilePath, game);
@@ -977,6 +1061,7 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
   SetAudioType(game.audio);
   if (Result::OKAY != OpenAudio(s_runtime_config))
     return 1;
+  InfoLog("Startup: set up video mode and audio in %1.1f ms.", StartupPhaseMs(&startupTime));
 
   // Hide mouse if fullscreen, enable crosshairs for gun games
   Inputs->GetInputSystem()->SetMouseVisibility(!s_runtime_config["FullScreen"].ValueAs<bool>());
@@ -1004,6 +1089,14 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
   SuperAA* superAA = new SuperAA(aaValue, CRTcolors);
   superAA->Init(totalXRes, totalYRes);  // pass actual frame sizes here
   CRender2D *Render2D = new CRender2D(s_runtime_config);
+#ifdef DEBUG
+  // The renderer holds handles to these, so they must exist before it is created for later changes to reach it
+  s_runtime_config.Set("Debug/HighlightPolyHeaderIdx", -1);
+  s_runtime_config.Set("Debug/HighlightPolyHeaderMask", 0u);
+  s_runtime_config.Set("Debug/HighlightCullingNodeIdx", -1);
+  s_runtime_config.Set("Debug/HighlightCullingNodeMask", 0u);
+  s_runtime_config.Set("Debug/ForceFlushModels", false);
+#endif
 #ifndef SUPERMODEL_OSX
   IRender3D *Render3D = s_runtime_config["New3DEngine"].ValueAs<bool>() ? ((IRender3D *) new New3D::CNew3D(s_runtime_config, Model3->GetGame().name)) : ((IRender3D *) new Legacy3D::CLegacy3D(s_runtime_config));
 #else
@@ -1019,6 +1112,7 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
     goto QuitError;
 
   Model3->AttachRenderers(Render2D,Render3D, superAA);
+  InfoLog("Startup: initialized renderers in %1.1f ms.", StartupPhaseMs(&startupTime));
 
   // Reset emulator
   Model3->Reset();
@@ -1027,6 +1121,54 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
   if (!initialState.empty())
     LoadState(Model3, initialState);
 
+  // Keep a history of states to step back through
+  if (s_runtime_config["Rewind"].ValueAs<bool>())
+  {
+    size_t historySize = size_t(s_runtime_config["RewindBufferSize"].ValueAs<unsigned>()) << 20;
+    rewind = std::make_unique<RewindBuffer>(historySize, s_runtime_config["RewindInterval"].ValueAs<unsigned>());
+  }
+
+  // Record inputs from here on, or replay a recording from the state it
+  // started from
+  if (!replayInputsFile.empty())
+  {
+    inputReplay = std::make_unique<CInputRecording>();
+    if (Result::OKAY != inputReplay->Load(replayInputsFile, game.name, Inputs->GetEmulatedInputs(game)))
+      goto QuitError;
+    CBlockFile startState;
+    startState.LoadFromMemory(inputReplay->GetStartState());
+    if (Result::OKAY != LoadStateFromBlockFile(Model3, &startState, replayInputsFile))
+      goto QuitError;
+    replayStartTicks = SDL_GetPerformanceCounter();
+  }
+  else if (!recordInputsFile.empty())
+  {
+    inputRecording = std::make_unique<CInputRecording>();
+    inputRecording->Start(game.name, Inputs->GetEmulatedInputs(game), SaveStateToMemory(Model3));
+  }
+
+  // Run frames ahead to hide input lag
+  if (s_runtime_config["RunAhead"].ValueAs<unsigned>() > 0)
+    runAhead = std::make_unique<RunAhead>(s_runtime_config["RunAhead"].ValueAs<unsigned>());
+
+  // Sample game inputs as late as possible (replays supply their own)
+  if (!inputReplay)
+    Inputs->SetDeferredPolling(s_runtime_config["InputPollRate"].ValueAs<unsigned>());
+
+#ifdef SUPERMODEL_PROFILER
+  // Sample the PowerPC for a hot-spot report on exit
+  if (s_runtime_config["ProfilePPC"].ValueAs<bool>())
+  {
+    profiler = std::make_unique<CPPCProfiler>(s_runtime_config["ProfileInterval"].ValueAs<unsigned>());
+    ppc_attach_profiler(profiler.get());
+  }
+#endif
+
+  // Collect frame timings for the performance overlay and telemetry output
+  s_telemetry = std::make_unique<CTelemetry>(s_runtime_config);
+  s_showPerformanceOverlay = s_runtime_config["PerformanceOverlay"].ValueAs<bool>();
+  targetFrameMs = 1e6f / float(GetDesiredRefreshRateMilliHz());
+
 #ifdef SUPERMODEL_DEBUGGER
   // If debugger was supplied, set it as logger and attach it to system
   oldLogger = GetLogger();
@@ -1040,6 +1182,7 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
   // Emulate!
   fpsFramesElapsed = 0;
   prevFPSTicks = SDL_GetPerformanceCounter();
+  prevFrameTicks = prevFPSTicks;
   quit = false;
   paused = false;
   dumpTimings = false;
@@ -1056,11 +1199,56 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
     if (!Inputs->Poll(&game, xOffset, yOffset, xRes, yRes))
       quit = true;
 
-    // Render if paused, otherwise run a frame
+    // Render if paused or stepping back while the rewind key is held,
+    // otherwise run a frame
     if (paused)
       Model3->RenderFrame();
+    else if (rewind && Inputs->uiRewind->value)
+    {
+      if (!rewinding)
+      {
+        Model3->PauseThreads();
+        SetAudioEnabled(false);
+        rewinding = true;
+      }
+      rewind->StepBack(Model3);
+      Model3->RenderFrame();
+    }
     else
-      Model3->RunFrame();
+    {
+      if (rewinding)
+      {
+        Model3->ResumeThreads();
+        SetAudioEnabled(true);
+        rewinding = false;
+      }
+
+      // Replayed inputs take the place of the polled ones
+      if (inputReplay && !inputReplay->ReplayFrame())
+        break;
+
+      if (fastForward)
+      {
+        // Draw only every Nth frame and drop the sound
+        Model3->SetFrameOutput(++fastForwardFrames % fastForwardFrameSkip.Value() == 0, false, fastForwardSyncVideo.Value());
+        Model3->RunFrame();
+      }
+      else if (runAhead)
+        runAhead->RunFrame(Model3);
+      else
+        Model3->RunFrame();
+
+      if (inputRecording)
+        inputRecording->RecordFrame(Model3->HashRAM());
+      else if (inputReplay && !inputReplay->CheckFrame(Model3->HashRAM()) && inputReplay->GetFirstMismatch() + 1 == int(inputReplay->GetFrameNumber()))
+        ErrorLog("Replay of '%s' diverged from the recording at frame %d.", replayInputsFile.c_str(), inputReplay->GetFirstMismatch());
+      if (rewind && rewind->FrameEnded())
+      {
+        Model3->PauseThreads();
+        rewind->Capture(Model3);
+        Model3->ResumeThreads();
+      }
+    }
 
 #ifdef SUPERMODEL_DEBUGGER
     bool processUI = true;
@@ -1304,6 +1492,22 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
       s_runtime_config.Get("Throttle").SetValue(!s_runtime_config["Throttle"].ValueAs<bool>());
       printf("Frame limiting: %s\n", s_runtime_config["Throttle"].ValueAs<bool>() ? "On" : "Off");
     }
+    else if (Inputs->uiToggleFastForward->Pressed())
+    {
+      // Toggle fast-forward
+      fastForward = !fastForward;
+      if (!fastForward)
+      {
+        Model3->SetFrameOutput(true, true, true);
+        SDL_SetWindowTitle(s_window, baseTitleStr);
+      }
+      printf("Fast-forward: %s\n", fastForward ? "On" : "Off");
+    }
+    else if (Inputs->uiTogglePerfOverlay->Pressed())
+    {
+      // Toggle performance overlay
+      s_showPerformanceOverlay = !s_showPerformanceOverlay;
+    }
     else if (Inputs->uiScreenshot->Pressed())
     {
       // Make a screenshot
@@ -1319,7 +1523,7 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
 #endif // SUPERMODEL_DEBUGGER
 
     // Refresh rate (frame limiting)
-    if (paused || s_runtime_config["Throttle"].ValueAs<bool>())
+    if (paused || (throttle.Value() && !fastForward))
     {
         SuperSleepUntil(nextTime);
         nextTime = SDL_GetPerformanceCounter() + perfCountPerFrame;
@@ -1327,20 +1531,41 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
 
     // Measure frame rate
     uint64_t currentFPSTicks = SDL_GetPerformanceCounter();
-    if (s_runtime_config["ShowFrameRate"].ValueAs<bool>())
+    if (showFrameRate.Value() || fastForward)
     {
       fpsFramesElapsed += 1;
       uint64_t measurementTicks = currentFPSTicks - prevFPSTicks;
       if (measurementTicks >= s_perfCounterFrequency) // update FPS every 1 second (s_perfCounterFrequency is how many perf ticks in one second)
       {
         double fps = double(fpsFramesElapsed) / (double(measurementTicks) / double(s_perfCounterFrequency));
-        snprintf(titleStr, sizeof(titleStr), "%s - %1.3f FPS%s", baseTitleStr, fps, paused ? " (Paused)" : "");
+        if (fastForward)
+          snprintf(titleStr, sizeof(titleStr), "%s - Fast-forward %1.1fx%s", baseTitleStr, fps * 1000.0 / GetDesiredRefreshRateMilliHz(), paused ? " (Paused)" : "");
+        else
+          snprintf(titleStr, sizeof(titleStr), "%s - %1.3f FPS%s", baseTitleStr, fps, paused ? " (Paused)" : "");
         SDL_SetWindowTitle(s_window, titleStr);
         prevFPSTicks = currentFPSTicks;   // reset tick count
         fpsFramesElapsed = 0;             // reset frame count
       }
     }
 
+    // Record frame timings, actual versus target frame time, audio under-runs,
+    // net link traffic and input polling time, skipping frames that did not
+    // run the emulator
+    if (timedModel3 && !paused && !rewinding)
+    {
+      CTelemetry::Sample sample;
+      sample.timings = timedModel3->GetTimings();
+      sample.audioUnderRuns = GetAudioUnderRuns();
+      sample.frameMs = float(double(currentFPSTicks - prevFrameTicks) * 1000.0 / double(s_perfCounterFrequency));
+      sample.targetMs = targetFrameMs;
+      INetBoard *netBoard = timedModel3->GetNetBoard();
+      if (netBoard && netBoard->IsRunning())
+        sample.net = netBoard->GetLinkStats();
+      sample.inputMicros = Inputs->GetPollMicros();
+      s_telemetry->AddSample(sample);
+    }
+    prevFrameTicks = currentFPSTicks;
+
     if (dumpTimings && !paused)
     {
       CModel3 *M = dynamic_cast<CModel3 *>(Model3);
@@ -1352,6 +1577,19 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
   // Make sure all threads are paused before shutting down
   Model3->PauseThreads();
 
+#ifdef SUPERMODEL_PROFILER
+  // Report PowerPC hot spots, named by the debugger if there is one
+  if (profiler)
+  {
+    ppc_attach_profiler(nullptr);
+#ifdef SUPERMODEL_DEBUGGER
+    profiler->Report(stdout, Debugger != NULL ? Debugger->GetCPU("MainPPC") : nullptr);
+#else
+    profiler->Report(stdout, nullptr);
+#endif
+  }
+#endif
+
 #ifdef SUPERMODEL_DEBUGGER
   // If debugger was supplied, detach it from system and restore old logger
   if (Debugger != NULL)
@@ -1361,13 +1599,33 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
   }
 #endif // SUPERMODEL_DEBUGGER
 
-  // Save NVRAM
-  SaveNVRAM(Model3);
+  // Report on the replay, which leaves NVRAM alone, or save the recording
+  if (inputReplay)
+  {
+    double seconds = double(SDL_GetPerformanceCounter() - replayStartTicks) / double(s_perfCounterFrequency);
+    unsigned frames = inputReplay->GetFrameNumber();
+    printf("Replayed %u of %u frames in %1.2f s (%1.1f FPS).\n", frames, inputReplay->GetNumFrames(), seconds, seconds > 0 ? frames / seconds : 0.0);
+    if (inputReplay->GetFirstMismatch() >= 0)
+      printf("Emulated RAM diverged from the recording at frame %d.\n", inputReplay->GetFirstMismatch());
+    else
+      printf("Emulated RAM matched the recording on every frame.\n");
+  }
+  else if (inputRecording)
+    inputRecording->Save(recordInputsFile);
+
+  // Save NVRAM and finish writing any save state
+  if (!inputReplay)
+    SaveNVRAM(Model3);
+  WaitForSaveStateWriter();
 
   // Close audio
   CloseAudio();
 
+  Inputs->SetDeferredPolling(0);
+
   // Shut down renderers
+  ShutdownPerformanceOverlay();
+  s_telemetry.reset();
   delete Render2D;
   delete Render3D;
   delete superAA;
@@ -1376,6 +1634,13 @@ int Supermodel(const Game &game, ROMSet *rom_set, IEmulator *Model3, CInputs *In
 
   // Quit with an error
 QuitError:
+  WaitForSaveStateWriter();
+  Inputs->SetDeferredPolling(0);
+#ifdef SUPERMODEL_PROFILER
+  ppc_attach_profiler(nullptr);
+#endif
+  ShutdownPerformanceOverlay();
+  s_telemetry.reset();
   delete Render2D;
   delete Render3D;
   delete superAA;
@@ -1505,10 +1770,18 @@ Util::Config::Node DefaultConfig()
   
   config.Set("GameXMLFile", s_gameXMLFilePath);
   config.Set("InitStateFile", "");
+  config.Set("RecordInputs", "");
+  config.Set("ReplayInputs", "");
   // CModel3
   config.Set("PowerPCFrequency", 0u, "Core", 0u, 200u);
   config.Set("MultiThreaded", true,"Core");
   config.Set("GPUMultiThreaded", true, "Core");
+  config.Set("ROMCache", false, "Core");
+  config.Set("Rewind", false, "Core");
+  config.Set("RewindBufferSize", 128u, "Core", 1u, 4096u);
+  config.Set("RewindInterval", 4u, "Core", 1u, 60u);
+  config.Set("RunAhead", 0u, "Core", 0u, 8u);
+  config.Set("InputPollRate", 0u, "Core", 0u, 1000u);
   // 2D and 3D graphics engines
 #ifndef SUPERMODEL_OSX
   config.Set("MultiTexture", false, "Legacy3D");
@@ -1536,6 +1809,9 @@ Util::Config::Node DefaultConfig()
   // Platform-specific/UI
   config.Set("New3DEngine", true, "Video");
   config.Set("QuadRendering", false, "Video");
+  config.Set("IndirectDraw", true, "Video");
+  config.Set("ModelCache", false, "Video");
+  config.Set("ShaderCache", true, "Video");
   config.Set("XResolution", 496, "Video");
   config.Set("YResolution", 384, "Video");
   config.SetEmpty("WindowXPosition");
@@ -1550,8 +1826,12 @@ Util::Config::Node DefaultConfig()
   config.Set("WideBackground", false, "Video");
   config.Set("VSync", true, "Video");
   config.Set("Throttle", true, "Video");
+  config.Set("FastForward", false, "Video");
+  config.Set("FastForwardFrameSkip", 10u, "Video", 1u, 100u);
+  config.Set("FastForwardSyncVideo", false, "Video");
   config.Set("RefreshRate", 60.0f, "Video", 0.0f, 0.0f, { 57.5f,60.f });
   config.Set("ShowFrameRate", false, "Video");
+  config.Set("PerformanceOverlay", false, "Video");
   config.Set("Crosshairs", int(0), "Video", 0, 0, { 0,1,2,3 });
   config.Set<std::string>("CrosshairStyle", "vector", "Video", "", "", { "bmp","vector" });
   config.Set("NoWhiteFlash", false, "Video");
@@ -1590,6 +1870,10 @@ Util::Config::Node DefaultConfig()
   config.Set("PortIn", unsigned(1970), "Network");
   config.Set("PortOut", unsigned(1971), "Network");
   config.Set<std::string>("AddressOut", "127.0.0.1", "Network", "", "");
+  config.Set("NetLookahead", 0u, "Network", 0u, 4u);
+  config.Set("NetTimeout", 5000u, "Network", 100u, 60000u);
+  config.Set("NetDelta", false, "Network");
+  config.Set("NetDeltaKeyframe", 60u, "Network", 1u, 3600u);
 
 #ifdef SUPERMODEL_WIN32
   config.Set<std::string>("Outputs", "none", "Misc", "", "", { "none","win","net" });
@@ -1600,7 +1884,15 @@ Util::Config::Node DefaultConfig()
   config.Set<unsigned int>("OutputsTCPPort", 8000, "Misc", 1024, 65535);
   config.Set<unsigned int>("OutputsUDPBroadcastPort", 8001, "Misc", 1024, 65535);
 
+  config.Set<std::string>("TelemetryOutput", "", "Misc", "", "");
+  config.Set<std::string>("TelemetryFormat", "csv", "Misc", "", "", { "csv","json" });
+  config.Set<unsigned>("TelemetryMaxFileSize", 16, "Misc", 1, 4096);
+
   config.Set("DumpMemory", false, "Misc");
+#ifdef SUPERMODEL_PROFILER
+  config.Set("ProfilePPC", false, "Misc");
+  config.Set("ProfileInterval", 251u, "Misc", 1u, 1000000u);
+#endif
   config.Set("DumpTextures", false, "Misc");
 
   //
@@ -1839,12 +2131,20 @@ static void Help(void)
   printf("  -game-xml-file=<file>   ROM set definition file [Default: %s]\n", s_gameXMLFilePath.c_str());
   printf("  -log-output=<outputs>   Log output destination(s) [Default: %s]\n", s_logFilePath.c_str());
   puts("  -log-level=<level>      Logging threshold [Default: info]");
+  puts("  -no-log-async           Write debug logs on the calling thread, not a background thread");
   puts("");
   puts("Core Options:");
   puts("  -ppc-frequency=<mhz>    PowerPC frequency (default varies by stepping)");
   puts("  -no-threads             Disable multi-threading entirely");
   puts("  -gpu-multi-threaded     Run graphics rendering in separate thread [Default]");
   puts("  -no-gpu-thread          Run graphics rendering in main thread");
+  puts("  -rom-cache              Keep assembled ROM images on disk for faster startup");
+  puts("  -no-rom-cache           Load ROMs from the zip file on every run [Default]");
+  puts("  -rewind                 Keep a history of states to step back through");
+  puts("  -no-rewind              Disable rewinding [Default]");
+  puts("  -rewind-buffer-size=<n> Memory for the rewind history in MB [Default: 128]");
+  puts("  -rewind-interval=<n>    Frames between rewind snapshots [Default: 4]");
+  puts("  -run-ahead=<n>          Frames to run ahead to hide input lag [Default: 0]");
   puts("  -load-state=<file>      Load save state after starting");
   puts("");
   puts("Video Options:");
@@ -1861,10 +2161,16 @@ static void Help(void)
   puts("  -upscalemode=<n>        2D layer upscaling filter mode (range 0-3)");
   puts("  -crtcolors=<n>          CRT color emulation (range 0-5)");
   puts("  -no-throttle            Disable frame rate lock");
+  puts("  -fast-forward           Start in fast-forward mode (toggle with Alt-F)");
+  puts("  -fast-forward-frame-skip=<n>");
+  puts("                          Draw one frame in <n> when fast-forwarding [Default: 10]");
+  puts("  -fast-forward-sync-video");
+  puts("                          Copy video memory on skipped frames too");
   puts("  -vsync                  Lock to vertical refresh rate [Default]");
   puts("  -no-vsync               Do not lock to vertical refresh rate");
   puts("  -true-hz                Use true Model 3 refresh rate of 57.524 Hz");
   puts("  -show-fps               Display frame rate in window title bar");
+  puts("  -perf-overlay           Show frame time overlay (toggle with Alt-G)");
   puts("  -crosshairs=<n>         Crosshairs configuration for gun games:");
   puts("                          0=none [Default], 1=P1 only, 2=P2 only, 3=P1 & P2");
   puts("  -crosshair-style=<s>    Crosshair style: vector or bmp. [Default: vector]");
@@ -1872,6 +2178,14 @@ static void Help(void)
   puts("  -new3d                  New 3D engine by Ian Curtis [Default]");
 #endif
   puts("  -quad-rendering         Enable proper quad rendering");
+  puts("  -indirect-draw          Batch meshes with multi draw indirect (new engine,");
+  puts("                          needs OpenGL 4.3) [Default]");
+  puts("  -no-indirect-draw       Issue one draw call per mesh (new engine)");
+  puts("  -model-cache            Keep parsed VROM models on disk between runs (new");
+  puts("                          engine)");
+  puts("  -no-model-cache         Parse VROM models on every run [Default]");
+  puts("  -shader-cache           Keep compiled shader binaries on disk [Default]");
+  puts("  -no-shader-cache        Compile shaders from source on every run");
 #ifndef SUPERMODEL_OSX
   puts("  -legacy3d               Legacy 3D engine (faster but less accurate)");
   puts("  -multi-texture          Use 8 texture maps for decoding (legacy engine)");
@@ -1903,6 +2217,16 @@ static void Help(void)
   puts("  -net                    Enable net board");
   puts("  -simulate-netboard      Simulate the net board [Default]");
   puts("  -emulate-netboard       Emulate the net board (requires -no-threads)");
+  puts("  -net-delta              Send only the changes to link data (simulated net");
+  puts("                          board, must be set on all machines)");
+  puts("  -no-net-delta           Send link data in full [Default]");
+  puts("  -net-delta-keyframe=<n> Frames between full resends of link data when");
+  puts("                          using -net-delta [Default: 60]");
+  puts("  -net-harness=<n>        Link <n> simulated net boards inside this process,");
+  puts("                          exchange test data, print throughput and quit");
+  puts("  -net-harness-frames=<n> Frames the harness runs [Default: 3600]");
+  puts("  -net-harness-game=<s>   Game whose link protocol the harness follows");
+  puts("                          [Default: scud]");
   puts("");
   puts("Input Options:");
   puts("  -force-feedback         Enable force feedback (DirectInput, XInput)");
@@ -1911,13 +2235,33 @@ static void Help(void)
   printf("  -input-system=<s>       Input system [Default: %s]\n", defaultConfig["InputSystem"].ValueAs<std::string>().c_str());
 #endif
   puts("  -print-inputs           Prints current input configuration");
+  puts("  -input-poll-rate=<hz>   Read game inputs when the game reads them and");
+  puts("                          update controllers meanwhile at this rate (up");
+  puts("                          to 1000), 0 to poll once per frame [Default: 0]");
   puts("");
   puts("Output Options:");
   printf("  -outputs=<s>            Outputs [Default: %s]\n", defaultConfig["Outputs"].ValueAs<std::string>().c_str());
   puts("");
+  puts("Telemetry Options:");
+  puts("  -telemetry-output=<s>   Write per-frame timings to a file, or to a UNIX");
+  puts("                          domain socket given as unix:<path>");
+  puts("  -telemetry-format=<s>   Telemetry format: csv or json [Default: csv]");
+  puts("  -telemetry-max-file-size=<n>");
+  puts("                          Size in MB at which the file is rotated to");
+  puts("                          <file>.1 [Default: 16]");
+  puts("");
   puts("Debug Options:");
   puts("  -dump-memory            Write memory regions to files on exit");
   puts("  -dump-textures          Write textures to bitmap image files on exit");
+  puts("  -record-inputs=<file>   Record inputs for replay, starting from the initial");
+  puts("                          state");
+  puts("  -replay-inputs=<file>   Replay recorded inputs, checking emulated RAM against");
+  puts("                          the recording, and quit");
+#ifdef SUPERMODEL_PROFILER
+  puts("  -profile-ppc            Sample PowerPC hot spots and bus accesses, and print");
+  puts("                          a report on exit");
+  puts("  -profile-interval=<n>   Instructions between samples [Default: 251]");
+#endif // SUPERMODEL_PROFILER
 #ifdef SUPERMODEL_DEBUGGER
   puts("  -disable-debugger       Completely disable debugger functionality");
   puts("  -enter-debugger         Enter debugger at start of emulation");
@@ -1942,6 +2286,9 @@ struct ParsedCommandLine
   bool print_inputs = false;
   bool disable_debugger = false;
   bool enter_debugger = false;
+  unsigned net_harness = 0;
+  unsigned net_harness_frames = 3600;
+  std::string net_harness_game = "scud";
 #ifdef DEBUG
   std::string gfx_state;
 #endif
@@ -1952,6 +2299,7 @@ struct ParsedCommandLine
     // therefore, defaults are needed early
     config.Set("LogOutput", s_logFilePath.c_str());
     config.Set("LogLevel", "info");
+    config.Set("LogAsync", true);
   }
 };
 
@@ -1962,7 +2310,13 @@ static ParsedCommandLine ParseCommandLine(int argc, char **argv)
   { // -option=value
     { "-game-xml-file",         "GameXMLFile"             },
     { "-load-state",            "InitStateFile"           },
+    { "-fast-forward-frame-skip", "FastForwardFrameSkip"  },
+    { "-record-inputs",         "RecordInputs"            },
+    { "-replay-inputs",         "ReplayInputs"            },
     { "-ppc-frequency",         "PowerPCFrequency"        },
+    { "-rewind-buffer-size",    "RewindBufferSize"        },
+    { "-rewind-interval",       "RewindInterval"          },
+    { "-run-ahead",             "RunAhead"                },
     { "-crosshairs",            "Crosshairs"              },
     { "-crosshair-style",       "CrosshairStyle"          },
     { "-vert-shader",           "VertexShader"            },
@@ -1973,16 +2327,33 @@ static ParsedCommandLine ParseCommandLine(int argc, char **argv)
     { "-channels", 	            "NbSoundChannels"         },
     { "-soundfreq",             "SoundFreq"               },
     { "-input-system",          "InputSystem"             },
+    { "-input-poll-rate",       "InputPollRate"           },
     { "-outputs",               "Outputs"                 },
+    { "-net-delta-keyframe",    "NetDeltaKeyframe"        },
+    { "-telemetry-output",      "TelemetryOutput"         },
+    { "-telemetry-format",      "TelemetryFormat"         },
+    { "-telemetry-max-file-size", "TelemetryMaxFileSize"  },
+#ifdef SUPERMODEL_PROFILER
+    { "-profile-interval",      "ProfileInterval"         },
+#endif
     { "-log-output",            "LogOutput"               },
     { "-log-level",             "LogLevel"                }
   };
   static const std::map<std::string, std::pair<std::string, bool>> bool_options
   { // -option
+#ifdef SUPERMODEL_PROFILER
+    { "-profile-ppc",         { "ProfilePPC",       true } },
+#endif
+    { "-log-async",           { "LogAsync",         true } },
+    { "-no-log-async",        { "LogAsync",         false } },
     { "-threads",             { "MultiThreaded",    true } },
     { "-no-threads",          { "MultiThreaded",    false } },
     { "-gpu-multi-threaded",  { "GPUMultiThreaded", true } },
     { "-no-gpu-thread",       { "GPUMultiThreaded", false } },
+    { "-rom-cache",           { "ROMCache",         true } },
+    { "-no-rom-cache",        { "ROMCache",         false } },
+    { "-rewind",              { "Rewind",           true } },
+    { "-no-rewind",           { "Rewind",           false } },
     { "-window",              { "FullScreen",       false } },
     { "-fullscreen",          { "FullScreen",       true } },
     { "-borderless",          { "BorderlessWindow", true } },
@@ -1998,12 +2369,21 @@ static ParsedCommandLine ParseCommandLine(int argc, char **argv)
 #endif
     { "-throttle",            { "Throttle",         true } },
     { "-no-throttle",         { "Throttle",         false } },
+    { "-fast-forward",        { "FastForward",      true } },
+    { "-fast-forward-sync-video", { "FastForwardSyncVideo", true } },
     { "-vsync",               { "VSync",            true } },
     { "-no-vsync",            { "VSync",            false } },
     { "-show-fps",            { "ShowFrameRate",    true } },
+    { "-perf-overlay",        { "PerformanceOverlay", true } },
     { "-no-fps",              { "ShowFrameRate",    false } },
     { "-new3d",               { "New3DEngine",      true } },
     { "-quad-rendering",      { "QuadRendering",    true } },
+    { "-indirect-draw",       { "IndirectDraw",     true } },
+    { "-no-indirect-draw",    { "IndirectDraw",     false } },
+    { "-model-cache",         { "ModelCache",       true } },
+    { "-no-model-cache",      { "ModelCache",       false } },
+    { "-shader-cache",        { "ShaderCache",      true } },
+    { "-no-shader-cache",     { "ShaderCache",      false } },
 #ifndef SUPERMODEL_OSX
     { "-legacy3d",            { "New3DEngine",      false } },
 #endif
@@ -2021,6 +2401,8 @@ static ParsedCommandLine ParseCommandLine(int argc, char **argv)
     { "-no-net",              { "Network",          false } },
     { "-simulate-netboard",   { "SimulateNet",      true } },
     { "-emulate-netboard",    { "SimulateNet",      false } },
+    { "-net-delta",           { "NetDelta",         true } },
+    { "-no-net-delta",        { "NetDelta",         false } },
     { "-no-force-feedback",   { "ForceFeedback",    false } },
     { "-force-feedback",      { "ForceFeedback",    true } },
     { "-dump-memory",         { "DumpMemory",       true } },
@@ -2193,6 +2575,57 @@ static ParsedCommandLine ParseCommandLine(int argc, char **argv)
         cmd_line.config.Set("RefreshRate", 57.524f);
       else if (arg == "-print-gl-info")
         cmd_line.print_gl_info = true;
+      else if (arg == "-net-harness" || arg.find("-net-harness=") == 0)
+      {
+        std::vector<std::string> parts = Util::Format(arg).Split('=');
+        int machines = 0;
+        try
+        {
+          if (parts.size() == 2)
+            machines = std::stoi(parts[1]);
+        }
+        catch (...)
+        {
+        }
+        if (machines < 1 || machines > 8)
+        {
+          ErrorLog("'-net-harness' requires the number of machines, 1 to 8 (e.g., '-net-harness=4').");
+          cmd_line.error = true;
+        }
+        else
+          cmd_line.net_harness = unsigned(machines);
+      }
+      else if (arg == "-net-harness-frames" || arg.find("-net-harness-frames=") == 0)
+      {
+        std::vector<std::string> parts = Util::Format(arg).Split('=');
+        int frames = 0;
+        try
+        {
+          if (parts.size() == 2)
+            frames = std::stoi(parts[1]);
+        }
+        catch (...)
+        {
+        }
+        if (frames < 1)
+        {
+          ErrorLog("'-net-harness-frames' requires a number of frames (e.g., '-net-harness-frames=3600').");
+          cmd_line.error = true;
+        }
+        else
+          cmd_line.net_harness_frames = unsigned(frames);
+      }
+      else if (arg == "-net-harness-game" || arg.find("-net-harness-game=") == 0)
+      {
+        std::vector<std::string> parts = Util::Format(arg).Split('=');
+        if (parts.size() != 2)
+        {
+          ErrorLog("'-net-harness-game' requires a game name (e.g., '-net-harness-game=daytona2').");
+          cmd_line.error = true;
+        }
+        else
+          cmd_line.net_harness_game = parts[1];
+      }
       else if (arg == "-config-inputs")
         cmd_line.config_inputs = true;
       else if (arg == "-print-inputs")
@@ -2299,6 +2732,12 @@ int main(int argc, char **argv)
     PrintGLInfo(true, false, false);
     return 0;
   }
+  if (cmd_line.net_harness)
+  {
+    // Only needs the network settings, no ROMs or video
+    Util::Config::MergeINISections(&s_runtime_config, DefaultConfig(), cmd_line.config);
+    return RunNetLinkHarness(s_runtime_config, cmd_line.net_harness_game, cmd_line.net_harness, cmd_line.net_harness_frames) ? 0 : 1;
+  }
 
 #ifdef DEBUG
   s_gfxStatePath.assign(cmd_line.gfx_state);
@@ -2326,13 +2765,24 @@ int main(int argc, char **argv)
     if (rom_specified || print_games)
     {
       std::string xml_file = config3["GameXMLFile"].ValueAs<std::string>();
-      GameLoader loader(xml_file);
+      GameLoader loader(xml_file, s_gameDefinitionCachePath);
       if (print_games)
       {
         PrintGameList(xml_file, loader.GetGames());
         return 0;
       }
-      if (loader.Load(&game, &rom_set, *cmd_line.rom_files.begin()))
+      GameLoader::SkipROMs_t skip_roms;
+      if (config3["ROMCache"].ValueAs<bool>())
+      {
+        // A valid pre-assembled image makes inflating the zip unnecessary
+        skip_roms = [](const Game &game, ROMSet *rom_set)
+        {
+          std::string image_file = Util::Format() << FileSystemPath::GetPath(FileSystemPath::Cache) << game.name << ".rom";
+          rom_set->image_cache = std::make_shared<ROMImageCache>(image_file, rom_set->fingerprint);
+          return rom_set->image_cache->Open() == Result::OKAY;
+        };
+      }
+      if (loader.Load(&game, &rom_set, *cmd_line.rom_files.begin(), skip_roms))
         return 1;
       Util::Config::MergeINISections(&config4, config3, fileConfig[game.name]);   // apply game-specific config
     }
@@ -2375,6 +2825,10 @@ int main(int argc, char **argv)
     goto Exit;
   }
 
+  // Cache linked shader programs, must be done before anything compiles a shader
+  if (s_runtime_config["ShaderCache"].ValueAs<bool>())
+    SetShaderCacheDirectory(FileSystemPath::GetPath(FileSystemPath::Cache));
+
   // Create Crosshair
   s_crosshair = new CCrosshair(s_runtime_config);
   if (s_crosshair->Init() != Result::OKAY)
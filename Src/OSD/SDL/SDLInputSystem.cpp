@@ -733,6 +733,42 @@ bool CSDLInputSystem::Poll()
   return true;
 }
 
+bool CSDLInputSystem::PollDevices()
+{
+  // Joysticks can be updated on their own; keyboard and mouse state only changes when events are processed in Poll().
+  // SDL locks joystick state, so the emulator thread can read it meanwhile
+  if (m_joysticks.empty() && m_gamepads.empty())
+    return false;
+  SDL_JoystickUpdate();
+  return true;
+}
+
+void CSDLInputSystem::ReadSwitchParts(const SwitchPart *parts, size_t count, UINT8 *states) const
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    const SwitchPart &part = parts[i];
+    switch (part.kind)
+    {
+    case SwitchPart::Key:         states[i] = !!m_keyState[s_keyMap[part.partNum].sdlKey]; break;
+    case SwitchPart::MouseButton: states[i] = CSDLInputSystem::IsMouseButPressed(part.devNum, part.partNum); break;
+    case SwitchPart::JoyButton:   states[i] = CSDLInputSystem::IsJoyButPressed(part.devNum, part.partNum); break;
+    case SwitchPart::JoyPOV:      states[i] = CSDLInputSystem::IsJoyPOVInDir(part.devNum, part.partNum, part.povDir); break;
+    }
+  }
+}
+
+void CSDLInputSystem::LockDevices()
+{
+  // Keeps PollDevices() from updating joysticks part way through; keyboard and mouse only change in Poll()
+  SDL_LockJoysticks();
+}
+
+void CSDLInputSystem::UnlockDevices()
+{
+  SDL_UnlockJoysticks();
+}
+
 void CSDLInputSystem::SetMouseVisibility(bool visible)
 {
   SDL_ShowCursor(visible ? SDL_ENABLE : SDL_DISABLE);
@@ -170,6 +170,14 @@ public:
 
 	bool Poll();
 
+	bool PollDevices();
+
+	void ReadSwitchParts(const SwitchPart *parts, size_t count, UINT8 *states) const;
+
+	void LockDevices();
+
+	void UnlockDevices();
+
 	void SetMouseVisibility(bool visible);
 };
 
@@ -0,0 +1,292 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "Telemetry.h"
+#include "OSD/Logger.h"
+#include "Util/Format.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Lines waiting for a slow socket reader beyond this are dropped
+static const size_t MAX_PENDING_SOCKET_DATA = 64 * 1024;
+
+// Samples (frames) between attempts to connect the socket
+static const unsigned RECONNECT_DELAY = 60;
+
+void CTelemetry::AddSample(const Sample &sample)
+{
+  if (m_history.size() < HISTORY_SIZE)
+    m_history.push_back(sample);
+  else
+    m_history[m_nextSample] = sample;
+  m_nextSample = (m_nextSample + 1) % HISTORY_SIZE;
+  m_sortedValid = false;
+
+  if (m_fp || !m_socketPath.empty())
+    Export(sample);
+}
+
+size_t CTelemetry::GetNumSamples() const
+{
+  return m_history.size();
+}
+
+const CTelemetry::Sample &CTelemetry::GetSample(size_t i) const
+{
+  if (m_history.size() < HISTORY_SIZE)
+    return m_history[i];
+  return m_history[(m_nextSample + i) % HISTORY_SIZE];
+}
+
+float CTelemetry::GetFrameMsPercentile(float percentile) const
+{
+  if (m_history.empty())
+    return 0.0f;
+  if (!m_sortedValid)
+  {
+    m_sortedFrameMs.clear();
+    for (auto &sample: m_history)
+      m_sortedFrameMs.push_back(sample.frameMs);
+    std::sort(m_sortedFrameMs.begin(), m_sortedFrameMs.end());
+    m_sortedValid = true;
+  }
+  size_t i = size_t(percentile * 0.01f * float(m_sortedFrameMs.size() - 1) + 0.5f);
+  return m_sortedFrameMs[std::min(i, m_sortedFrameMs.size() - 1)];
+}
+
+const char *CTelemetry::GetHeader() const
+{
+  if (m_format == Format::CSV)
+    return "frame,ppc_ms,snd_ms,drv_ms,net_ms,sync_ms,render_ms,emu_frame_ms,sync_bytes,upload_us,audio_underruns,frame_ms,target_ms,"
+      "net_tx_bytes,net_rx_bytes,net_tx_msgs,net_rx_msgs,net_saved_bytes,net_latency_us,input_us\n";
+  return nullptr;
+}
+
+void CTelemetry::Export(const Sample &sample)
+{
+  const FrameTimings &t = sample.timings;
+  const NetLinkStats &n = sample.net;
+  char line[768];
+  int length;
+  if (m_format == Format::CSV)
+  {
+    length = snprintf(line, sizeof(line), "%llu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.3f,%.3f,%llu,%llu,%llu,%llu,%llu,%u,%u\n",
+      (unsigned long long) t.frameId, t.ppcTicks, t.sndTicks, t.drvTicks, t.netTicks, t.syncTicks, t.renderTicks, t.frameTicks,
+      t.syncSize, t.uploadMicros, sample.audioUnderRuns, sample.frameMs, sample.targetMs,
+      (unsigned long long) n.bytesSent, (unsigned long long) n.bytesReceived, (unsigned long long) n.messagesSent,
+      (unsigned long long) n.messagesReceived, (unsigned long long) n.bytesSaved, n.latencyMicros, sample.inputMicros);
+  }
+  else
+  {
+    length = snprintf(line, sizeof(line),
+      "{\"frame\":%llu,\"ppc_ms\":%u,\"snd_ms\":%u,\"drv_ms\":%u,\"net_ms\":%u,\"sync_ms\":%u,\"render_ms\":%u,\"emu_frame_ms\":%u,"
+      "\"sync_bytes\":%u,\"upload_us\":%u,\"audio_underruns\":%u,\"frame_ms\":%.3f,\"target_ms\":%.3f,"
+      "\"net_tx_bytes\":%llu,\"net_rx_bytes\":%llu,\"net_tx_msgs\":%llu,\"net_rx_msgs\":%llu,\"net_saved_bytes\":%llu,\"net_latency_us\":%u,\"input_us\":%u}\n",
+      (unsigned long long) t.frameId, t.ppcTicks, t.sndTicks, t.drvTicks, t.netTicks, t.syncTicks, t.renderTicks, t.frameTicks,
+      t.syncSize, t.uploadMicros, sample.audioUnderRuns, sample.frameMs, sample.targetMs,
+      (unsigned long long) n.bytesSent, (unsigned long long) n.bytesReceived, (unsigned long long) n.messagesSent,
+      (unsigned long long) n.messagesReceived, (unsigned long long) n.bytesSaved, n.latencyMicros, sample.inputMicros);
+  }
+  if (length <= 0)
+    return;
+  length = std::min(length, int(sizeof(line)) - 1);
+
+  if (m_fp)
+    WriteToFile(line, size_t(length));
+  else
+    WriteToSocket(line, size_t(length));
+}
+
+void CTelemetry::WriteToFile(const char *line, size_t length)
+{
+  // Rotate: the full file is kept with ".1" appended, replacing the previous one
+  if (m_maxFileSize && m_fileSize + length > m_maxFileSize)
+  {
+    fclose(m_fp);
+    m_fp = nullptr;
+    std::string previous = m_filename + ".1";
+    remove(previous.c_str());
+    rename(m_filename.c_str(), previous.c_str());
+    OpenFile();
+    if (!m_fp)
+      return;
+  }
+  fwrite(line, 1, length, m_fp);
+  m_fileSize += length;
+}
+
+void CTelemetry::OpenFile()
+{
+  m_fp = fopen(m_filename.c_str(), "w");
+  m_fileSize = 0;
+  if (!m_fp)
+  {
+    ErrorLog("Unable to open telemetry output file '%s'.", m_filename.c_str());
+    return;
+  }
+  const char *header = GetHeader();
+  if (header)
+  {
+    fputs(header, m_fp);
+    m_fileSize += strlen(header);
+  }
+}
+
+#ifdef _WIN32
+
+void CTelemetry::WriteToSocket(const char *, size_t)
+{
+}
+
+void CTelemetry::Connect()
+{
+}
+
+void CTelemetry::Disconnect()
+{
+}
+
+#else
+
+void CTelemetry::WriteToSocket(const char *line, size_t length)
+{
+  if (m_socket < 0)
+  {
+    if (m_reconnectDelay > 0)
+    {
+      m_reconnectDelay--;
+      return;
+    }
+    Connect();
+    if (m_socket < 0)
+      return;
+  }
+
+  // Whole lines are dropped rather than blocking emulation on a slow reader
+  if (m_pending.size() + length <= MAX_PENDING_SOCKET_DATA)
+    m_pending.append(line, length);
+
+  while (!m_pending.empty())
+  {
+#ifdef MSG_NOSIGNAL
+    ssize_t sent = send(m_socket, m_pending.data(), m_pending.size(), MSG_NOSIGNAL);
+#else
+    ssize_t sent = send(m_socket, m_pending.data(), m_pending.size(), 0);
+#endif
+    if (sent > 0)
+    {
+      m_pending.erase(0, size_t(sent));
+      continue;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+      break;
+    InfoLog("Telemetry socket '%s' disconnected.", m_socketPath.c_str());
+    Disconnect();
+    break;
+  }
+}
+
+void CTelemetry::Connect()
+{
+  m_reconnectDelay = RECONNECT_DELAY;
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  if (m_socketPath.size() >= sizeof(addr.sun_path))
+    return;
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, m_socketPath.c_str(), m_socketPath.size());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return;
+#ifdef SO_NOSIGPIPE
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+  if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+  {
+    close(fd);
+    return;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  m_socket = fd;
+  InfoLog("Telemetry connected to '%s'.", m_socketPath.c_str());
+
+  const char *header = GetHeader();
+  m_pending = header ? header : "";
+}
+
+void CTelemetry::Disconnect()
+{
+  if (m_socket >= 0)
+    close(m_socket);
+  m_socket = -1;
+  m_pending.clear();
+  m_reconnectDelay = RECONNECT_DELAY;
+}
+
+#endif
+
+CTelemetry::CTelemetry(const Util::Config::Node &config)
+{
+  m_history.reserve(HISTORY_SIZE);
+
+  std::string format = Util::ToLower(config["TelemetryFormat"].ValueAsDefault<std::string>("csv"));
+  if (format == "json")
+    m_format = Format::JSON;
+  else if (format != "csv")
+    ErrorLog("Invalid telemetry format '%s'. Using CSV.", format.c_str());
+
+  std::string output = config["TelemetryOutput"].ValueAsDefault<std::string>(std::string());
+  if (output.empty())
+    return;
+  if (output.compare(0, 5, "unix:") == 0)
+  {
+#ifdef _WIN32
+    ErrorLog("Telemetry output to a UNIX domain socket is not supported on this platform.");
+#else
+    m_socketPath = output.substr(5);
+    Connect();
+    if (m_socket < 0)
+      InfoLog("Telemetry socket '%s' is not accepting connections yet.", m_socketPath.c_str());
+#endif
+  }
+  else
+  {
+    m_filename = output;
+    m_maxFileSize = uint64_t(config["TelemetryMaxFileSize"].ValueAsDefault<unsigned>(16)) << 20;
+    OpenFile();
+  }
+}
+
+CTelemetry::~CTelemetry()
+{
+  if (m_fp)
+    fclose(m_fp);
+  Disconnect();
+}
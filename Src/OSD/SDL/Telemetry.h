@@ -0,0 +1,100 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef INCLUDED_TELEMETRY_H
+#define INCLUDED_TELEMETRY_H
+
+#include "Model3/Model3.h"
+#include "Util/NewConfig.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * CTelemetry:
+ *
+ * Per-frame performance samples: the emulator's frame timings, audio buffer
+ * under-runs, net link traffic, input polling time, and the actual versus
+ * target frame time. The most recent samples are kept for the performance
+ * overlay. If an output is configured,
+ * every sample is also exported as one line of CSV or JSON to a file (rotated
+ * when it reaches a size limit) or, on POSIX systems, to a UNIX domain socket
+ * given as "unix:<path>".
+ */
+class CTelemetry
+{
+public:
+  struct Sample
+  {
+    FrameTimings timings;
+    unsigned audioUnderRuns;  // total so far
+    float frameMs;            // actual time since the previous frame
+    float targetMs;           // frame time at the configured refresh rate
+    NetLinkStats net;         // totals so far, all zero without a running net board
+    unsigned inputMicros;     // time spent polling inputs
+  };
+
+  static const size_t HISTORY_SIZE = 600;
+
+  void AddSample(const Sample &sample);
+
+  // Recent samples, oldest first
+  size_t GetNumSamples() const;
+  const Sample &GetSample(size_t i) const;
+
+  // Actual frame time at the given percentile (0-100) of the recent samples
+  float GetFrameMsPercentile(float percentile) const;
+
+  CTelemetry(const Util::Config::Node &config);
+  ~CTelemetry();
+
+private:
+  enum class Format
+  {
+    CSV,
+    JSON
+  };
+
+  std::vector<Sample> m_history;  // circular
+  size_t m_nextSample = 0;
+  mutable std::vector<float> m_sortedFrameMs;
+  mutable bool m_sortedValid = false;
+
+  Format m_format = Format::CSV;
+  std::string m_filename;
+  uint64_t m_maxFileSize = 0;
+  uint64_t m_fileSize = 0;
+  FILE *m_fp = nullptr;
+  std::string m_socketPath;
+  int m_socket = -1;
+  std::string m_pending;          // lines not yet accepted by the socket
+  unsigned m_reconnectDelay = 0;  // samples to wait before connecting again
+
+  void Export(const Sample &sample);
+  void WriteToFile(const char *line, size_t length);
+  void WriteToSocket(const char *line, size_t length);
+  void OpenFile();
+  void Connect();
+  void Disconnect();
+  const char *GetHeader() const;
+};
+
+#endif  // INCLUDED_TELEMETRY_H
@@ -154,6 +154,11 @@ bool CCondVar::Wait(CMutex *mutex)
 	return SDL_CondWait((SDL_cond*)m_impl, (SDL_mutex*)mutex->m_impl) == 0;
 }
 
+bool CCondVar::Wait(CMutex *mutex, UINT32 timeoutMS)
+{
+	return SDL_CondWaitTimeout((SDL_cond*)m_impl, (SDL_mutex*)mutex->m_impl, timeoutMS) >= 0;
+}
+
 bool CCondVar::Signal()
 {
 	return SDL_CondSignal((SDL_cond*)m_impl) == 0;
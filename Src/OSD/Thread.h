@@ -191,6 +191,13 @@ public:
 	 */
 	bool Wait(CMutex *mutex);
 
+	/*
+	 * Wait
+	 *
+	 * As above but gives up waiting after the given number of milliseconds. Returns true if signalled or timed out.
+	 */
+	bool Wait(CMutex *mutex, UINT32 timeoutMS);
+
 	/*
 	 * Signal
 	 *
@@ -79,6 +79,9 @@ namespace FileSystemPath
         case Assets:
             strPathType = "Assets";
             break;
+        case Cache:
+            strPathType = "Cache";
+            break;
         }
 
         // Get user's HOME directory
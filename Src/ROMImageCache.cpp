@@ -0,0 +1,163 @@
+#include "ROMImageCache.h"
+#include "OSD/Logger.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+// Bump whenever the layout of the assembled images changes
+static const uint32_t ROM_IMAGE_CACHE_VERSION = 1;
+
+static const char ROM_IMAGE_CACHE_MAGIC[8] = { 'S','M','R','O','M','I','M','G' };
+
+// Section data is page aligned (64KB covers the Windows allocation
+// granularity and every common page size)
+static const uint64_t SECTION_ALIGNMENT = 0x10000;
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t num_sections;
+  uint64_t fingerprint;
+};
+
+static uint64_t AlignSection(uint64_t offset)
+{
+  return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+ROMImageCache::ROMImageCache(const std::string &filename, uint64_t fingerprint)
+  : m_filename(filename),
+    m_fingerprint(fingerprint)
+{
+}
+
+Result ROMImageCache::Open()
+{
+  if (IsOpen())
+    return Result::OKAY;
+
+  if (!m_file.Open(m_filename))
+    return Result::FAIL;
+
+  uint64_t file_size = m_file.Size();
+  FileHeader header;
+  bool ok = file_size >= sizeof(header);
+  if (ok)
+  {
+    memcpy(&header, m_file.Data(), sizeof(header));
+    ok = memcmp(header.magic, ROM_IMAGE_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+      header.version == ROM_IMAGE_CACHE_VERSION &&
+      header.fingerprint == m_fingerprint &&
+      header.num_sections <= 64 &&
+      file_size - sizeof(header) >= header.num_sections * sizeof(SectionEntry);
+  }
+
+  std::vector<SectionEntry> sections;
+  if (ok)
+  {
+    sections.resize(header.num_sections);
+    if (!sections.empty())
+      memcpy(sections.data(), m_file.Data() + sizeof(header), sections.size() * sizeof(SectionEntry));
+  }
+
+  for (size_t i = 0; ok && i < sections.size(); i++)
+  {
+    const SectionEntry &section = sections[i];
+    ok = section.name[sizeof(section.name) - 1] == '\0' &&
+      section.offset % SECTION_ALIGNMENT == 0 &&
+      section.offset <= file_size &&
+      section.size <= file_size - section.offset;
+  }
+
+  if (!ok)
+  {
+    m_file.Close();
+    InfoLog("Ignoring stale or damaged ROM image cache '%s'.", m_filename.c_str());
+    return Result::FAIL;
+  }
+
+  m_sections = std::move(sections);
+  return Result::OKAY;
+}
+
+Result ROMImageCache::LoadSection(uint8_t *dest, size_t dest_size, size_t *rom_size, const std::string &name) const
+{
+  *rom_size = 0;
+  if (!IsOpen())
+    return Result::FAIL;
+
+  auto it = std::find_if(m_sections.begin(), m_sections.end(),
+    [&name](const SectionEntry &section) { return name == section.name; });
+  if (it == m_sections.end())
+    return Result::OKAY;
+  if (it->size != dest_size)
+    return ErrorLog("ROM image cache '%s' has wrong size for '%s'.", m_filename.c_str(), name.c_str());
+
+  *rom_size = size_t(it->rom_size);
+  memcpy(dest, m_file.Data() + it->offset, dest_size);
+  return Result::OKAY;
+}
+
+Result ROMImageCache::Save(const std::vector<Section> &sections) const
+{
+  FileHeader header;
+  memcpy(header.magic, ROM_IMAGE_CACHE_MAGIC, sizeof(header.magic));
+  header.version = ROM_IMAGE_CACHE_VERSION;
+  header.num_sections = 0;
+  header.fingerprint = m_fingerprint;
+
+  // Absent regions are left out entirely and stay zero-filled on load
+  std::vector<SectionEntry> entries;
+  std::vector<const uint8_t *> data;
+  for (auto &section: sections)
+  {
+    if (!section.rom_size)
+      continue;
+    SectionEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.name, section.name.c_str(), sizeof(entry.name) - 1);
+    entry.size = section.size;
+    entry.rom_size = section.rom_size;
+    entries.push_back(entry);
+    data.push_back(section.data);
+  }
+  header.num_sections = uint32_t(entries.size());
+
+  uint64_t offset = AlignSection(sizeof(header) + entries.size() * sizeof(SectionEntry));
+  for (auto &entry: entries)
+  {
+    entry.offset = offset;
+    offset = AlignSection(offset + entry.size);
+  }
+
+  // Write to a temporary file and rename it, so that a failed write leaves no
+  // truncated image and running instances keep their mapping of the old one
+  std::string temp_filename = m_filename + ".tmp";
+  FILE *fp = fopen(temp_filename.c_str(), "wb");
+  if (!fp)
+    return ErrorLog("Unable to create ROM image cache '%s'.", temp_filename.c_str());
+
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+    (entries.empty() || fwrite(entries.data(), sizeof(SectionEntry), entries.size(), fp) == entries.size());
+  for (size_t i = 0; ok && i < entries.size(); i++)
+  {
+    ok = fseek(fp, long(entries[i].offset), SEEK_SET) == 0 &&
+      fwrite(data[i], size_t(entries[i].size), 1, fp) == 1;
+  }
+  ok = (fclose(fp) == 0) && ok;
+
+  if (ok)
+  {
+    remove(m_filename.c_str()); // rename won't replace an existing file on Windows
+    ok = rename(temp_filename.c_str(), m_filename.c_str()) == 0;
+  }
+  if (!ok)
+  {
+    remove(temp_filename.c_str());
+    return ErrorLog("Unable to write ROM image cache '%s'.", m_filename.c_str());
+  }
+
+  InfoLog("Wrote ROM image cache '%s'.", m_filename.c_str());
+  return Result::OKAY;
+}
@@ -0,0 +1,61 @@
+#ifndef INCLUDED_ROMIMAGECACHE_H
+#define INCLUDED_ROMIMAGECACHE_H
+
+#include "Types.h"
+#include "Util/MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Pre-assembled memory images of a ROM set: the final, mirrored and byte
+ * swapped contents of each emulated ROM region, one file per game. The file is
+ * tied to the exact contents of the ROM set by a fingerprint computed from the
+ * zip directory (file CRCs and sizes, see GameLoader), so a cached image is used
+ * without inflating or checking any ROM data. The file is opened as a
+ * Util::MappedFile and sections are copied straight out of it.
+ */
+class ROMImageCache
+{
+public:
+  // One emulated ROM region as it appears in memory
+  struct Section
+  {
+    std::string name;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    size_t rom_size = 0;  // size of the ROM region it was built from, 0 if the game has none
+  };
+
+  ROMImageCache(const std::string &filename, uint64_t fingerprint);
+
+  // Succeeds if the file exists and was built from the same ROM set
+  Result Open();
+  bool IsOpen() const
+  {
+    return m_file.Data() != nullptr;
+  }
+
+  // Copies a section to dest, which must be dest_size bytes (the section size).
+  // Absent sections are skipped with *rom_size = 0.
+  Result LoadSection(uint8_t *dest, size_t dest_size, size_t *rom_size, const std::string &name) const;
+
+  // Writes a new image, replacing any existing one
+  Result Save(const std::vector<Section> &sections) const;
+
+private:
+  struct SectionEntry
+  {
+    char name[24];
+    uint64_t offset;
+    uint64_t size;
+    uint64_t rom_size;
+  };
+
+  std::string m_filename;
+  uint64_t m_fingerprint;
+  Util::MappedFile m_file;
+  std::vector<SectionEntry> m_sections;
+};
+
+#endif  // INCLUDED_ROMIMAGECACHE_H
@@ -7,6 +7,8 @@
 #include <vector>
 #include <cstdint>
 
+class ROMImageCache;
+
 // Holds a single ROM region
 struct ROM
 {
@@ -33,6 +35,8 @@ struct ROM
 struct ROMSet
 {
   std::map<std::string, ROM> rom_by_region;
+  uint64_t fingerprint = 0;                   // identifies the exact ROM files the set is made of
+  std::shared_ptr<ROMImageCache> image_cache; // pre-assembled images, if enabled (regions left empty when valid)
   
   ROM get_rom(const std::string &region) const;
 };
@@ -0,0 +1,234 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "RewindBuffer.h"
+#include "Model3/IEmulator.h"
+#include "Util/DirtyPageMap.h"
+#include "OSD/Logger.h"
+#include <algorithm>
+#include <cstring>
+
+static const char REWIND_STATE_HEADER[] = "Supermodel Rewind State";
+
+static inline uint64_t Load64(const uint8_t *p)
+{
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static void AppendVarint(std::vector<uint8_t> *out, size_t value)
+{
+  while (value >= 0x80)
+  {
+    out->push_back(uint8_t(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(uint8_t(value));
+}
+
+static size_t ReadVarint(const uint8_t **p, const uint8_t *end)
+{
+  size_t value = 0;
+  for (unsigned shift = 0; *p < end; shift += 7)
+  {
+    uint8_t byte = *(*p)++;
+    value |= size_t(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      break;
+  }
+  return value;
+}
+
+/*
+ * Delta format: a sequence of runs, each a varint count of unchanged bytes
+ * since the end of the previous run, a varint run length and that many bytes
+ * of XOR. Applying a delta twice undoes it.
+ */
+static void EncodeRange(std::vector<uint8_t> *out, const uint8_t *a, const uint8_t *b, size_t begin, size_t end, size_t *last)
+{
+  size_t i = begin;
+  while (i < end)
+  {
+    // Skip identical data a word at a time
+    while (i + 8 <= end && Load64(a + i) == Load64(b + i))
+      i += 8;
+    while (i < end && a[i] == b[i])
+      i++;
+    if (i >= end)
+      break;
+
+    // Extend the run up to the next identical word
+    size_t start = i;
+    while (i + 8 <= end && Load64(a + i) != Load64(b + i))
+      i += 8;
+    if (i + 8 > end)
+    {
+      while (i < end && a[i] != b[i])
+        i++;
+    }
+
+    AppendVarint(out, start - *last);
+    AppendVarint(out, i - start);
+    for (size_t j = start; j < i; j++)
+      out->push_back(a[j] ^ b[j]);
+    *last = i;
+  }
+}
+
+static void ApplyDelta(std::vector<uint8_t> *buffer, const std::vector<uint8_t> &delta)
+{
+  const uint8_t *p = delta.data();
+  const uint8_t *end = p + delta.size();
+  size_t pos = 0;
+  while (p < end)
+  {
+    pos += ReadVarint(&p, end);
+    size_t length = ReadVarint(&p, end);
+    length = std::min({ length, size_t(end - p), buffer->size() - std::min(pos, buffer->size()) });
+    uint8_t *dest = buffer->data() + pos;
+    for (size_t i = 0; i < length; i++)
+      dest[i] ^= p[i];
+    p += length;
+    pos += length;
+  }
+}
+
+static bool SameLayout(const std::vector<CBlockFile::TrackedRegion> &a, const std::vector<CBlockFile::TrackedRegion> &b)
+{
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+    [](const CBlockFile::TrackedRegion &x, const CBlockFile::TrackedRegion &y)
+    {
+      return x.offset == y.offset && x.size == y.size && x.dirty == y.dirty;
+    });
+}
+
+RewindBuffer::RewindBuffer(size_t max_history_bytes, unsigned interval)
+  : m_max_history_bytes(max_history_bytes),
+    m_interval(std::max(1u, interval))
+{
+}
+
+bool RewindBuffer::FrameEnded()
+{
+  m_at_snapshot = false;
+  return ++m_frames >= m_interval;
+}
+
+void RewindBuffer::Capture(IEmulator *emulator)
+{
+  m_frames = 0;
+
+  CBlockFile state;
+  state.CreateInMemory(REWIND_STATE_HEADER, "", std::move(m_spare));
+  emulator->SaveState(&state);
+  std::vector<CBlockFile::TrackedRegion> regions = state.GetTrackedRegions();
+  std::vector<uint8_t> snapshot = state.TakeBuffer();
+
+  if (m_current.size() != snapshot.size())
+  {
+    // Layout changed (or first snapshot): history can't be chained onto it
+    m_deltas.clear();
+    m_history_bytes = 0;
+  }
+  else
+  {
+    // Tracked pages that weren't written since the last snapshot are known
+    // to be identical and are skipped
+    const std::vector<CBlockFile::TrackedRegion> no_regions;
+    auto &skip_regions = SameLayout(regions, m_regions) ? regions : no_regions;
+    const uint8_t *a = m_current.data();
+    const uint8_t *b = snapshot.data();
+    size_t pos = 0;
+    size_t last = 0;
+    m_delta_scratch.clear();
+    for (auto &region: skip_regions)
+    {
+      EncodeRange(&m_delta_scratch, a, b, pos, region.offset, &last);
+      for (size_t page = 0; page < region.dirty->NumPages(); page++)
+      {
+        if (!region.dirty->IsDirty(page))
+          continue;
+        size_t begin = region.offset + page * Util::DirtyPageMap::PageSize;
+        size_t end = std::min(begin + Util::DirtyPageMap::PageSize, region.offset + region.size);
+        EncodeRange(&m_delta_scratch, a, b, begin, end, &last);
+      }
+      pos = region.offset + region.size;
+    }
+    EncodeRange(&m_delta_scratch, a, b, pos, snapshot.size(), &last);
+
+    m_deltas.emplace_back(m_delta_scratch.begin(), m_delta_scratch.end());
+    m_history_bytes += m_deltas.back().size();
+    while (m_history_bytes > m_max_history_bytes && !m_deltas.empty())
+    {
+      m_history_bytes -= m_deltas.front().size();
+      m_deltas.pop_front();
+    }
+  }
+
+  // Changes are tracked relative to this snapshot from now on
+  for (auto &region: regions)
+    region.dirty->Clear();
+  m_regions = std::move(regions);
+  m_spare = std::move(m_current);
+  m_current = std::move(snapshot);
+  m_at_snapshot = true;
+}
+
+bool RewindBuffer::StepBack(IEmulator *emulator)
+{
+  if (m_current.empty())
+    return false;
+
+  // The first step goes back to the latest snapshot, later ones beyond it
+  if (m_at_snapshot)
+  {
+    if (m_deltas.empty())
+      return false;
+    ApplyDelta(&m_current, m_deltas.back());
+    m_history_bytes -= m_deltas.back().size();
+    m_deltas.pop_back();
+  }
+
+  CBlockFile state;
+  state.LoadFromMemory(std::move(m_current));
+  if (Result::OKAY != state.FindBlock(REWIND_STATE_HEADER))
+  {
+    ErrorLog("Rewind state is corrupt.");
+    Clear();
+    return false;
+  }
+  emulator->LoadState(&state, true);
+  m_current = state.TakeBuffer();
+  m_frames = 0;
+  m_at_snapshot = true;
+  return true;
+}
+
+void RewindBuffer::Clear()
+{
+  m_current.clear();
+  m_regions.clear();
+  m_deltas.clear();
+  m_history_bytes = 0;
+  m_frames = 0;
+  m_at_snapshot = false;
+}
@@ -0,0 +1,79 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef INCLUDED_REWINDBUFFER_H
+#define INCLUDED_REWINDBUFFER_H
+
+#include "BlockFile.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class IEmulator;
+
+/*
+ * In-memory history of emulator states for stepping back in time. A snapshot
+ * (an in-memory save state) is taken every few frames. Only the latest one is
+ * kept in full; older ones are stored as XOR deltas against their successor,
+ * with unchanged stretches run-length encoded, so stepping back is a matter of
+ * patching the latest snapshot and loading it.
+ *
+ * Memory regions written with dirty page tracking (see CBlockFile::Write) are
+ * only compared where pages were written since the previous snapshot, which
+ * keeps the cost of a snapshot down to little more than the copy itself.
+ */
+class RewindBuffer
+{
+public:
+  // max_history_bytes bounds the deltas; two full snapshots are kept on top
+  RewindBuffer(size_t max_history_bytes, unsigned interval);
+
+  // Counts an emulated frame. Returns true when a snapshot is due.
+  bool FrameEnded();
+
+  // Takes a snapshot. Emulator threads must be paused.
+  void Capture(IEmulator *emulator);
+
+  // Restores the latest snapshot not yet stepped back over. Emulator threads
+  // must be paused. Returns false if there is no more history.
+  bool StepBack(IEmulator *emulator);
+
+  void Clear();
+
+  size_t NumSnapshots() const
+  {
+    return m_current.empty() ? 0 : m_deltas.size() + 1;
+  }
+
+private:
+  std::vector<uint8_t> m_current;   // latest snapshot
+  std::vector<uint8_t> m_spare;     // storage for the next snapshot
+  std::vector<CBlockFile::TrackedRegion> m_regions; // tracked regions of the latest snapshot
+  std::deque<std::vector<uint8_t>> m_deltas;        // oldest first, each turns a snapshot into its predecessor
+  std::vector<uint8_t> m_delta_scratch;
+  size_t m_history_bytes = 0;
+  size_t m_max_history_bytes;
+  unsigned m_interval;
+  unsigned m_frames = 0;
+  bool m_at_snapshot = false;       // emulator state is the latest snapshot
+};
+
+#endif  // INCLUDED_REWINDBUFFER_H
@@ -0,0 +1,64 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "RunAhead.h"
+#include "BlockFile.h"
+#include "Model3/IEmulator.h"
+#include "OSD/Logger.h"
+
+static const char RUN_AHEAD_STATE_HEADER[] = "Supermodel Run-Ahead State";
+
+RunAhead::RunAhead(unsigned frames)
+  : m_frames(frames)
+{
+}
+
+void RunAhead::RunFrame(IEmulator *emulator)
+{
+  // The real frame is heard but never seen
+  emulator->SetFrameOutput(false, true, false);
+  emulator->RunFrame();
+
+  CBlockFile state;
+  emulator->PauseThreads();
+  state.CreateInMemory(RUN_AHEAD_STATE_HEADER, "", std::move(m_state));
+  emulator->SaveState(&state);
+  m_state = state.TakeBuffer();
+  emulator->ResumeThreads();
+
+  // Speculative frames, showing only the last
+  for (unsigned i = 1; i <= m_frames; i++)
+  {
+    emulator->SetFrameOutput(i == m_frames, false, false);
+    emulator->RunFrame();
+  }
+  emulator->SetFrameOutput(true, true, true);
+
+  // Back to where the real frame left off
+  emulator->PauseThreads();
+  state.LoadFromMemory(std::move(m_state));
+  if (Result::OKAY == state.FindBlock(RUN_AHEAD_STATE_HEADER))
+    emulator->LoadState(&state, true);
+  else
+    ErrorLog("Run-ahead state is corrupt.");
+  m_state = state.TakeBuffer();
+  emulator->ResumeThreads();
+}
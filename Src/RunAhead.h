@@ -0,0 +1,59 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef INCLUDED_RUNAHEAD_H
+#define INCLUDED_RUNAHEAD_H
+
+#include <cstdint>
+#include <vector>
+
+class IEmulator;
+
+/*
+ * Hides input lag by running ahead: after each real frame the emulator state
+ * is saved in memory, a few more frames are run with the current inputs and
+ * the last of them is shown, then the saved state is restored. The real frame
+ * supplies the audio and the speculative ones only the picture, so what is
+ * shown reacts to the inputs that many frames sooner.
+ *
+ * The state is kept in a buffer that is reused from frame to frame, so once
+ * it has grown to the size of a save state no further allocation takes place.
+ */
+class RunAhead
+{
+public:
+  explicit RunAhead(unsigned frames);
+
+  // Runs one real frame followed by the speculative ones. Emulator threads
+  // must be running.
+  void RunFrame(IEmulator *emulator);
+
+  unsigned Frames() const
+  {
+    return m_frames;
+  }
+
+private:
+  unsigned m_frames;
+  std::vector<uint8_t> m_state;     // snapshot after the real frame
+};
+
+#endif  // INCLUDED_RUNAHEAD_H
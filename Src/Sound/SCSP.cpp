@@ -76,7 +76,7 @@ Anyways credit to R. Belmont and ElSemi for the code, and for being awesome emul
 #include <cmath>
 
 
-static const Util::Config::Node *s_config = 0;
+static std::unique_ptr<Util::Config::Handle<float>> s_balance;
 static bool s_multiThreaded = false;
 bool legacySound; // For LegacySound (SCSP DSP) config option.
 
@@ -592,7 +592,7 @@ void SCSP_StopSlot(_SLOT *slot,int keyoff)
 
 Result SCSP_Init(const Util::Config::Node &config, int n)
 {
-	s_config = &config;
+	s_balance = std::make_unique<Util::Config::Handle<float>>(config, "Balance");
 	s_multiThreaded = config["MultiThreaded"].ValueAs<bool>();
 	legacySound = config["LegacySoundDSP"].ValueAs<bool>();
 
@@ -771,6 +771,13 @@ void SCSP_SetRAM(int n,unsigned char *r)
 #endif
 }
 
+void SCSP_SetRAMDirtyMap(int n, Util::DirtyPageMap *dirty)
+{
+#ifdef USEDSP
+	SCSPs[n].DSP.SCSPRAMDirty=dirty;
+#endif
+}
+
 void SCSP_UpdateSlotReg(int s,int r)
 {
 	struct _SLOT *slot = SCSP->Slots + s;
@@ -1511,7 +1518,7 @@ void SCSP_DoMasterSamples(int nsamples)
 	 * When one SCSP is fully attenuated, the other's samples will be multiplied
 	 * by 2.
 	 */
-	float balance = std::max(-100.f,std::min(100.f,s_config->Get("Balance").ValueAs<float>()));
+	float balance = std::max(-100.f,std::min(100.f,s_balance->Value()));
 	balance *= 0.01f;
 	float masterBalance = 1.0f + balance;
 	float slaveBalance = 1.0f - balance;
@@ -2131,4 +2138,5 @@ void SCSP_Deinit(void)
 #endif
 	delete MIDILock;
 	MIDILock = NULL;
+	s_balance.reset();
 }
@@ -31,6 +31,7 @@
 #include "BlockFile.h"
 #include "Types.h"
 #include "Util/NewConfig.h"
+#include "Util/DirtyPageMap.h"
 
 void SCSP_w8(UINT32 addr,UINT8 val);
 void SCSP_w16(UINT32 addr,UINT16 val);
@@ -64,6 +65,14 @@ UINT8 SCSP_MidiOutR();
 Result SCSP_Init(const Util::Config::Node &config, int n);
 
 void SCSP_SetRAM(int n,UINT8 *r);
+
+/*
+ * SCSP_SetRAMDirtyMap(n, dirty):
+ *
+ * Attaches a dirty page map to the RAM of SCSP n, which is marked whenever
+ * the DSP writes to RAM. Call after SCSP_Init().
+ */
+void SCSP_SetRAMDirtyMap(int n, Util::DirtyPageMap *dirty);
 void SCSP_RTECheck();
 int SCSP_IRQCB(int);
 
@@ -27,6 +27,7 @@
  
 #include "Supermodel.h"
 #include "SCSPDSP.h"
+#include "Util/DirtyPageMap.h"
 //#include <assert.h>
 #define assert(x)	;	// disable assert() for releases
 //#include <memory.h>
@@ -425,6 +426,8 @@ void SCSPDSP_Step(_SCSPDSP *DSP)
 			}
 			if (MWT && (step & 1))
 			{
+				if (DSP->SCSPRAMDirty)
+					DSP->SCSPRAMDirty->Mark(ADDR * 2);
 				if (NOFL)
 					DSP->SCSPRAM[ADDR] = SHIFTED >> 8;
 				else
@@ -31,6 +31,11 @@
 
 #include "Types.h"
 
+namespace Util
+{
+  class DirtyPageMap;
+}
+
 //#define DYNDSP
 
 //the DSP Context
@@ -39,6 +44,7 @@ struct _SCSPDSP
 //Config
 	UINT16 *SCSPRAM;
 	UINT32 SCSPRAM_LENGTH;
+	Util::DirtyPageMap *SCSPRAMDirty;	//pages of SCSPRAM written (may be NULL)
 	unsigned int RBP;	//Ring buf pointer
 	unsigned int RBL;	//Delay ram (Ring buffer) size in words
 
@@ -0,0 +1,48 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef INCLUDED_CRC32_H
+#define INCLUDED_CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Util
+{
+  /*
+   * CRC32(crc, data, size):
+   *
+   * Updates a running CRC-32 (the zip/zlib polynomial). Drop-in replacement
+   * for zlib's crc32() that folds with carry-less multiplication when the CPU
+   * supports it, for verifying large ROM images.
+   *
+   * Parameters:
+   *    crc   CRC of the preceding data, 0 to start.
+   *    data  Data to checksum.
+   *    size  Size in bytes.
+   *
+   * Returns:
+   *    Updated CRC.
+   */
+  uint32_t CRC32(uint32_t crc, const uint8_t *data, size_t size);
+} // Util
+
+#endif  // INCLUDED_CRC32_H
@@ -0,0 +1,111 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+/*
+ * DirtyPageMap.h
+ *
+ * Page-granular write tracking for large emulated memory regions.
+ */
+
+#ifndef INCLUDED_DIRTYPAGEMAP_H
+#define INCLUDED_DIRTYPAGEMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Util
+{
+  /*
+   * One bit per 4KB page of a memory region, set whenever the region is
+   * written to and cleared by the single consumer interested in changes since
+   * its last look (the rewind buffer). The layout matches the dirty page arrays
+   * of CReal3D, so those can be merged in directly. A new map starts with every
+   * page dirty.
+   */
+  class DirtyPageMap
+  {
+  public:
+    static const unsigned PageWidth = 12;
+    static const size_t PageSize = size_t(1) << PageWidth;
+
+    void Resize(size_t regionSize)
+    {
+      m_regionSize = regionSize;
+      m_bits.assign((NumPages() + 7) / 8, 0xFF);
+    }
+
+    size_t RegionSize() const
+    {
+      return m_regionSize;
+    }
+
+    size_t NumPages() const
+    {
+      return (m_regionSize + PageSize - 1) / PageSize;
+    }
+
+    // Called on every write, so there is no bounds checking
+    void Mark(uint32_t offset)
+    {
+      m_bits[offset >> (PageWidth + 3)] |= uint8_t(1 << ((offset >> PageWidth) & 7));
+    }
+
+    void MarkRange(size_t offset, size_t size)
+    {
+      if (size == 0)
+        return;
+      for (size_t page = offset >> PageWidth; page <= (offset + size - 1) >> PageWidth; page++)
+        m_bits[page >> 3] |= uint8_t(1 << (page & 7));
+    }
+
+    void MarkAll()
+    {
+      std::memset(m_bits.data(), 0xFF, m_bits.size());
+    }
+
+    // ORs in a bitmap of the same layout covering the pages from offset on,
+    // which must be a multiple of 8 pages
+    void Merge(size_t offset, const uint8_t *bits, size_t numBytes)
+    {
+      uint8_t *dest = &m_bits[offset >> (PageWidth + 3)];
+      for (size_t i = 0; i < numBytes; i++)
+        dest[i] |= bits[i];
+    }
+
+    bool IsDirty(size_t page) const
+    {
+      return (m_bits[page >> 3] >> (page & 7)) & 1;
+    }
+
+    void Clear()
+    {
+      std::memset(m_bits.data(), 0, m_bits.size());
+    }
+
+  private:
+    size_t m_regionSize = 0;
+    std::vector<uint8_t> m_bits;
+  };
+} // Util
+
+#endif  // INCLUDED_DIRTYPAGEMAP_H
@@ -0,0 +1,128 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "Util/MappedFile.h"
+#include <cstdio>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Util
+{
+  MappedFile::~MappedFile()
+  {
+    Close();
+  }
+
+  bool MappedFile::Open(const std::string &filename)
+  {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+      LARGE_INTEGER size;
+      if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && uint64_t(size.QuadPart) <= SIZE_MAX)
+      {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+          m_data = reinterpret_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+          CloseHandle(mapping); // the view keeps the mapping alive
+          if (m_data)
+          {
+            m_size = size_t(size.QuadPart);
+            m_mapped = true;
+          }
+        }
+      }
+      CloseHandle(file);
+      if (m_mapped)
+        return true;
+    }
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+        void *p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED)
+        {
+          m_data = reinterpret_cast<const uint8_t *>(p);
+          m_size = size_t(st.st_size);
+          m_mapped = true;
+        }
+      }
+      close(fd);  // the mapping keeps the file open
+      if (m_mapped)
+        return true;
+    }
+#endif
+
+    // Read it in
+    FILE *fp = fopen(filename.c_str(), "rb");
+    if (!fp)
+      return false;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    bool ok = size >= 0;
+    if (ok && size > 0)
+    {
+      m_buffer.resize(size_t(size));
+      ok = fread(m_buffer.data(), m_buffer.size(), 1, fp) == 1;
+    }
+    fclose(fp);
+    if (!ok)
+    {
+      m_buffer.clear();
+      return false;
+    }
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+  }
+
+  void MappedFile::Close()
+  {
+    if (m_mapped)
+    {
+#ifdef _WIN32
+      UnmapViewOfFile(m_data);
+#else
+      munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+    }
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+  }
+} // Util
@@ -0,0 +1,67 @@
+/**
+ ** Supermodel
+ ** A Sega Model 3 Arcade Emulator.
+ ** Copyright 2003-2026 The Supermodel Team
+ **
+ ** This file is part of Supermodel.
+ **
+ ** Supermodel is free software: you can redistribute it and/or modify it under
+ ** the terms of the GNU General Public License as published by the Free
+ ** Software Foundation, either version 3 of the License, or (at your option)
+ ** any later version.
+ **
+ ** Supermodel is distributed in the hope that it will be useful, but WITHOUT
+ ** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ ** FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ ** more details.
+ **
+ ** You should have received a copy of the GNU General Public License along
+ ** with Supermodel.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef INCLUDED_MAPPEDFILE_H
+#define INCLUDED_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Util
+{
+  /*
+   * Read-only view of an entire file. The file is memory mapped where
+   * possible so that only the parts actually touched get read, and read into
+   * memory otherwise.
+   */
+  class MappedFile
+  {
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    // Returns true on success
+    bool Open(const std::string &filename);
+    void Close();
+
+    const uint8_t *Data() const
+    {
+      return m_data;
+    }
+
+    size_t Size() const
+    {
+      return m_size;
+    }
+
+  private:
+    const uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+    std::vector<uint8_t> m_buffer;  // fallback when mapping is not possible
+  };
+} // Util
+
+#endif  // INCLUDED_MAPPEDFILE_H
@@ -158,6 +158,22 @@
  * Section3. It will be set to "bar" in Section4, Section5, and the "Global"
  * section because of the unnamed element.
  *
+ * Cached Access
+ * -------------
+ *
+ * Every lookup by path splits the path and walks the child maps. Code that
+ * runs every frame should instead create a Handle<T> once and read it with
+ * Value(). Each node carries a revision counter that SetValue() and Clear()
+ * increment, which lets handles notice when a setting has been changed (by
+ * the GUI or a hotkey) and convert the value again only then:
+ *
+ *    Util::Config::Handle<bool> throttle(config, "Throttle");
+ *    ...
+ *    if (throttle.Value())
+ *
+ * In DEBUG builds, lookups made on a thread inside a FrameScope (i.e., while
+ * emulating a frame) are logged once per path.
+ *
  * TODO
  * ----
  * - TryGet() can be made quicker by attempting a direct lookup first. We never
@@ -168,6 +184,11 @@
  */
 
 #include "Util/NewConfig.h"
+#ifdef DEBUG
+#include "OSD/Logger.h"
+#include <mutex>
+#include <set>
+#endif
 #include <iostream>
 
 namespace Util
@@ -194,8 +215,38 @@ namespace Util
       return it->second;
     }
 
+#ifdef DEBUG
+    static thread_local int s_frameScopeDepth = 0;
+
+    FrameScope::FrameScope()
+    {
+      ++s_frameScopeDepth;
+    }
+
+    FrameScope::~FrameScope()
+    {
+      --s_frameScopeDepth;
+    }
+
+    void Node::CheckLookup(const std::string &path) const
+    {
+      if (s_frameScopeDepth == 0)
+        return;
+      static std::mutex mtx;
+      static std::set<std::string> reported;
+      std::lock_guard<std::mutex> lock(mtx);
+      if (reported.insert(path).second)
+        ErrorLog("Config lookup of \"%s\" while emulating a frame. Use a Util::Config::Handle instead.", path.c_str());
+    }
+#else
+    void Node::CheckLookup(const std::string &) const
+    {
+    }
+#endif
+
     Node &Node::operator[](const std::string &path)
     {
+      CheckLookup(path);
        Node *e = this;
       std::vector<std::string> keys = Util::Format(path).Split('/');
       for (auto &key: keys)
@@ -231,6 +282,7 @@ namespace Util
 
     Node *Node::TryGet(const std::string &path)
     {
+      CheckLookup(path);
       Node *e = this;
       std::vector<std::string> keys = Util::Format(path).Split('/');
       for (auto &key: keys)
@@ -245,6 +297,7 @@ namespace Util
 
     const Node *Node::TryGet(const std::string &path) const
     {
+      CheckLookup(path);
       const Node *e = this;
       std::vector<std::string> keys = Util::Format(path).Split('/');
       for (auto &key: keys)
@@ -331,6 +384,7 @@ namespace Util
       *const_cast<std::string *>(&m_key) = that.m_key;
       if (that.m_value)
         m_value = that.m_value->MakeCopy();
+      ValueChanged();
       for (ptr_t child = that.m_first_child; child; child = child->m_next_sibling)
       {
         ptr_t copied_child = std::make_shared<Node>(*child);
@@ -346,6 +400,8 @@ namespace Util
       m_children.swap(rhs.m_children);
      const_cast<std::string *>(&m_key)->swap(*const_cast<std::string *>(&rhs.m_key));
       m_value.swap(rhs.m_value);
+      ValueChanged();
+      rhs.ValueChanged();
     }
 
     Node &Node::operator=(const Node &rhs)
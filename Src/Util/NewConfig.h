@@ -27,6 +27,8 @@
 #include <memory>
 #include <exception>
 #include <iterator>
+#include <atomic>
+#include <cstdint>
 
 namespace Util
 {
@@ -45,6 +47,7 @@ namespace Util
       std::map<std::string, ptr_t> m_children;
       mutable std::map<std::string, Node> m_missing_nodes;  // missing nodes from failed queries (must also be empty)
       bool m_missing = false;
+      std::atomic<uint32_t> m_revision{0};  // incremented whenever the value changes
 
       void Destroy()
       {
@@ -61,8 +64,14 @@ namespace Util
       void AddChild(Node &parent, ptr_t &node);
       void DeepCopy(const Node &that);
       void Swap(Node &rhs);
+      void CheckLookup(const std::string &path) const;
       Node(); // prohibit accidental/unintentional creation of empty nodes
 
+      inline void ValueChanged()
+      {
+        m_revision.fetch_add(1, std::memory_order_release);
+      }
+
     public:
 
       template <typename T>
@@ -113,14 +122,22 @@ namespace Util
         return m_value;
       }
 
+      // Changes each time the value is set or cleared
+      inline uint32_t Revision() const
+      {
+        return m_revision.load(std::memory_order_acquire);
+      }
+
       inline void Clear()
       {
         m_value = nullptr;
+        ValueChanged();
       }
 
       inline void SetValue(const std::shared_ptr<GenericValue> &value)
       {
         m_value = value;
+        ValueChanged();
       }
 
       template <typename T>
@@ -155,6 +172,7 @@ namespace Util
             m_value->Set(value);
           else
             m_value = std::make_shared<ValueInstance<T>>(value);
+          ValueChanged();
         }
         else
           throw std::range_error(Util::Format() << "Node \"" << m_key << "\" does not exist");
@@ -277,6 +295,81 @@ namespace Util
       ~Node();
     };
 
+    /*
+     * Handle<T>:
+     *
+     * Typed, cached access to a single setting for code that runs every frame.
+     * The path is looked up once, when the handle is created. Reading the value
+     * afterwards only compares the node's revision and converts the stored
+     * value again after it has been changed (by the GUI or a hotkey, for
+     * example), so no strings are split or compared.
+     *
+     * The node must outlive the handle. Missing nodes behave as with
+     * operator[]: Value() throws, unless a default value was given, which is
+     * then returned as with ValueAsDefault().
+     */
+    template <typename T>
+    class Handle
+    {
+    public:
+      const T &Value() const
+      {
+        uint32_t revision = m_node->Revision();
+        if (revision != m_revision)
+        {
+          m_value = m_hasDefault ? m_node->ValueAsDefault<T>(m_default) : m_node->ValueAs<T>();
+          m_revision = revision;
+        }
+        return m_value;
+      }
+
+      // True if the value has changed since it was last read
+      bool Changed() const
+      {
+        return m_node->Revision() != m_revision;
+      }
+
+      Handle(const Node &config, const std::string &path)
+        : m_node(&config[path]),
+          m_revision(m_node->Revision() - 1)  // convert on first read
+      {
+      }
+
+      Handle(const Node &config, const std::string &path, const T &default_value)
+        : m_node(&config[path]),
+          m_revision(m_node->Revision() - 1),
+          m_default(default_value),
+          m_hasDefault(true)
+      {
+      }
+
+    private:
+      const Node *m_node;
+      mutable uint32_t m_revision;
+      mutable T m_value = T();
+      T m_default = T();
+      bool m_hasDefault = false;
+    };
+
+    /*
+     * FrameScope:
+     *
+     * Marks the current thread as emulating a frame. In DEBUG builds, path
+     * lookups (operator[], Get(), TryGet()) made inside a scope are reported
+     * once per path, as they should be replaced with a Handle. Compiles to
+     * nothing otherwise.
+     */
+    class FrameScope
+    {
+    public:
+#ifdef DEBUG
+      FrameScope();
+      ~FrameScope();
+#else
+      FrameScope() {}
+#endif
+    };
+
     void PrintConfigTree(const Node &config, int indent_level = 0, int tab_stops = 2);
   } // Config
 } // Util